@@ -8,20 +8,40 @@
 #include "buzzer.h"
 #include "battery.h"
 #include "servo_control.h"
+#include "tlog.h"
+#include "mission_kpi.h"
+#include "button_handler.h"
 
 extern HardwareSerial Serial2;  // UART2 → STM32 (begin trong main.cpp)
 
 // ── helpers: send route to STM32 ────────────────────────────────────
-static void sendRouteToSTM32() {
-    // CMD 0x02  [count][id_hi id_lo action] × N
+// `from` > 0 sends only the remaining points (resume after STM32 reset)
+static void sendRouteToSTM32(uint8_t from = 0) {
     uint8_t buf[1 + MAX_ROUTE_LEN * 3];
-    buf[0] = g_routeLen;
-    for (uint8_t i = 0; i < g_routeLen; i++) {
-        buf[1 + i * 3]     = (g_route[i].checkpointId >> 8) & 0xFF;
-        buf[1 + i * 3 + 1] = g_route[i].checkpointId & 0xFF;
-        buf[1 + i * 3 + 2] = g_route[i].action;
+    uint8_t n = (from < g_routeLen) ? g_routeLen - from : 0;
+
+    // CMD 0x0F  [count][idx radius speed] × N – always sent, clears old arcs
+    uint8_t arcs = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        const RoutePoint &p = g_route[from + i];
+        if (!p.arcRadius && !p.arcSpeed) continue;
+        buf[1 + arcs * 3]     = i;
+        buf[1 + arcs * 3 + 1] = p.arcRadius;
+        buf[1 + arcs * 3 + 2] = p.arcSpeed;
+        arcs++;
+    }
+    buf[0] = arcs;
+    uartSendFrame(Serial2, CMD_ROUTE_ARCS, buf, 1 + arcs * 3);
+
+    // CMD 0x02  [count][id_hi id_lo action] × N
+    buf[0] = n;
+    for (uint8_t i = 0; i < n; i++) {
+        const RoutePoint &p = g_route[from + i];
+        buf[1 + i * 3]     = (p.checkpointId >> 8) & 0xFF;
+        buf[1 + i * 3 + 1] = p.checkpointId & 0xFF;
+        buf[1 + i * 3 + 2] = p.action;
     }
-    uartSendFrame(Serial2, CMD_SEND_ROUTE, buf, 1 + g_routeLen * 3);
+    uartSendFrame(Serial2, CMD_SEND_ROUTE, buf, 1 + n * 3);
 }
 
 static void sendCancelToSTM32() {
@@ -41,15 +61,81 @@ void autoModeInit() {
     g_autoState = AUTO_IDLE;
     g_routeLen  = 0;
     g_routeIdx  = 0;
+    g_routeEvents.clear();
     servoSetX(SERVO_X_CENTER);  // 100
     servoSetY(SERVO_Y_LEVEL);   // 100
     oledIdle();
-    Serial.println("[AUTO] init");
+    LOGI(LM_AUTO, "init");
+}
+
+// ── STM32 reset (brown-out) while a route was active ────────────────
+// Resume from the STM32's persisted progress when it matches our route,
+// otherwise hand it the remaining points from our own copy.
+void autoModeStm32Reset(bool resumable, uint8_t len, uint8_t idx) {
+    bool running = (g_autoState == AUTO_RUNNING || g_autoState == AUTO_RETURNING);
+    if (!running) {
+        if (resumable) sendCancelToSTM32();   // stale mission in STM32 flash
+        return;
+    }
+
+    if (resumable && len == g_routeLen) {
+        g_routeIdx = idx;                     // STM32 progress is authoritative
+        uartSendFrame(Serial2, CMD_RESUME_MISSION, nullptr, 0);
+        LOGI(LM_AUTO, "STM32 reset → resume at %u/%u", idx, len);
+    } else {
+        sendRouteToSTM32(g_routeIdx);
+        LOGI(LM_AUTO, "STM32 reset → resend from %u/%u", g_routeIdx, g_routeLen);
+    }
+    g_routeEvents.clear();                    // progress of the old STM32 run
+    mqttPublishEvent("stm32_resumed");
+}
+
+// ── MQTT cancel / pre-empt (control task, before autoModeLoop) ──────
+void autoModeCommand(const CmdEvent &ev) {
+    if (g_mode != MODE_AUTO) return;
+
+    if (ev.type == CMD_EV_PREEMPT) {
+        // new route already stored, state is WAIT_START – stop the old one
+        sendCancelToSTM32();
+        LOGI(LM_AUTO, "new route while running → cancel old");
+        return;
+    }
+    if (ev.type != CMD_EV_CANCEL) return;
+
+    if (g_autoState == AUTO_WAIT_START) {
+        sendCancelToSTM32();
+        g_routeLen = 0;
+        g_routeIdx = 0;
+        g_autoState = AUTO_IDLE;
+        oledIdle();
+        LOGI(LM_AUTO, "MQTT cancel (before start) → IDLE");
+    } else if (g_autoState == AUTO_RUNNING) {
+        sendCancelToSTM32();
+        // STM32 will read NFC and report checkpoint after cancel
+        // wait briefly for checkpoint report, then request return route
+        g_autoState = AUTO_WAIT_RETURN_ROUTE;
+        oledRecovery("Cancelled - waiting...");
+        LOGI(LM_AUTO, "MQTT cancel → CMD 0x05, waiting for CP");
+    }
+}
+
+// ── route progress (shared by RUNNING and RETURNING) ────────────────
+static void onProgress(const RouteEvent &ev) {
+    if (ev.type == EV_SKIPPED) {
+        // checkpoints the STM32 passed without reading (look-ahead match)
+        g_routeIdx += ev.n;
+    } else if (ev.type == EV_CHECKPOINT) {
+        g_routeIdx++;
+        kpiCheckpoint(ev.id);
+        mqttPublishCheckpoint(ev.id);
+        LOGI(LM_AUTO, "CP %u  (%u/%u)", ev.id, g_routeIdx, g_routeLen);
+    }
 }
 
 void autoModeLoop() {
     static uint32_t lastOled = 0;
     uint32_t now = millis();
+    RouteEvent ev;
 
     switch (g_autoState) {
 
@@ -59,11 +145,14 @@ void autoModeLoop() {
             oledIdle(); lastOled = now;
         }
         // idle NFC scan → publish to dashboard (without setting busy)
-        if (g_newCheckpoint) {
-            g_newCheckpoint = false;
-            mqttPublishIdleScan(g_lastCheckpointId);
-            Serial.printf("[AUTO] idle scan CP %u\n", g_lastCheckpointId);
+        while (g_routeEvents.pop(ev)) {
+            if (ev.type != EV_CHECKPOINT) continue;
+            mqttPublishIdleScan(ev.id);
+            LOGI(LM_AUTO, "idle scan CP %u", ev.id);
         }
+        // parked at MED: power the vision rail ahead of an Auto → Follow switch
+        relayPrewarmVision(POWER_PREWARM_AT_MED &&
+                           g_lastCheckpointId == MED_CHECKPOINT_ID);
         // transition to WAIT_START is done by MQTT callback
         break;
 
@@ -73,77 +162,49 @@ void autoModeLoop() {
             oledAutoWaitStart(g_patientName, g_destination, g_routeLen);
             lastOled = now;
         }
-        if (g_mqttCancel) {
-            g_mqttCancel = false;
-            sendCancelToSTM32();
-            g_routeLen = 0;
-            g_routeIdx = 0;
-            g_autoState = AUTO_IDLE;
-            oledIdle();
-            Serial.println("[AUTO] MQTT cancel (before start) → IDLE");
-            break;
-        }
-        if (g_btnSingleClick) {
-            g_btnSingleClick = false;
+        g_routeEvents.clear();      // robot parked – nothing belongs to this route yet
+        if (buttonTake(BTN_SINGLE)) {
             // tạm tắt kiểm tra pin
             // if (!batteryOk()) {
             //     oledBatteryLow(g_batteryPercent);
             //     buzzerBeepN(3);
             //     break;
             // }
+            relayPrewarmVision(false);
             sendRouteToSTM32();
+            kpiMissionStart();
+            kpiRunStart();
             g_autoState = AUTO_RUNNING;
             g_routeIdx  = 0;
             buzzerBeep(80);
-            Serial.println("[AUTO] started");
+            LOGI(LM_AUTO, "started");
         }
         break;
 
     // ── RUNNING: STM32 executing route ──────────────────────────────
     case AUTO_RUNNING:
-        if (g_mqttCancel) {
-            g_mqttCancel = false;
-            sendCancelToSTM32();
-            // STM32 will read NFC and report checkpoint after cancel
-            // wait briefly for checkpoint report, then request return route
-            g_autoState = AUTO_WAIT_RETURN_ROUTE;
-            oledRecovery("Cancelled - waiting...");
-            Serial.println("[AUTO] MQTT cancel → CMD 0x05, waiting for CP");
-            break;
-        }
-
-        // if new route arrived while running (g_autoState set to WAIT_START by MQTT cb)
-        if (g_autoState == AUTO_WAIT_START) {
-            // MQTT callback already sent cancel and set new route
-            sendCancelToSTM32();
-            Serial.println("[AUTO] new route while running → cancel old");
-            break;
-        }
+        // cancel / new route: autoModeCommand()
 
-        // checkpoint reported by STM32
-        if (g_newCheckpoint) {
-            g_newCheckpoint = false;
-            g_routeIdx++;
-            mqttPublishCheckpoint(g_lastCheckpointId);
-            Serial.printf("[AUTO] CP %u  (%u/%u)\n",
-                          g_lastCheckpointId, g_routeIdx, g_routeLen);
+        // STM32 progress in arrival order; stop at mission done
+        while (g_autoState == AUTO_RUNNING && g_routeEvents.pop(ev)) {
+            if (ev.type == EV_MISSION_DONE) {
+                g_autoState = AUTO_WAIT_RETURN_BTN;
+                buzzerBeepN(2, 120, 80);
+                LOGI(LM_AUTO, "arrived at destination");
+            } else if (ev.type == EV_MISMATCH) {
+                LOGW(LM_AUTO, "mismatch! got=%u exp=%u", ev.id, ev.exp);
+            } else {
+                onProgress(ev);
+            }
         }
+        if (g_autoState != AUTO_RUNNING) break;
 
         // STM32 obstacle flag (display)
-        if (g_stm32Obstacle) {
-            oledObstacle();
-        } else if (now - lastOled > OLED_UPDATE_MS) {
-            oledAutoRunning(g_routeIdx, g_routeLen, g_destination);
+        if (now - lastOled > OLED_UPDATE_MS) {
+            if (g_stm32Obstacle) oledObstacle();
+            else                 oledAutoRunning(g_routeIdx, g_routeLen, g_destination);
             lastOled = now;
         }
-
-        // mission done reported by STM32
-        if (g_stm32MissionDone) {
-            g_stm32MissionDone = false;
-            g_autoState = AUTO_WAIT_RETURN_BTN;
-            buzzerBeepN(2, 120, 80);
-            Serial.println("[AUTO] arrived at destination");
-        }
         break;
 
     // ── AT DESTINATION: wait button to request return ───────────────
@@ -151,11 +212,11 @@ void autoModeLoop() {
         if (now - lastOled > OLED_UPDATE_MS) {
             oledAutoWaitReturn(); lastOled = now;
         }
-        if (g_btnSingleClick) {
-            g_btnSingleClick = false;
+        g_routeEvents.clear();
+        if (buttonTake(BTN_SINGLE)) {
             mqttPublishReturnRequest(g_lastCheckpointId);
             g_autoState = AUTO_WAIT_RETURN_ROUTE;
-            Serial.println("[AUTO] requesting return route");
+            LOGI(LM_AUTO, "requesting return route");
         }
         break;
 
@@ -166,10 +227,10 @@ void autoModeLoop() {
             lastOled = now;
         }
         // checkpoint from STM32 after cancel → publish return request
-        if (g_newCheckpoint) {
-            g_newCheckpoint = false;
-            mqttPublishReturnRequest(g_lastCheckpointId);
-            Serial.printf("[AUTO] CP %u → return_request\n", g_lastCheckpointId);
+        while (g_routeEvents.pop(ev)) {
+            if (ev.type != EV_CHECKPOINT) continue;
+            mqttPublishReturnRequest(ev.id);
+            LOGI(LM_AUTO, "CP %u → return_request", ev.id);
         }
         // MQTT callback sets AUTO_RETURNING when return_route arrives
         break;
@@ -180,37 +241,31 @@ void autoModeLoop() {
         {
             static bool returnSent = false;
             if (!returnSent) {
+                g_routeEvents.clear();      // belongs to the previous run
                 sendRouteToSTM32();
+                kpiRunStart();
                 g_routeIdx = 0;
                 returnSent = true;
             }
 
-            if (g_newCheckpoint) {
-                g_newCheckpoint = false;
-                g_routeIdx++;
-                mqttPublishCheckpoint(g_lastCheckpointId);
+            while (returnSent && g_routeEvents.pop(ev)) {
+                if (ev.type == EV_MISSION_DONE) {
+                    g_autoState = AUTO_COMPLETE;
+                    returnSent = false;
+                } else if (ev.type == EV_MISMATCH) {
+                    LOGW(LM_AUTO, "mismatch! got=%u exp=%u", ev.id, ev.exp);
+                    // request new return route from current position
+                    mqttPublishReturnRequest(ev.id);
+                    returnSent = false;
+                } else {
+                    onProgress(ev);
+                }
             }
 
             if (now - lastOled > OLED_UPDATE_MS) {
                 oledAutoReturning(g_routeIdx, g_routeLen);
                 lastOled = now;
             }
-
-            if (g_stm32MissionDone) {
-                g_stm32MissionDone = false;
-                g_autoState = AUTO_COMPLETE;
-                returnSent = false;
-            }
-
-            // mismatch handling
-            if (g_stm32MismatchFlag) {
-                g_stm32MismatchFlag = false;
-                Serial.printf("[AUTO] mismatch! got=%u exp=%u\n",
-                              g_stm32MismatchGot, g_stm32MismatchExp);
-                // request new return route from current position
-                mqttPublishReturnRequest(g_stm32MismatchGot);
-                returnSent = false;
-            }
         }
         break;
 
@@ -221,7 +276,7 @@ void autoModeLoop() {
         g_autoState = AUTO_IDLE;
         g_routeLen  = 0;
         oledIdle();
-        Serial.println("[AUTO] mission complete, back to IDLE");
+        LOGI(LM_AUTO, "mission complete, back to IDLE");
         break;
     }
 }
@@ -1,5 +1,8 @@
 #pragma once
 #include <Arduino.h>
+#include "events.h"
 
 void autoModeInit();
 void autoModeLoop();   // call from main loop
+void autoModeCommand(const CmdEvent &ev);   // CMD_EV_CANCEL / CMD_EV_PREEMPT
+void autoModeStm32Reset(bool resumable, uint8_t len, uint8_t idx);   // STM32 boot frame
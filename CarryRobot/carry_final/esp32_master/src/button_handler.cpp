@@ -1,5 +1,6 @@
 #include "button_handler.h"
 #include "globals.h"
+#include "events.h"
 
 static bool     lastStable   = HIGH;
 static bool     lastRaw      = HIGH;
@@ -8,6 +9,7 @@ static uint32_t releaseTime  = 0;
 static uint32_t pressTime    = 0;
 static uint8_t  clickCount   = 0;
 static bool     longFired    = false;
+static BtnGesture s_current  = BTN_NONE;   // this control tick's gesture
 
 void buttonInit() {
     pinMode(PIN_BUTTON, INPUT_PULLUP);   // GPIO15 with internal pull-up
@@ -33,7 +35,7 @@ void buttonLoop() {
     if (stable == LOW && !longFired && (now - pressTime) >= BTN_LONG_MS) {
         longFired = true;
         clickCount = 0;   // discard any pending click
-        g_btnLongPress = true;
+        g_btnEvents.push(BTN_LONG);
     }
 
     // release edge → count click (skip if long press fired)
@@ -46,13 +48,22 @@ void buttonLoop() {
 
     // evaluate clicks after double-click window
     if (clickCount > 0 && stable == HIGH && (now - releaseTime) > BTN_DOUBLE_MS) {
-        if (clickCount >= 2) {
-            g_btnDoubleClick = true;
-        } else {
-            g_btnSingleClick = true;
-        }
+        g_btnEvents.push(clickCount >= 2 ? BTN_DOUBLE : BTN_SINGLE);
         clickCount = 0;
     }
 
     lastStable = stable;
 }
+
+// ── one gesture per control tick ────────────────────────────────────
+// A gesture nobody takes during its tick is dropped, so a click in one
+// state cannot fire later in another.
+void buttonNextGesture() {
+    if (!g_btnEvents.pop(s_current)) s_current = BTN_NONE;
+}
+
+bool buttonTake(BtnGesture g) {
+    if (s_current != g) return false;
+    s_current = BTN_NONE;
+    return true;
+}
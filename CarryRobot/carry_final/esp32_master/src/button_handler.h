@@ -1,6 +1,9 @@
 #pragma once
 #include <Arduino.h>
 #include "config.h"
+#include "events.h"
 
 void buttonInit();
-void buttonLoop();   // call from main loop – updates g_btnSingleClick etc.
+void buttonLoop();          // call from main loop – pushes gestures to g_btnEvents
+void buttonNextGesture();   // control tick start: pop the next gesture
+bool buttonTake(BtnGesture g);   // true (once) if this tick's gesture is g
@@ -1,33 +1,150 @@
 #include "buzzer.h"
+#include "esp_timer.h"
 
 #define BUZZER_CHANNEL 0
 #define BUZZER_FREQ    2000
 
+struct BuzzPattern {
+    BuzzStep step[BUZZ_MAX_STEPS];
+    uint8_t  n;
+    BuzzPrio prio;
+};
+
+// ── sequencer state (s_mux) ─────────────────────────────────────────
+// Callers only edit the queue; LEDC is driven from onTimer() alone.
+// kick() fires the timer now – used to start from idle and to preempt.
+static esp_timer_handle_t s_timer = nullptr;
+static portMUX_TYPE s_mux      = portMUX_INITIALIZER_UNLOCKED;
+static BuzzPattern  s_cur;
+static uint8_t      s_step     = 0;
+static bool         s_playing  = false;
+static bool         s_kicked   = false;    // timer restarted, callback pending
+static bool         s_preempt  = false;    // drop s_cur on next callback
+static BuzzPattern  s_queue[BUZZER_QUEUE_LEN];
+static uint8_t      s_queued   = 0;
+
+static void kick() {
+    esp_timer_stop(s_timer);
+    esp_timer_start_once(s_timer, 0);
+}
+
+static bool samePattern(const BuzzPattern &a, const BuzzPattern &b) {
+    return a.n == b.n && a.prio == b.prio &&
+           memcmp(a.step, b.step, a.n * sizeof(BuzzStep)) == 0;
+}
+
+// highest priority, oldest first
+static bool takeNext(BuzzPattern &out) {
+    if (!s_queued) return false;
+    uint8_t best = 0;
+    for (uint8_t i = 1; i < s_queued; i++)
+        if (s_queue[i].prio > s_queue[best].prio) best = i;
+    out = s_queue[best];
+    for (uint8_t i = best; i + 1 < s_queued; i++) s_queue[i] = s_queue[i + 1];
+    s_queued--;
+    return true;
+}
+
+// ── esp_timer task: advance one step ────────────────────────────────
+static void onTimer(void *) {
+    BuzzStep out = { 0, 0 };
+    bool     on;
+
+    portENTER_CRITICAL(&s_mux);
+    s_kicked = false;
+    if (s_preempt) {
+        s_preempt = false;
+        s_playing = false;
+    }
+    if (s_playing) s_step++;
+    if (!s_playing || s_step >= s_cur.n) {
+        s_playing = takeNext(s_cur);
+        s_step    = 0;
+    }
+    on = s_playing;
+    if (on) out = s_cur.step[s_step];
+    portEXIT_CRITICAL(&s_mux);
+
+    if (out.freq) ledcWriteTone(BUZZER_CHANNEL, out.freq);
+    else          ledcWrite(BUZZER_CHANNEL, 0);
+    if (on) esp_timer_start_once(s_timer, (uint64_t)out.ms * 1000);
+}
+
+// ── public API (any task) ───────────────────────────────────────────
 void buzzerInit() {
     ledcSetup(BUZZER_CHANNEL, BUZZER_FREQ, 8);
     ledcAttachPin(PIN_BUZZER, BUZZER_CHANNEL);
     ledcWrite(BUZZER_CHANNEL, 0);
+
+    esp_timer_create_args_t args = {};
+    args.callback        = onTimer;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name            = "buzzer";
+    esp_timer_create(&args, &s_timer);
 }
 
-void buzzerBeep(uint16_t ms) {
-    ledcWriteTone(BUZZER_CHANNEL, BUZZER_FREQ);
-    delay(ms);
-    ledcWrite(BUZZER_CHANNEL, 0);
+bool buzzerPlay(const BuzzStep *steps, uint8_t n, BuzzPrio prio) {
+    if (!s_timer || !n) return false;
+    BuzzPattern p;
+    p.n    = n < BUZZ_MAX_STEPS ? n : BUZZ_MAX_STEPS;
+    p.prio = prio;
+    memcpy(p.step, steps, p.n * sizeof(BuzzStep));
+
+    bool ok = true, doKick = false;
+    portENTER_CRITICAL(&s_mux);
+    bool dup = s_playing && !s_preempt && samePattern(s_cur, p);
+    for (uint8_t i = 0; i < s_queued && !dup; i++) dup = samePattern(s_queue[i], p);
+
+    if (dup) {
+        // repeated warning (e.g. obstacle frames) – already sounding
+    } else if (s_queued >= BUZZER_QUEUE_LEN) {
+        ok = false;
+    } else {
+        s_queue[s_queued++] = p;
+        if (s_playing && !s_preempt && prio > s_cur.prio) {
+            s_preempt = true;
+            doKick    = true;
+        } else if (!s_playing && !s_kicked) {
+            doKick = true;
+        }
+        if (doKick) s_kicked = true;
+    }
+    portEXIT_CRITICAL(&s_mux);
+
+    if (doKick) kick();
+    return ok;
+}
+
+void buzzerBeep(uint16_t ms, BuzzPrio prio) {
+    BuzzStep s = { BUZZER_FREQ, ms };
+    buzzerPlay(&s, 1, prio);
 }
 
-void buzzerBeepN(uint8_t n, uint16_t onMs, uint16_t offMs) {
-    for (uint8_t i = 0; i < n; i++) {
-        buzzerBeep(onMs);
-        if (i < n - 1) delay(offMs);
+void buzzerBeepN(uint8_t n, uint16_t onMs, uint16_t offMs, BuzzPrio prio) {
+    BuzzStep s[BUZZ_MAX_STEPS];
+    uint8_t k = 0;
+    for (uint8_t i = 0; i < n && k < BUZZ_MAX_STEPS; i++) {
+        if (i) s[k++] = { 0, offMs };
+        if (k < BUZZ_MAX_STEPS) s[k++] = { BUZZER_FREQ, onMs };
     }
+    buzzerPlay(s, k, prio);
 }
 
-void buzzerTone(uint16_t freq, uint16_t ms) {
-    ledcWriteTone(BUZZER_CHANNEL, freq);
-    delay(ms);
-    ledcWrite(BUZZER_CHANNEL, 0);
+void buzzerTone(uint16_t freq, uint16_t ms, BuzzPrio prio) {
+    BuzzStep s = { freq, ms };
+    buzzerPlay(&s, 1, prio);
 }
 
 void buzzerOff() {
-    ledcWrite(BUZZER_CHANNEL, 0);
+    if (!s_timer) return;
+    bool doKick;
+    portENTER_CRITICAL(&s_mux);
+    s_queued = 0;
+    doKick   = s_playing && !s_preempt;
+    if (doKick) {
+        s_preempt = true;
+        s_kicked  = true;
+    }
+    portEXIT_CRITICAL(&s_mux);
+    if (doKick) kick();
 }
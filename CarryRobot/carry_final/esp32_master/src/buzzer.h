@@ -2,8 +2,28 @@
 #include <Arduino.h>
 #include "config.h"
 
+// ── Non-blocking pattern sequencer ──────────────────────────────────
+// A pattern is a chain of tones (freq 0 = rest).  Calls return at once;
+// an esp_timer one-shot steps through the pattern on the timer task.
+// A higher-priority pattern cuts the playing one short, equal or lower
+// priorities wait in the queue (highest first, then FIFO).
+enum BuzzPrio : uint8_t {
+    BUZ_INFO,       // button / progress feedback
+    BUZ_WARN,       // rejected action, sensor failure, link lost
+    BUZ_ALARM       // obstacle, target lost
+};
+
+struct BuzzStep {
+    uint16_t freq;  // Hz, 0 = silence
+    uint16_t ms;
+};
+
+#define BUZZ_MAX_STEPS  12
+
 void buzzerInit();
-void buzzerBeep(uint16_t ms = 100);
-void buzzerBeepN(uint8_t n, uint16_t onMs = 100, uint16_t offMs = 100);
-void buzzerTone(uint16_t freq, uint16_t ms);
-void buzzerOff();            // silence immediately
+bool buzzerPlay(const BuzzStep *steps, uint8_t n, BuzzPrio prio = BUZ_INFO);
+void buzzerBeep(uint16_t ms = 100, BuzzPrio prio = BUZ_INFO);
+void buzzerBeepN(uint8_t n, uint16_t onMs = 100, uint16_t offMs = 100,
+                 BuzzPrio prio = BUZ_INFO);
+void buzzerTone(uint16_t freq, uint16_t ms, BuzzPrio prio = BUZ_INFO);
+void buzzerOff();            // silence immediately, drop queued patterns
@@ -11,7 +11,14 @@
 // ── HuskyLens (Serial1) ────────────────────────────────────────────
 #define PIN_HUSKY_TX        4         // ESP32 TX → HuskyLens RX
 #define PIN_HUSKY_RX        5         // ESP32 RX ← HuskyLens TX
-#define HUSKY_BAUD          9600
+#define HUSKY_BAUD          1000000   // camera menu: Protocol Type → Serial 1000000
+#define HUSKY_RX_BUF        512       // Serial1 RX buffer (set before begin)
+#define HUSKY_REPLY_MS      30        // request → last block, else counted as a fail
+#define HUSKY_MAX_BLOCKS    8         // blocks kept per frame (extra ones only counted)
+#define FOLLOW_TAG_ID       0         // tag ID Follow locks onto, 0 = first one seen
+#define HUSKY_CX            160       // image centre (320 × 240)
+#define HUSKY_CY            120
+#define HUSKY_FOCAL_PX      277.0f    // 160 / tan(HFOV / 2), calibrate per lens
 
 // ── Servo Gimbal ────────────────────────────────────────────────────
 #define PIN_SERVO_X         13        // PWM
@@ -31,11 +38,15 @@
 #define PIN_SR05_R_TRIG     32
 #define PIN_SR05_R_ECHO     33
 #define SR05_WALL_WARN_CM   30        // warning threshold  (cm)
-#define SR05_TIMEOUT_US     25000
+#define SR05_TIMEOUT_US     25000     // longer echo = nothing in range
+#define SR05_SLOT_MS        35        // one side fires per slot (echo + ring-down)
+#define SR05_MEDIAN         5         // samples in the per-side median window
+#define SR05_STALE_MS       300       // older reading reads as 0 (no echo)
 
 // ── OLED (SH1106 128×64, I²C) ──────────────────────────────────────
 #define PIN_OLED_SDA        21
 #define PIN_OLED_SCL        22
+#define OLED_I2C_HZ         400000    // fast mode, the SH1106 spec limit
 
 // ── Buzzer ──────────────────────────────────────────────────────────
 #define PIN_BUZZER          25
@@ -46,6 +57,10 @@
 #define BTN_DOUBLE_MS       400       // max gap for double-click
 #define BTN_LONG_MS         3000      // long-press → portal
 
+// ── Emergency stop line (optional, → STM32 PB10 EXTI) ──────────────
+#define USE_ESTOP_LINE      0         // 1 = also pull GPIO19 LOW on stop
+#define PIN_ESTOP_OUT       19
+
 // ── Relays (active HIGH = power ON) ─────────────────────────────────
 #define PIN_RELAY_VISION    18        // R1  HuskyLens + servo + SR05
 #define PIN_RELAY_LINE_NFC  23        // R2  Line sensors + PN532
@@ -74,14 +89,98 @@
 
 // ── Timing (ms) ─────────────────────────────────────────────────────
 #define OLED_UPDATE_MS      200
+#define OLED_FRAME_MS       100       // UI task: at most one panel update per frame
+#define OLED_REFRESH_MS     1000      // redraw an unchanged screen (status bar)
 #define TELEMETRY_MS        5000
 // #define BATTERY_READ_MS     5000
 #define HUSKY_POLL_MS       50
-#define SR05_POLL_MS        100
 #define UART_POLL_MS        2
+#define VEL_KEEPALIVE_MS    50        // re-send DIRECT_VEL (STM32 stops after 250 ms stale)
+#define STM32_TELEM_HZ      20        // CMD_TELEMETRY rate requested from STM32 (0 = off)
+#define STM32_TELEM_STALE_MS 500      // snapshot older than this is reported as invalid
+#define STM32_READY_POLL_MS  500      // resume waiting on CMD_READY: poll REG_PERIPH this often
+
+// ── FreeRTOS tasks ──────────────────────────────────────────────────
+// core 0: network (WiFi / lwIP live there too); core 1: the robot.
+// Stacks in bytes.  Periods are fixed rates (vTaskDelayUntil).
+#define NET_TASK_CORE       0
+#define NET_TASK_PRIO       2
+#define NET_TASK_STACK      10240     // WiFiManager portal runs here
+#define NET_TASK_MS         5
+#define LINK_TASK_CORE      1
+#define LINK_TASK_PRIO      5         // UART2 → link queue, never blocks
+#define LINK_TASK_STACK     3072
+#define LINK_TASK_MS        UART_POLL_MS
+#define CTRL_TASK_CORE      1
+#define CTRL_TASK_PRIO      4
+#define CTRL_TASK_STACK     8192
+#define CTRL_TASK_MS        20        // 50 Hz: modes, STM32 frames, MQTT commands
+#define SENSOR_TASK_CORE    1
+#define SENSOR_TASK_PRIO    3
+#define SENSOR_TASK_STACK   4096
+#define SENSOR_TASK_MS      10        // hub tick; each source keeps its own rate
+#define UI_TASK_CORE        1
+#define UI_TASK_PRIO        1
+#define UI_TASK_STACK       4096
+#define UI_TASK_MS          50        // max wait for a new OLED screen
+
+// ── Inter-task queues ───────────────────────────────────────────────
+#define LINK_QUEUE_LEN      32        // STM32 frames, link → control (power of 2)
+#define ROUTE_EVENT_LEN     16        // checkpoint / skipped / done / mismatch
+#define BTN_EVENT_LEN       8         // button gestures
+#define CMD_EVENT_LEN       8         // MQTT cancel / set_mode
+#define MQTT_RX_RING        8192      // bytes of T_CMD payloads, net → control
+#define MQTT_TX_RING        8192      // bytes of pending publishes, any → net
+#define BUZZER_QUEUE_LEN    8         // patterns waiting behind the one playing
+#define SENSOR_STALE_MS     250       // older HuskyLens/SR05/pan stamp = no sample
+#define SENSOR_PAN_MS       20        // servo X feedback ADC rate
+
+// ── Follow tracker (target_track) ───────────────────────────────────
+#define FOLLOW_TAG_CM       10.0f     // printed tag edge length
+#define FOLLOW_RANGE_CM     80        // ground distance Follow holds
+#define FOLLOW_CAM_LAT_MS   40        // camera capture → request (HuskyLens processing)
+#define FOLLOW_ACT_LAT_MS   60        // DIRECT_VEL → wheels moving (STM32 ramp)
+#define FOLLOW_COAST_MS     600       // predict through detection gaps this long
+#define FOLLOW_ALPHA        0.5f      // position correction per frame
+#define FOLLOW_BETA         0.15f     // velocity correction per frame
+#define FOLLOW_GATE_DEG     25.0f     // residual beyond this is an outlier
+#define FOLLOW_GATE_CM      80.0f
+#define FOLLOW_MAX_DEG_S    90.0f     // velocity clamps
+#define FOLLOW_MAX_CM_S     200.0f
+
+// ── Gimbal (follow / find) ──────────────────────────────────────────
+#define SERVO_X_DIR         1         // +1: larger servo X angle pans right
+#define GIMBAL_PAN_LIMIT    70.0f     // ± deg from centre
+#define GIMBAL_PAN_GAIN     0.8f      // share of the camera offset taken per frame
+#define GIMBAL_TILT_GAIN    0.6f
+#define GIMBAL_TILT_MIN     20
+#define GIMBAL_TILT_MAX     150
+#define GIMBAL_PAN_VMAX     240.0f    // deg/s
+#define GIMBAL_PAN_ACC      1500.0f   // deg/s²
+#define GIMBAL_TILT_VMAX    120.0f
+#define GIMBAL_TILT_ACC     800.0f
+#define GIMBAL_SWEEP_DEG    60.0f     // Find scans pan ± this
+#define GIMBAL_SWEEP_VMAX   90.0f
+#define GIMBAL_FB_TRUST_DEG 40.0f     // feedback further from the command is ignored
+#define GIMBAL_HIST         16        // pan feedback / tilt command samples kept per axis
+
+// ── Power sequencing (relay_control) ────────────────────────────────
+#define POWER_READY_TIMEOUT_MS  3000  // rail on → peripheral silent → power_ready ok=false
+#define POWER_PROBE_MS          100   // HuskyLens probe interval while its rail comes up
+#define POWER_PREWARM_AT_MED    1     // Auto idle at MED keeps R1 on → instant Follow
+
+// ── Tokenized logging (tlog.h, CMD_LOG on USB serial) ──────────────
+#define TLOG_SOURCE         0         // 0 = ESP32, 1 = STM32 (record header bit 7)
+#define TLOG_TEXT           0         // 1 = plain Serial.printf, no host decoder needed
+#define TLOG_MAX_LEVEL      4         // compile-time cap: higher levels cost nothing
+#define TLOG_DEFAULT_LEVEL  3         // runtime level per module at boot (LOG_INF)
+#define TLOG_RING_SIZE      4096      // bytes, shared with forwarded STM32 records
+#define TLOG_FRAME_MAX      120       // CMD_LOG payload bytes per frame
+#define TLOG_TX_BUFFER      1024      // USB serial TX buffer (drained by the driver)
 
 // ── Route ───────────────────────────────────────────────────────────
 #define MAX_ROUTE_LEN       30
+#define KPI_MAX_LEGS        40        // checkpoint-to-checkpoint legs kept per mission
 #define MED_CHECKPOINT_ID   0x8083      // from UID "45:54:80:83" last 2 bytes
 
 // ── UART Protocol ───────────────────────────────────────────────────
@@ -0,0 +1,60 @@
+#include "estop.h"
+#include "globals.h"
+#include "config.h"
+#include "uart_protocol.h"
+#include "mqtt_client.h"
+#include "tlog.h"
+
+extern HardwareSerial Serial2;  // UART2 → STM32 (begin trong main.cpp)
+
+static double   s_dashTs = 0;   // dashboard click time of pending stop
+static uint32_t s_rxUs   = 0;   // MQTT message received (micros)
+
+void estopInit() {
+#if USE_ESTOP_LINE
+    pinMode(PIN_ESTOP_OUT, OUTPUT);
+    digitalWrite(PIN_ESTOP_OUT, HIGH);    // idle HIGH, LOW = stop
+#endif
+}
+
+void estopEngage(double dashTs) {
+    s_rxUs   = micros();
+    s_dashTs = dashTs;
+    g_stopped = true;
+    g_running = false;
+
+#if USE_ESTOP_LINE
+    digitalWrite(PIN_ESTOP_OUT, LOW);
+#endif
+    // tag = our receive time → round trip measured on ACK
+    uint8_t buf[4] = {
+        (uint8_t)(s_rxUs >> 24), (uint8_t)(s_rxUs >> 16),
+        (uint8_t)(s_rxUs >> 8),  (uint8_t)(s_rxUs & 0xFF)
+    };
+    uartSendFrame(Serial2, CMD_ESTOP, buf, 4);
+    Serial2.flush();
+    LOGI(LM_ESTOP, "sent (%lu us after MQTT rx)",
+         (unsigned long)(micros() - s_rxUs));
+}
+
+void estopRelease() {
+#if USE_ESTOP_LINE
+    digitalWrite(PIN_ESTOP_OUT, HIGH);
+#endif
+    uartSendFrame(Serial2, CMD_ESTOP_CLEAR, nullptr, 0);
+    g_stopped = false;
+}
+
+void estopOnAck(const uint8_t *data, uint8_t len) {
+    if (len < 7) return;
+    uint32_t tag   = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+                     ((uint32_t)data[2] << 8)  |  data[3];
+    uint16_t cutUs = ((uint16_t)data[4] << 8) | data[5];
+    uint8_t  src   = data[6];
+
+    // line-triggered ACKs carry tag 0 → measure from our receive time
+    uint32_t rttUs = micros() - (tag ? tag : s_rxUs);
+    LOGI(LM_ESTOP, "ack src=%u  rtt=%lu us  cut=%u us",
+         src, (unsigned long)rttUs, cutUs);
+    mqttPublishEstopAck(s_dashTs, rttUs, cutUs, src);
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+
+// ── Emergency stop fast path (MQTT → UART/GPIO → STM32 motors) ──────
+// Called straight from the MQTT callback – no main-loop round trip.
+// `dashTs` is the dashboard click timestamp (ms epoch, 0 if unknown);
+// it is echoed in the estop_ack event so the backend can measure
+// click → motor-cut latency end to end.
+
+void estopInit();
+void estopEngage(double dashTs);
+void estopRelease();
+void estopOnAck(const uint8_t *data, uint8_t len);   // CMD_ESTOP_ACK from STM32
@@ -0,0 +1,159 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// ── Lock-free bounded queues ────────────────────────────────────────
+// N must be a power of two.  A full queue rejects the push and counts
+// it in dropped(); highWater() is the deepest the queue has been.
+// Neither queue blocks or disables interrupts, so producers on either
+// core (and ISRs for the SPSC producer side) never wait on the consumer.
+
+template <typename T, uint16_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+public:
+    // producer side
+    bool push(const T &v) {
+        uint16_t h = head_.load(std::memory_order_relaxed);
+        uint16_t t = tail_.load(std::memory_order_acquire);
+        if ((uint16_t)(h - t) >= N) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        buf_[h & (N - 1)] = v;
+        head_.store(h + 1, std::memory_order_release);
+        noteDepth((uint16_t)(h + 1 - t));
+        return true;
+    }
+
+    // consumer side
+    bool pop(T &out) {
+        uint16_t t = tail_.load(std::memory_order_relaxed);
+        if (t == head_.load(std::memory_order_acquire)) return false;
+        out = buf_[t & (N - 1)];
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    void clear() { tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release); }
+
+    uint16_t size() const {
+        return (uint16_t)(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+    }
+    uint16_t highWater() const { return hw_.load(std::memory_order_relaxed); }
+    uint32_t dropped()   const { return dropped_.load(std::memory_order_relaxed); }
+    static constexpr uint16_t capacity() { return N; }
+
+private:
+    void noteDepth(uint16_t d) {
+        if (d > hw_.load(std::memory_order_relaxed)) hw_.store(d, std::memory_order_relaxed);
+    }
+
+    T                     buf_[N];
+    std::atomic<uint16_t> head_{0};
+    std::atomic<uint16_t> tail_{0};
+    std::atomic<uint16_t> hw_{0};
+    std::atomic<uint32_t> dropped_{0};
+};
+
+// Multi-producer / single-consumer: per-slot sequence numbers, producers
+// claim a slot with one compare-and-swap on the head.
+template <typename T, uint16_t N>
+class MpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+public:
+    MpscQueue() {
+        for (uint32_t i = 0; i < N; i++) slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // any task
+    bool push(const T &v) {
+        uint32_t pos = head_.load(std::memory_order_relaxed);
+        Slot *s;
+        for (;;) {
+            s = &slots_[pos & (N - 1)];
+            int32_t diff = (int32_t)(s->seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;                       // full
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        s->v = v;
+        s->seq.store(pos + 1, std::memory_order_release);
+        noteDepth((uint16_t)(pos + 1 - tail_.load(std::memory_order_relaxed)));
+        return true;
+    }
+
+    // consumer side
+    bool pop(T &out) {
+        uint32_t pos = tail_.load(std::memory_order_relaxed);
+        Slot &s = slots_[pos & (N - 1)];
+        if ((int32_t)(s.seq.load(std::memory_order_acquire) - (pos + 1)) < 0) return false;
+        out = s.v;
+        s.seq.store(pos + N, std::memory_order_release);
+        tail_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+    void clear() { T tmp; while (pop(tmp)) {} }
+
+    uint16_t highWater() const { return hw_.load(std::memory_order_relaxed); }
+    uint32_t dropped()   const { return dropped_.load(std::memory_order_relaxed); }
+    static constexpr uint16_t capacity() { return N; }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        T                     v;
+    };
+
+    void noteDepth(uint16_t d) {
+        uint16_t cur = hw_.load(std::memory_order_relaxed);
+        while (d > cur && !hw_.compare_exchange_weak(cur, d, std::memory_order_relaxed)) {}
+    }
+
+    Slot                  slots_[N];
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+    std::atomic<uint16_t> hw_{0};
+    std::atomic<uint32_t> dropped_{0};
+};
+
+// ── Versioned snapshot (single writer, any number of readers) ───────
+// Seqlock over two buffers: the writer fills the buffer readers are
+// not looking at, then bumps the version.  A reader that preempts the
+// writer on the same core still copies a finished buffer, so nobody
+// spins on a lower-priority task.  A copy is retried whenever the
+// version moved while it was being taken, even by a single publish
+// (conservative: only a second publish could reuse that buffer).
+template <typename T>
+class Snapshot {
+public:
+    // writer side
+    void publish(const T &v) {
+        uint32_t n = ver_.load(std::memory_order_relaxed) + 1;
+        buf_[n & 1] = v;
+        ver_.store(n, std::memory_order_release);
+    }
+
+    // any task; returns the version copied (0 = nothing published yet)
+    uint32_t read(T &out) const {
+        for (;;) {
+            uint32_t v = ver_.load(std::memory_order_acquire);
+            out = buf_[v & 1];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (ver_.load(std::memory_order_relaxed) == v) return v;
+            retries_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t version() const { return ver_.load(std::memory_order_acquire); }
+    uint32_t retries() const { return retries_.load(std::memory_order_relaxed); }
+
+private:
+    T                             buf_[2] = {};
+    std::atomic<uint32_t>         ver_{0};
+    mutable std::atomic<uint32_t> retries_{0};
+};
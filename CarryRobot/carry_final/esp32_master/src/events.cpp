@@ -0,0 +1,37 @@
+#include "events.h"
+#include "tlog.h"
+
+SpscQueue<LinkFrame,  LINK_QUEUE_LEN>  g_linkFrames;
+SpscQueue<RouteEvent, ROUTE_EVENT_LEN> g_routeEvents;
+MpscQueue<BtnGesture, BTN_EVENT_LEN>   g_btnEvents;
+MpscQueue<CmdEvent,   CMD_EVENT_LEN>   g_cmdEvents;
+
+// ── drop reporting ──────────────────────────────────────────────────
+static uint32_t s_reported[4] = { 0, 0, 0, 0 };
+
+static void checkDrops(uint8_t i, const char *name, uint32_t dropped) {
+    if (dropped == s_reported[i]) return;
+    LOGW(LM_MAIN, "%s queue full – %u event(s) dropped", name, dropped - s_reported[i]);
+    s_reported[i] = dropped;
+}
+
+void eventsCheckDrops() {
+    checkDrops(0, "link",  g_linkFrames.dropped());
+    checkDrops(1, "route", g_routeEvents.dropped());
+    checkDrops(2, "btn",   g_btnEvents.dropped());
+    checkDrops(3, "cmd",   g_cmdEvents.dropped());
+}
+
+// "queues":{"link":[hw,cap,drops],…}
+int eventsFormatStats(char *buf, size_t size) {
+    return snprintf(buf, size,
+        "\"queues\":{"
+        "\"link\":[%u,%u,%lu],"
+        "\"route\":[%u,%u,%lu],"
+        "\"btn\":[%u,%u,%lu],"
+        "\"cmd\":[%u,%u,%lu]}",
+        g_linkFrames.highWater(),  g_linkFrames.capacity(),  (unsigned long)g_linkFrames.dropped(),
+        g_routeEvents.highWater(), g_routeEvents.capacity(), (unsigned long)g_routeEvents.dropped(),
+        g_btnEvents.highWater(),   g_btnEvents.capacity(),   (unsigned long)g_btnEvents.dropped(),
+        g_cmdEvents.highWater(),   g_cmdEvents.capacity(),   (unsigned long)g_cmdEvents.dropped());
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "uart_protocol.h"
+#include "event_queue.h"
+
+// ── Inter-module events ─────────────────────────────────────────────
+// One-shot signals travel through lock-free queues instead of volatile
+// flags, so a second event before the consumer runs is queued, not
+// overwritten.  State (g_lastCheckpointId, g_stm32Obstacle, …) stays in
+// globals.h.
+
+// STM32 frame, link task → control task
+struct LinkFrame {
+    uint8_t cmd;
+    uint8_t len;
+    uint8_t data[UART_MAX_FRAME];
+};
+
+// route progress reported by the STM32, in arrival order
+enum RouteEventType : uint8_t {
+    EV_CHECKPOINT,          // id = checkpoint read
+    EV_SKIPPED,             // n  = points passed without a read (precedes EV_CHECKPOINT)
+    EV_MISSION_DONE,
+    EV_MISMATCH             // id = got, exp = expected
+};
+
+struct RouteEvent {
+    RouteEventType type;
+    uint8_t        n;
+    uint16_t       id;
+    uint16_t       exp;
+};
+
+// button gestures: the physical button and the dashboard "start"
+enum BtnGesture : uint8_t {
+    BTN_NONE,
+    BTN_SINGLE,
+    BTN_DOUBLE,
+    BTN_LONG
+};
+
+// MQTT commands for the control loop
+enum CmdEventType : uint8_t {
+    CMD_EV_CANCEL,          // dashboard cancel
+    CMD_EV_PREEMPT,         // new route replaced the running one → stop STM32 route only
+    CMD_EV_SET_MODE,        // arg = RobotMode
+    CMD_EV_FOLLOW_TAG       // arg = HuskyLens tag ID, 0 = first one seen
+};
+
+struct CmdEvent {
+    CmdEventType type;
+    uint8_t      arg;
+};
+
+extern SpscQueue<LinkFrame,  LINK_QUEUE_LEN>  g_linkFrames;
+extern SpscQueue<RouteEvent, ROUTE_EVENT_LEN> g_routeEvents;
+extern MpscQueue<BtnGesture, BTN_EVENT_LEN>   g_btnEvents;
+extern MpscQueue<CmdEvent,   CMD_EVENT_LEN>   g_cmdEvents;
+
+void eventsCheckDrops();                        // control task: log new drops
+int  eventsFormatStats(char *buf, size_t size); // JSON "queues":{…} fragment
@@ -2,11 +2,13 @@
 #include "globals.h"
 #include "config.h"
 #include "uart_protocol.h"
-#include "huskylens_uart.h"
-#include "servo_control.h"
-#include "sr05.h"
+#include "sensors.h"
+#include "follow_mode.h"
+#include "gimbal.h"
 #include "oled_display.h"
 #include "buzzer.h"
+#include "button_handler.h"
+#include "tlog.h"
 
 extern HardwareSerial Serial2;
 
@@ -23,9 +25,16 @@ static uint32_t lastWallMs = 0;
 static bool     turning    = false;
 static int16_t  turnDir    = 0;
 static uint32_t turnStart  = 0;
+static int16_t  lastVel[3] = { 0, 0, 0 };
+static uint32_t lastVelMs  = 0;
+
+// ── walls from the sensor task's sample (no sample = open) ──────────
+static bool isWall(float d) { return d > 0.0f && d < SR05_WALL_WARN_CM; }
 
 // ── send velocity ───────────────────────────────────────────────────
 static void sendVel(int16_t vx, int16_t vy, int16_t vr) {
+    lastVel[0] = vx; lastVel[1] = vy; lastVel[2] = vr;
+    lastVelMs  = millis();
     uint8_t buf[6];
     buf[0] = (vx >> 8); buf[1] = vx;
     buf[2] = (vy >> 8); buf[3] = vy;
@@ -39,13 +48,20 @@ static void stopSTM32() { sendVel(0, 0, 0); }
 void findModeInit() {
     attempts  = 0;
     turning   = false;
-    prevWallL = sr05WallLeft();
-    prevWallR = sr05WallRight();
+    SensorSnapshot s;
+    sensorsSnapshot(s);
+    bool fresh = sensorFresh(s.wallMs);
+    prevWallL = fresh && isWall(s.wallL);
+    prevWallR = fresh && isWall(s.wallR);
     lastWallMs = millis();
 
+    // pan scans while the chassis creeps: wider view, faster re-acquire
+    gimbalReset(SERVO_Y_LEVEL);
+    gimbalSweep(true);
+
     // creep forward
     sendVel(0, FIND_SLOW_VY, 0);
-    Serial.println("[FIND] init – creeping forward");
+    LOGI(LM_FIND, "init – creeping forward");
 }
 
 void findModeLoop() {
@@ -53,22 +69,33 @@ void findModeLoop() {
     uint32_t now = millis();
 
     // ── double click → Recovery ─────────────────────────────────────
-    if (g_btnDoubleClick) {
-        g_btnDoubleClick = false;
+    if (buttonTake(BTN_DOUBLE)) {
         stopSTM32();
         g_mode = MODE_RECOVERY;
-        Serial.println("[FIND] double click → RECOVERY");
+        LOGI(LM_FIND, "double click → RECOVERY");
         return;
     }
 
+    // ── keep-alive: STM32 ramps to 0 if setpoints go stale ──────────
+    if (now - lastVelMs >= VEL_KEEPALIVE_MS)
+        sendVel(lastVel[0], lastVel[1], lastVel[2]);
+
     // ── check HuskyLens while turning or moving ─────────────────────
-    HuskyResult tag = huskyRead();
-    if (tag.detected) {
+    SensorSnapshot s;
+    sensorsSnapshot(s);
+    gimbalFeedback(s);
+    HuskyResult tag = huskyPick(s.cam, followLockedId());
+    if (s.cam.arrows) tag.detected = false;   // line-tracking reply, not a tag
+    if (sensorFresh(s.tagMs) && tag.detected) {
         stopSTM32();
-        servoSetX(SERVO_X_CENTER);        buzzerBeepN(3, 100, 50);  // ♪ target re-acquired        g_mode = MODE_FOLLOW;
-        Serial.println("[FIND] tag found → FOLLOW");
+        gimbalAim(tag, s.tagMs);  // stop the sweep on the tag, Follow takes over
+        buzzerBeepN(3, 100, 50);  // ♪ target re-acquired
+        g_mode = MODE_FOLLOW;
+        followModeResume();
+        LOGI(LM_FIND, "tag found → FOLLOW");
         return;
     }
+    gimbalStep(now);
 
     // ── turning phase ───────────────────────────────────────────────
     if (turning) {
@@ -77,8 +104,8 @@ void findModeLoop() {
             turning = false;
             attempts++;
             if (attempts >= FIND_MAX_TRIES) {
-                buzzerBeepN(3);
-                Serial.println("[FIND] max tries – continuing straight");
+                buzzerBeepN(3, 100, 100, BUZ_WARN);
+                LOGW(LM_FIND, "max tries – continuing straight");
             }
             // resume forward crawl
             sendVel(0, FIND_SLOW_VY, 0);
@@ -89,8 +116,9 @@ void findModeLoop() {
     // ── wall change detection ───────────────────────────────────────
     if (now - lastWallMs >= FIND_WALL_CHK) {
         lastWallMs = now;
-        bool wl = sr05WallLeft();
-        bool wr = sr05WallRight();
+        bool fresh = sensorFresh(s.wallMs);
+        bool wl = fresh && isWall(s.wallL);
+        bool wr = fresh && isWall(s.wallR);
 
         bool changed = (wl != prevWallL) || (wr != prevWallR);
         prevWallL = wl;
@@ -107,8 +135,8 @@ void findModeLoop() {
             sendVel(0, 0, turnDir);
             turning   = true;
             turnStart = now;
-            Serial.printf("[FIND] wall change → turn %s (attempt %u)\n",
-                          turnDir < 0 ? "LEFT" : "RIGHT", attempts + 1);
+            LOGI(LM_FIND, "wall change → turn %s (attempt %u)",
+                 turnDir < 0 ? "LEFT" : "RIGHT", attempts + 1);
         }
     }
 
@@ -3,24 +3,30 @@
 #include "config.h"
 #include "relay_control.h"
 #include "uart_protocol.h"
-#include "huskylens_uart.h"
-#include "servo_control.h"
-#include "sr05.h"
+#include "sensors.h"
 #include "oled_display.h"
 #include "buzzer.h"
+#include "button_handler.h"
+#include "target_track.h"
+#include "gimbal.h"
+#include "find_mode.h"
+#include "tlog.h"
 
 extern HardwareSerial Serial2;
 
-// ── PID-like follow constants ───────────────────────────────────────
-#define HUSKY_CX          160      // screen center X (320/2)
-#define HUSKY_CY          120      // screen center Y (240/2)
-#define TARGET_AREA       4000     // desired tag area (distance proxy)
-#define VR_GAIN           0.5f
-#define VY_GAIN           0.3f
+// ── follow controller on the tracked target (target_track) ─────────
+#define VR_GAIN           1.5f     // per degree of bearing – slower than the gimbal
+#define VY_GAIN           4.0f     // per cm of range error
+#define VY_FF             0.8f     // per cm/s the target walks away
+#define VY_MAX            250
 #define VX_WALL_GAIN      1.5f
 #define TAG_LOST_MS       10000    // ms before switching to FIND (10 s)
 
 static uint32_t lastTagTime = 0;
+static uint32_t lastSeq     = 0;
+static bool     moving      = false;           // last command was non-zero
+static int16_t  wantId      = FOLLOW_TAG_ID;   // MQTT follow_tag
+static int16_t  lockId      = 0;               // tag being followed, 0 = not locked yet
 
 // ── send velocity to STM32 ──────────────────────────────────────────
 static void sendVel(int16_t vx, int16_t vy, int16_t vr) {
@@ -35,72 +41,111 @@ static void stopSTM32() { sendVel(0, 0, 0); }
 
 // ──────────────────────────────────────────────────────────────────
 void followModeInit() {
-    relaySetFollow();
-    huskyReconnect();   // re-init after relay vision powered on
+    relaySetFollow();    // sensor task probes HuskyLens when R1 comes up
     uint8_t m = MODE_FOLLOW;
     uartSendFrame(Serial2, CMD_SET_MODE, &m, 1);
 
-    servoSetX(SERVO_X_CENTER);
-    servoSetY(SERVO_Y_TILT_DOWN);
-    huskySetTagMode();
+    gimbalReset(SERVO_Y_TILT_DOWN);
+    sensorsCommand(SENSOR_HUSKY_TAG);
+    lockId = wantId;
+    followModeResume();
+    LOGI(LM_FOLLOW, "init (tag %d)", lockId);
+}
+
+void followModeResume() {
     lastTagTime = millis();
-    Serial.println("[FOLLOW] init");
+    moving = false;
+    trackReset();
+}
+
+void followModeLock(int16_t id) {
+    wantId = id;
+    lockId = id;
+    LOGI(LM_FOLLOW, "lock → tag %d", id);
 }
 
+int16_t followLockedId() { return lockId; }
+
 void followModeLoop() {
     if (g_mode != MODE_FOLLOW) return;
 
     // ── double click → Recovery ─────────────────────────────────────
-    if (g_btnDoubleClick) {
-        g_btnDoubleClick = false;
+    if (buttonTake(BTN_DOUBLE)) {
         stopSTM32();
         g_mode = MODE_RECOVERY;
-        Serial.println("[FOLLOW] double click → RECOVERY");
+        LOGI(LM_FOLLOW, "double click → RECOVERY");
         return;
     }
 
-    // ── read HuskyLens ──────────────────────────────────────────────
-    HuskyResult tag = huskyRead();
+    // ── latest HuskyLens / SR05 snapshot (sensor hub) ───────────────
+    // Each camera frame is one tracker measurement; velocity goes out
+    // every control tick (50 Hz) from the track predicted to the moment
+    // the wheels respond, and coasts through short detection gaps.
+    uint32_t now = millis();
+    SensorSnapshot s;
+    sensorsSnapshot(s);
+    HuskyResult tag = huskyPick(s.cam, lockId);
+    if (s.cam.arrows) tag.detected = false;   // line-tracking reply, not a tag
+    bool fresh = sensorFresh(s.tagMs);
+    bool newSample = fresh && s.tagSeq != lastSeq;
+    if (fresh) lastSeq = s.tagSeq;
+
+    // not locked yet: the first learned tag in view becomes the target
+    if (newSample && tag.detected && !lockId && tag.id > 0) {
+        lockId = tag.id;
+        LOGI(LM_FOLLOW, "locked onto tag %d", lockId);
+    }
 
-    if (tag.detected) {
-        lastTagTime = millis();
+    // gimbal keeps the camera on the tag (inner loop); the tracker sees
+    // the bearing relative to the chassis through the measured pan angle
+    gimbalFeedback(s);
+    if (newSample && tag.detected) {
+        trackMeasure(tag, s.tagMs, gimbalPanAt(s.tagMs - FOLLOW_CAM_LAT_MS),
+                     gimbalTiltAt(s.tagMs - FOLLOW_CAM_LAT_MS));
+        gimbalAim(tag, s.tagMs);
+        lastTagTime = now;
+    } else if (newSample) {
+        trackMiss();
+    }
+    gimbalStep(now);
 
-        // rotation: tag X offset → Vr
-        float errX = (float)(tag.xCenter - HUSKY_CX);
-        int16_t vr = (int16_t)(errX * VR_GAIN);
+    TrackState t;
+    if (trackPredict(now, t)) {
+        // rotation (outer loop): predicted chassis bearing, pan included → Vr
+        int16_t vr = (int16_t)(t.bearingDeg * VR_GAIN);
 
-        // forward/backward: area → Vy
-        int16_t area = tag.width * tag.height;
-        float errArea = (float)(TARGET_AREA - area);
-        int16_t vy = (int16_t)(errArea * VY_GAIN);
-        vy = constrain(vy, -200, 200);
+        // forward/backward: range error + the target's own speed → Vy
+        float vyf = (t.rangeCm - FOLLOW_RANGE_CM) * VY_GAIN + t.rangeRate * VY_FF;
+        int16_t vy = (int16_t)constrain(vyf, (float)-VY_MAX, (float)VY_MAX);
 
         // lateral wall avoidance
         int16_t vx = 0;
-        float wl = sr05ReadLeft();
-        float wr = sr05ReadRight();
+        bool  wallOk = sensorFresh(s.wallMs);
+        float wl = wallOk ? s.wallL : 0.0f;
+        float wr = wallOk ? s.wallR : 0.0f;
         if (wl > 0 && wl < SR05_WALL_WARN_CM) vx += (int16_t)((SR05_WALL_WARN_CM - wl) * VX_WALL_GAIN);
         if (wr > 0 && wr < SR05_WALL_WARN_CM) vx -= (int16_t)((SR05_WALL_WARN_CM - wr) * VX_WALL_GAIN);
 
-        // adjust servo Y based on tag Y position
-        float errY = (float)(tag.yCenter - HUSKY_CY);
-        int newY = servoGetY() - (int)(errY * 0.05f);
-        servoSetY(constrain(newY, 20, 150));
-
         sendVel(vx, vy, vr);
+        moving = true;
 
         // OLED
         static uint32_t lastOled = 0;
-        if (millis() - lastOled > OLED_UPDATE_MS) {
-            oledFollowMode(tag.xCenter, tag.yCenter, area, wl, wr);
-            lastOled = millis();
+        if (now - lastOled > OLED_UPDATE_MS) {
+            oledFollowMode(lockId, (int)t.bearingDeg, (int)t.rangeCm, wl, wr);
+            lastOled = now;
+            LOGD(LM_FOLLOW, "b=%.1f r=%.0f dr=%.0f lat=%u%s", t.bearingDeg, t.rangeCm,
+                 t.rangeRate, t.latencyMs, t.coasting ? " coast" : "");
         }
 
     } else {
-        // tag not seen
-        if (millis() - lastTagTime > TAG_LOST_MS) {
-            stopSTM32();            buzzerBeepN(2, 250, 100);  // ⚠ target lost            g_mode = MODE_FIND;
-            Serial.println("[FOLLOW] tag lost → FIND");
+        // no track (coasted out): hold still
+        if (moving) { stopSTM32(); moving = false; }
+        if (now - lastTagTime > TAG_LOST_MS) {
+            buzzerBeepN(2, 250, 100, BUZ_ALARM);  // ⚠ target lost
+            g_mode = MODE_FIND;
+            findModeInit();
+            LOGI(LM_FOLLOW, "tag lost → FIND");
         }
     }
 }
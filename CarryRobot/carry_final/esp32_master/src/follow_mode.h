@@ -2,4 +2,7 @@
 #include <Arduino.h>
 
 void followModeInit();
+void followModeResume(); // Find → Follow: fresh track, same tag lock
 void followModeLoop();   // returns when mode switches away
+void followModeLock(int16_t id);   // tag ID to follow, 0 = lock onto the first seen
+int16_t followLockedId();          // current lock, 0 = none yet (Find uses it too)
@@ -0,0 +1,131 @@
+#include "gimbal.h"
+#include "servo_control.h"
+#include "tlog.h"
+
+// commanded trajectory of one axis, servo degrees
+struct Axis {
+    float pos;
+    float vel;      // deg/s
+    float target;
+};
+
+// servo angle over time: pan from the feedback ADC, tilt as commanded
+// (no tilt pot), both looked up at a camera frame's capture time
+struct Sample {
+    uint32_t ms;
+    float    deg;   // servo degrees
+};
+
+struct History {
+    Sample  s[GIMBAL_HIST];
+    uint8_t head;
+    uint8_t n;
+};
+
+static Axis      s_pan  = { SERVO_X_CENTER, 0.0f, SERVO_X_CENTER };
+static Axis      s_tilt = { SERVO_Y_LEVEL,  0.0f, SERVO_Y_LEVEL };
+static History   s_panHist  = {};
+static History   s_tiltHist = {};
+static uint32_t  s_fbMs     = 0;       // panMs of the last sample taken
+static uint32_t  s_stepMs   = 0;
+static bool      s_sweep    = false;
+
+static float panRel(float servoDeg) { return (servoDeg - SERVO_X_CENTER) * SERVO_X_DIR; }
+static float panServo(float rel)    { return SERVO_X_CENTER + rel * SERVO_X_DIR; }
+static float deg(float rad)         { return rad * 57.29578f; }
+
+static void histPush(History &h, uint32_t ms, float deg) {
+    h.s[h.head] = { ms, deg };
+    h.head = (h.head + 1) % GIMBAL_HIST;
+    if (h.n < GIMBAL_HIST) h.n++;
+}
+
+// newest sample at or before ms; false if none within maxGap of it
+static bool histAt(const History &h, uint32_t ms, uint32_t maxGap, float &deg) {
+    for (uint8_t i = 1; i <= h.n; i++) {
+        const Sample &p = h.s[(h.head + GIMBAL_HIST - i) % GIMBAL_HIST];
+        int32_t before = (int32_t)(ms - p.ms);
+        if (before < 0) continue;
+        if (before > (int32_t)maxGap) return false;   // history too old for this frame
+        deg = p.deg;
+        return true;
+    }
+    return false;
+}
+
+// fastest speed that still stops at the target, then limited accel
+static void slew(Axis &a, float dt, float vmax, float acc) {
+    float err  = a.target - a.pos;
+    float want = copysignf(min(sqrtf(2.0f * acc * fabsf(err)), vmax), err);
+    a.vel += constrain(want - a.vel, -acc * dt, acc * dt);
+    a.pos += a.vel * dt;
+    if (fabsf(err) < 0.5f && fabsf(a.vel) <= acc * dt) {
+        a.pos = a.target;
+        a.vel = 0.0f;
+    }
+}
+
+// ──────────────────────────────────────────────────────────────────
+void gimbalReset(int tilt) {
+    s_pan  = { (float)servoGetX(), 0.0f, SERVO_X_CENTER };
+    s_tilt = { (float)servoGetY(), 0.0f, (float)tilt };
+    s_panHist.n  = 0;
+    s_tiltHist.n = 0;
+    s_sweep  = false;
+    s_stepMs = millis();
+}
+
+void gimbalFeedback(const SensorSnapshot &s) {
+    if (!sensorFresh(s.panMs) || s.panMs == s_fbMs) return;
+    s_fbMs = s.panMs;
+    // far from the command = pot unpowered or unplugged → not trusted
+    if (fabsf(s.panDeg - s_pan.pos) > GIMBAL_FB_TRUST_DEG) return;
+    histPush(s_panHist, s.panMs, s.panDeg);
+}
+
+float gimbalPanAt(uint32_t ms) {
+    float d;
+    if (histAt(s_panHist, ms, 2 * SENSOR_PAN_MS, d)) return panRel(d);
+    return panRel(s_pan.pos);                    // no feedback: trust the command
+}
+
+float gimbalTiltAt(uint32_t ms) {
+    float d;
+    if (histAt(s_tiltHist, ms, 2 * CTRL_TASK_MS, d)) return d;
+    return s_tilt.pos;
+}
+
+void gimbalAim(const HuskyResult &tag, uint32_t captureMs) {
+    float camB = deg(atanf((tag.xCenter - HUSKY_CX) / HUSKY_FOCAL_PX));
+    float camE = deg(atanf((tag.yCenter - HUSKY_CY) / HUSKY_FOCAL_PX));   // + = below centre
+    float pan  = gimbalPanAt(captureMs - FOLLOW_CAM_LAT_MS) + camB * GIMBAL_PAN_GAIN;
+    float tilt = gimbalTiltAt(captureMs - FOLLOW_CAM_LAT_MS) - camE * GIMBAL_TILT_GAIN;
+
+    s_pan.target  = panServo(constrain(pan, -GIMBAL_PAN_LIMIT, GIMBAL_PAN_LIMIT));
+    s_tilt.target = constrain(tilt, (float)GIMBAL_TILT_MIN, (float)GIMBAL_TILT_MAX);
+    s_sweep = false;
+}
+
+void gimbalSweep(bool on) {
+    if (on && !s_sweep) s_pan.target = panServo(-GIMBAL_SWEEP_DEG);
+    s_sweep = on;
+}
+
+void gimbalStep(uint32_t now) {
+    float dt = (now - s_stepMs) / 1000.0f;
+    s_stepMs = now;
+    if (dt <= 0.0f || dt > 0.1f) dt = CTRL_TASK_MS / 1000.0f;
+
+    // sweep: turn round at each end
+    if (s_sweep && fabsf(s_pan.target - s_pan.pos) < 1.0f)
+        s_pan.target = panServo(panRel(s_pan.target) < 0 ? GIMBAL_SWEEP_DEG : -GIMBAL_SWEEP_DEG);
+
+    slew(s_pan,  dt, s_sweep ? GIMBAL_SWEEP_VMAX : GIMBAL_PAN_VMAX, GIMBAL_PAN_ACC);
+    slew(s_tilt, dt, GIMBAL_TILT_VMAX, GIMBAL_TILT_ACC);
+    histPush(s_tiltHist, now, s_tilt.pos);
+
+    int x = lroundf(s_pan.pos);
+    int y = lroundf(s_tilt.pos);
+    if (x != servoGetX()) servoSetX(x);
+    if (y != servoGetY()) servoSetY(y);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "huskylens_uart.h"
+#include "sensors.h"
+
+// ── Pan/tilt gimbal (Follow / Find, control task) ───────────────────
+// Inner loop: every camera frame with the target sets a pan/tilt aim
+// point from the tag's offset and the angles the gimbal had when that
+// frame was captured (pan from the feedback ADC, tilt as commanded);
+// gimbalStep() moves the servos there along a velocity- and
+// acceleration-limited trajectory each control tick.  Pan is reported
+// relative to the chassis axis (+ = right) so Follow can turn the
+// chassis after it, more slowly.
+void  gimbalReset(int tilt);                     // glide to pan centre / `tilt`
+void  gimbalFeedback(const SensorSnapshot &s);   // record new pan ADC samples
+void  gimbalAim(const HuskyResult &tag, uint32_t captureMs);
+void  gimbalSweep(bool on);                      // Find: scan ±GIMBAL_SWEEP_DEG
+void  gimbalStep(uint32_t now);                  // advance trajectories, write servos
+float gimbalPanAt(uint32_t ms);                  // chassis-relative pan (deg) at ms
+float gimbalTiltAt(uint32_t ms);                 // commanded tilt (servo deg) at ms
@@ -15,19 +15,10 @@ char g_destination[16] = "";
 char g_missionId[24]   = "";
 
 volatile uint16_t g_lastCheckpointId   = 0;
-volatile bool     g_newCheckpoint      = false;
 
 volatile bool     g_stm32Obstacle      = false;
-volatile bool     g_stm32MissionDone   = false;
-volatile uint16_t g_stm32MismatchGot   = 0;
-volatile uint16_t g_stm32MismatchExp   = 0;
-volatile bool     g_stm32MismatchFlag  = false;
-
-volatile bool     g_btnSingleClick = false;
-volatile bool     g_btnDoubleClick = false;
-volatile bool     g_btnLongPress   = false;
-
-volatile bool     g_mqttCancel     = false;
+volatile uint8_t  g_stm32Caps          = 0;
+volatile uint8_t  g_stm32Periph        = 0;
 
 volatile uint16_t g_tuneSpinMs    = 974;   // default from config
 volatile uint16_t g_tuneBrakeMs   = 80;
@@ -35,4 +26,3 @@ volatile uint16_t g_tuneWallCm    = 30;
 volatile bool     g_testDashboard = false;
 volatile bool     g_running       = false;
 volatile bool     g_stopped       = false;
-volatile bool     g_modeChangeReq = false;
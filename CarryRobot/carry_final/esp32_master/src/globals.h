@@ -24,7 +24,9 @@ enum AutoState : uint8_t {
 // ── Route point ─────────────────────────────────────────────────────
 struct RoutePoint {
     uint16_t checkpointId;
-    uint8_t  action;        // 'F','L','R','B','S'
+    uint8_t  action;        // ROUTE_ACT_* (uart_protocol.h)
+    uint8_t  arcRadius;     // cm for ROUTE_ACT_ARC_*, 0 = STM32 default
+    uint8_t  arcSpeed;      // PWM, 0 = STM32 default
 };
 
 // ── Shared globals ──────────────────────────────────────────────────
@@ -44,24 +46,13 @@ extern char        g_patientName[32];
 extern char        g_destination[16];
 extern char        g_missionId[24];
 
-// latest checkpoint reported by STM32
+// latest checkpoint reported by STM32 (events: g_routeEvents, events.h)
 extern volatile uint16_t g_lastCheckpointId;
-extern volatile bool     g_newCheckpoint;
 
-// STM32 flags
+// STM32 state
 extern volatile bool     g_stm32Obstacle;
-extern volatile bool     g_stm32MissionDone;
-extern volatile uint16_t g_stm32MismatchGot;
-extern volatile uint16_t g_stm32MismatchExp;
-extern volatile bool     g_stm32MismatchFlag;
-
-// button events
-extern volatile bool     g_btnSingleClick;
-extern volatile bool     g_btnDoubleClick;
-extern volatile bool     g_btnLongPress;
-
-/** Đặt bởi MQTT topic cancel — auto_mode xử lý CMD 0x05 + return request. */
-extern volatile bool     g_mqttCancel;
+extern volatile uint8_t  g_stm32Caps;         // BOOT_CAP_*, from CMD_BOOT / CMD_READY
+extern volatile uint8_t  g_stm32Periph;       // BOOT_PERIPH_*, live peripheral status
 
 // ── Test lab tunables (set via MQTT from dashboard) ─────────────────
 extern volatile uint16_t g_tuneSpinMs;     // turn spin duration ms
@@ -70,4 +61,3 @@ extern volatile uint16_t g_tuneWallCm;     // SR05 wall threshold cm
 extern volatile bool     g_testDashboard;  // OLED test dashboard mode
 extern volatile bool     g_running;        // robot is actively executing
 extern volatile bool     g_stopped;        // emergency stop flag
-extern volatile bool     g_modeChangeReq;  // MQTT requested mode change → main loop handles init
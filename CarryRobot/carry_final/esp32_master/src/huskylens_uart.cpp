@@ -1,9 +1,44 @@
 #include "huskylens_uart.h"
 #include "mqtt_client.h"
+#include "tlog.h"
+
+// ── HuskyLens UART protocol ─────────────────────────────────────────
+// [0x55][0xAA][0x11][len][cmd][data × len][sum of all previous bytes]
+#define HL_H0            0x55
+#define HL_H1            0xAA
+#define HL_ADDR          0x11
+#define HL_REQUEST       0x20      // all blocks and arrows
+#define HL_RETURN_INFO   0x29      // [count u16][learned u16][frame u16][pad]
+#define HL_RETURN_BLOCK  0x2A      // [x y w h id] u16 LE
+#define HL_RETURN_ARROW  0x2B      // [x0 y0 x1 y1 id] u16 LE
+#define HL_KNOCK         0x2C
+#define HL_ALGORITHM     0x2D      // [algo u16]
+#define HL_RETURN_OK     0x2E
+#define HL_MAX_DATA      16
+
+#define HL_ALGO_LINE     3
+#define HL_ALGO_TAG      5
+
+enum Await : uint8_t { AW_NONE, AW_KNOCK, AW_ALGO, AW_FRAME };
 
-static HUSKYLENS huskylens;
-static bool      s_connected = false;
 static HardwareSerial *s_port = nullptr;
+static bool      s_connected = false;
+static bool      s_lost      = false;       // dropped by the fail counter, not by power
+static Await     s_await     = AW_NONE;
+static uint32_t  s_sentMs    = 0;
+static uint32_t  s_reqMs     = 0;           // last frame request
+static bool      s_knockReq  = false;
+static bool      s_algoReq   = false;
+static uint16_t  s_algo      = HL_ALGO_TAG;
+
+// reply parser
+static uint8_t   s_rx[6 + HL_MAX_DATA];
+static uint8_t   s_rxLen = 0;
+
+// frame being assembled
+static HuskyFrame s_pend;
+static uint16_t   s_expect  = 0;
+static uint16_t   s_learned = 0;
 
 // ── health monitoring (PN532-like pattern) ──────────────────────────
 static uint8_t  s_consecFails    = 0;
@@ -11,75 +46,182 @@ static const uint8_t MAX_HUSKY_FAILS = 40;   // ~40 × 50ms = 2s of failures →
 static uint32_t s_lastRetryMs    = 0;
 static const uint32_t HUSKY_RETRY_MS = 3000; // retry reconnect every 3s
 
+static uint16_t u16At(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+static void send(uint8_t cmd, const uint8_t *data, uint8_t len, Await await) {
+    uint8_t buf[6 + 2];
+    uint8_t n = 0, sum = 0;
+    buf[n++] = HL_H0; buf[n++] = HL_H1; buf[n++] = HL_ADDR;
+    buf[n++] = len;   buf[n++] = cmd;
+    for (uint8_t i = 0; i < len; i++) buf[n++] = data[i];
+    for (uint8_t i = 0; i < n; i++) sum += buf[i];
+    buf[n++] = sum;
+    s_port->write(buf, n);             // ≤ 8 bytes: fits the TX FIFO, no wait
+    s_await  = await;
+    s_sentMs = millis();
+}
+
+static void resetLink() {
+    s_await  = AW_NONE;
+    s_rxLen  = 0;
+    s_expect = 0;
+    while (s_port && s_port->available()) s_port->read();
+}
+
+// ──────────────────────────────────────────────────────────────────
 void huskyInit(HardwareSerial &port) {
     s_port = &port;
-    s_connected = huskylens.begin(port);
-    if (s_connected) {
-        Serial.println("[HUSKY] connected");
-    } else {
-        Serial.println("[HUSKY] init FAILED");
-    }
+    resetLink();
 }
 
 void huskyReconnect() {
-    if (!s_port) return;
-    Serial.println("[HUSKY] reconnecting...");
-    s_connected = huskylens.begin(*s_port);
+    LOGD(LM_HUSKY, "reconnecting...");
+    s_connected   = false;
+    s_lost        = false;
+    s_knockReq    = false;
     s_consecFails = 0;
-    Serial.printf("[HUSKY] reconnect %s\n", s_connected ? "OK" : "FAILED");
+    resetLink();
 }
 
-// ── periodic retry if not connected ─────────────────────────────────
-static void huskyRetryInit() {
-    uint32_t now = millis();
-    if (now - s_lastRetryMs < HUSKY_RETRY_MS) return;
-    s_lastRetryMs = now;
-    Serial.println("[HUSKY] retrying init...");
-    huskyReconnect();
-    if (s_connected) {
-        mqttPublishEvent("husky_recovered");
-    }
+// ── power-up probe: quiet, one knock per call (sensor task) ─────────
+bool huskyProbe() {
+    if (!s_connected) s_knockReq = true;
+    return s_connected;
 }
 
 bool huskyConnected() { return s_connected; }
 
-void huskySetTagMode() {
-    if (s_connected)
-        huskylens.writeAlgorithm(ALGORITHM_TAG_RECOGNITION);
-}
+void huskySetTagMode()  { s_algo = HL_ALGO_TAG;  s_algoReq = true; }
+void huskySetLineMode() { s_algo = HL_ALGO_LINE; s_algoReq = true; }
+
+// ── one complete reply frame ────────────────────────────────────────
+static bool onReply(uint8_t cmd, const uint8_t *d, uint8_t len, HuskyFrame &out) {
+    switch (cmd) {
+    case HL_RETURN_OK:
+        if (s_await == AW_KNOCK) {
+            s_connected   = true;
+            s_consecFails = 0;
+            if (s_lost) {
+                s_lost    = false;
+                s_algoReq = true;          // camera may have rebooted
+                LOGI(LM_HUSKY, "reconnect OK");
+                mqttPublishEvent("husky_recovered");
+            }
+        }
+        if (s_await == AW_KNOCK || s_await == AW_ALGO) s_await = AW_NONE;
+        return false;
+
+    case HL_RETURN_INFO:
+        if (s_await != AW_FRAME || len < 6) return false;
+        s_expect       = u16At(d);
+        s_learned      = u16At(d + 2);
+        s_pend.frameNo = u16At(d + 4);
+        s_pend.total   = s_expect > 255 ? 255 : s_expect;
+        s_pend.count   = 0;
+        s_pend.arrows  = false;
+        break;
 
-void huskySetLineMode() {
-    if (s_connected)
-        huskylens.writeAlgorithm(ALGORITHM_LINE_TRACKING);
+    case HL_RETURN_BLOCK:
+    case HL_RETURN_ARROW:
+        if (s_await != AW_FRAME || !s_expect || len < 10) return false;
+        s_expect--;
+        if (s_pend.count < HUSKY_MAX_BLOCKS) {
+            HuskyResult &b = s_pend.blocks[s_pend.count++];
+            b.detected = true;
+            b.xCenter  = u16At(d);
+            b.yCenter  = u16At(d + 2);
+            b.width    = u16At(d + 4);
+            b.height   = u16At(d + 6);
+            b.id       = u16At(d + 8);
+            s_pend.arrows = (cmd == HL_RETURN_ARROW);
+        }
+        break;
+
+    default:
+        return false;
+    }
+
+    if (s_expect) return false;            // more blocks to come
+    if (!s_learned) s_pend.count = 0;      // nothing learned → nothing tracked
+    s_consecFails = 0;
+    s_await = AW_NONE;
+    out = s_pend;
+    return true;
 }
 
-HuskyResult huskyRead() {
-    HuskyResult r = {};
-    if (!s_connected) {
-        huskyRetryInit();
-        return r;
+// feed one byte; resyncs on a bad header, length or checksum
+static bool parseByte(uint8_t c, HuskyFrame &out) {
+    static const uint8_t hdr[3] = { HL_H0, HL_H1, HL_ADDR };
+    if (s_rxLen < 3) {
+        if (c != hdr[s_rxLen]) s_rxLen = 0;
+        if (c == hdr[s_rxLen])  s_rx[s_rxLen++] = c;
+        return false;
+    }
+    if (s_rxLen == 3 && c > HL_MAX_DATA) { s_rxLen = 0; return false; }
+    s_rx[s_rxLen++] = c;
+    if (s_rxLen < 6 + s_rx[3]) return false;
+
+    uint8_t n = s_rxLen, sum = 0;
+    s_rxLen = 0;
+    for (uint8_t i = 0; i < n - 1; i++) sum += s_rx[i];
+    if (sum != s_rx[n - 1]) {
+        LOGD(LM_HUSKY, "checksum error cmd=0x%02X", s_rx[4]);
+        return false;
     }
+    return onReply(s_rx[4], s_rx + 5, s_rx[3], out);
+}
+
+// ── sensor task, every tick ─────────────────────────────────────────
+bool huskyPoll(HuskyFrame &out) {
+    if (!s_port) return false;
+    bool got = false;
 
-    if (!huskylens.request()) {
-        if (++s_consecFails >= MAX_HUSKY_FAILS) {
+    int avail = s_port->available();
+    while (avail-- > 0)
+        if (parseByte((uint8_t)s_port->read(), out)) got = true;
+
+    uint32_t now = millis();
+    if (s_await != AW_NONE && now - s_sentMs > HUSKY_REPLY_MS) {
+        if (s_await == AW_FRAME && ++s_consecFails >= MAX_HUSKY_FAILS) {
             s_consecFails = 0;
-            s_connected = false;
-            Serial.println("[HUSKY] too many fails – will reconnect");
+            s_connected   = false;
+            s_lost        = true;
+            s_lastRetryMs = now;
+            LOGW(LM_HUSKY, "too many fails – will reconnect");
             mqttPublishEvent("husky_timeout");
         }
-        return r;
+        s_await  = AW_NONE;
+        s_rxLen  = 0;
+        s_expect = 0;
     }
-    if (!huskylens.isLearned()) return r;
-    if (!huskylens.available()) return r;
-
-    s_consecFails = 0;   // successful communication resets counter
-
-    HUSKYLENSResult res = huskylens.read();
-    r.detected = true;
-    r.xCenter  = res.xCenter;
-    r.yCenter  = res.yCenter;
-    r.width    = res.width;
-    r.height   = res.height;
-    r.id       = res.ID;
-    return r;
+    if (s_await != AW_NONE) return got;
+
+    // one request in flight: knock, then algorithm, then frames
+    if (!s_connected) {
+        if (s_lost && now - s_lastRetryMs >= HUSKY_RETRY_MS) {
+            s_lastRetryMs = now;
+            LOGD(LM_HUSKY, "retrying init...");
+            s_knockReq = true;
+        }
+        if (s_knockReq) {
+            s_knockReq = false;
+            send(HL_KNOCK, nullptr, 0, AW_KNOCK);
+        }
+    } else if (s_algoReq) {
+        uint8_t d[2] = { (uint8_t)s_algo, (uint8_t)(s_algo >> 8) };
+        s_algoReq = false;
+        send(HL_ALGORITHM, d, 2, AW_ALGO);
+    } else if (now - s_reqMs >= HUSKY_POLL_MS) {
+        s_reqMs = now;
+        s_pend.captureMs = now;
+        send(HL_REQUEST, nullptr, 0, AW_FRAME);
+    }
+    return got;
+}
+
+HuskyResult huskyPick(const HuskyFrame &f, int16_t id) {
+    for (uint8_t i = 0; i < f.count; i++)
+        if (id <= 0 || f.blocks[i].id == id) return f.blocks[i];
+    HuskyResult none = {};
+    return none;
 }
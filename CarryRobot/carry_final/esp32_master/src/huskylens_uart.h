@@ -1,9 +1,10 @@
 #pragma once
 #include <Arduino.h>
 #include "config.h"
-#include "HUSKYLENS.h"
 
 // ── HuskyLens result ────────────────────────────────────────────────
+// Line tracking returns arrows: origin in x/yCenter, target in
+// width/height (same packing as the vendor library).
 struct HuskyResult {
     bool    detected;
     int16_t xCenter;
@@ -13,9 +14,26 @@ struct HuskyResult {
     int16_t id;
 };
 
-void        huskyInit(HardwareSerial &port);
-void        huskyReconnect();      // re-init after relay power cycle
-bool        huskyConnected();
-void        huskySetTagMode();
-void        huskySetLineMode();
-HuskyResult huskyRead();           // poll once; returns latest result
+// One camera reply: every block (or arrow) it reported, in order.
+struct HuskyFrame {
+    uint8_t     count;                     // blocks kept (≤ HUSKY_MAX_BLOCKS)
+    uint8_t     total;                     // blocks the camera reported
+    bool        arrows;                    // line tracking reply
+    uint16_t    frameNo;                   // camera's own frame counter
+    uint32_t    captureMs;                 // millis() the request went out
+    HuskyResult blocks[HUSKY_MAX_BLOCKS];
+};
+
+// ── non-blocking driver (sensor task only) ──────────────────────────
+// Speaks the HuskyLens UART protocol directly: one request in flight,
+// replies parsed byte by byte from the RX buffer on every huskyPoll().
+void huskyInit(HardwareSerial &port);      // no I/O; the sensor hub probes
+void huskyReconnect();                     // forget the link (rail power cycle)
+bool huskyProbe();                         // queue a knock; true once it answered
+bool huskyConnected();
+void huskySetTagMode();                    // queued, sent when the link is idle
+void huskySetLineMode();
+bool huskyPoll(HuskyFrame &out);           // true = a complete new frame in out
+
+// id > 0: that learned ID; id == 0: first block of the frame
+HuskyResult huskyPick(const HuskyFrame &f, int16_t id);
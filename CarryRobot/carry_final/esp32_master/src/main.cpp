@@ -1,6 +1,13 @@
 // ====================================================================
 //  carry_final  –  ESP32 Master  –  main.cpp
 //  WiFiManager portal, MQTT, UART↔STM32, mode state machine
+//
+//  Tasks (config.h):
+//    core 0  net     MQTT connection, callback (e-stop), queued publishes
+//    core 1  link    UART2 frames → link queue (CMD_ESTOP_ACK handled here)
+//            ctrl    50 Hz: MQTT commands, STM32 frames, button, modes
+//            sensor  HuskyLens + SR05 + pan feedback → versioned snapshot
+//            ui      OLED, log flush
 // ====================================================================
 #include <Arduino.h>
 #include <WiFi.h>
@@ -18,11 +25,20 @@
 #include "huskylens_uart.h"
 #include "servo_control.h"
 #include "sr05.h"
+#include "sensors.h"
+#include "events.h"
 #include "mqtt_client.h"
 #include "auto_mode.h"
 #include "follow_mode.h"
 #include "find_mode.h"
 #include "recovery_mode.h"
+#include "estop.h"
+#include "stm32_telemetry.h"
+#include "stm32_regs.h"
+#include "stm32_params.h"
+#include "stm32_recorder.h"
+#include "tlog.h"
+#include "mission_kpi.h"
 
 // ── Hardware serial ports ───────────────────────────────────────────
 // STM32: dùng Serial2 toàn project (auto/follow/find/recovery) — tránh hai đối tượng UART2.
@@ -32,7 +48,7 @@ HardwareSerial SerialHusky(1);     // UART1  → HuskyLens
 static void startMqttPortal() {
     Serial.println("[BOOT] MQTT failed – opening portal to update MQTT IP");
     oledPortal(WM_AP_NAME, "192.168.4.1");
-    buzzerBeepN(2, 150, 80);
+    buzzerBeepN(2, 150, 80, BUZ_WARN);
 
     char savedSrv[64] = MQTT_DEFAULT_SERVER;
     {
@@ -106,80 +122,224 @@ static void startPortal(bool forcePortal) {
     }
 }
 
-// ── Process frames from STM32 ───────────────────────────────────────
-static void handleSTM32() {
-    uint8_t cmd, buf[UART_MAX_FRAME], len;
-    while (uartReceiveFrame(Serial2, cmd, buf, len)) {
-        switch (cmd) {
-        case CMD_BATTERY:
-            // tạm tắt – luôn giữ 100%
-            // if (len >= 1) g_batteryPercent = buf[0];
-            break;
-
-        case CMD_CHECKPOINT:
-            if (len >= 2) {
-                g_lastCheckpointId = ((uint16_t)buf[0] << 8) | buf[1];
-                g_newCheckpoint = true;
-                Serial.printf("[UART] <<< CHECKPOINT 0x%04X (%u)\n",
-                              g_lastCheckpointId, g_lastCheckpointId);
-            }
-            break;
-
-        case CMD_OBSTACLE:
-            g_stm32Obstacle = true;
-            buzzerBeep(600);  // obstacle warning
-            break;
-
-        case CMD_ACK:
-            // acknowledged – no action needed
-            break;
-
-        case CMD_MISSION_DONE:
-            g_stm32MissionDone = true;
-            g_stm32Obstacle    = false;
-            break;
-
-        case CMD_MISMATCH:
-            if (len >= 4) {
-                g_stm32MismatchGot  = ((uint16_t)buf[0] << 8) | buf[1];
-                g_stm32MismatchExp  = ((uint16_t)buf[2] << 8) | buf[3];
-                g_stm32MismatchFlag = true;
-            }
-            break;
+// ── STM32 announced a reset: restore its mode, resume any mission ───
+// The link is up before NFC/ToF are; a mission resume waits for
+// CMD_READY so the runner never starts blind.  REG_PERIPH is polled
+// meanwhile in case that frame is lost.
+static bool     s_resumePending = false;
+static uint8_t  s_resumeArgs[3];         // resumable, len, idx
+static uint32_t s_resumePollMs  = 0;
+
+static void resumeIfPending() {
+    if (!s_resumePending) return;
+    s_resumePending = false;
+    if (g_mode == MODE_AUTO)
+        autoModeStm32Reset(s_resumeArgs[0], s_resumeArgs[1], s_resumeArgs[2]);
+}
+
+static void onStm32Boot(const uint8_t *buf, uint8_t len) {
+    if (len < 5) return;
+    bool     resumable = buf[0] != 0;
+    uint16_t lastCp    = ((uint16_t)buf[3] << 8) | buf[4];
+    g_stm32Caps   = len >= 7 ? buf[5] : 0;
+    g_stm32Periph = len >= 7 ? buf[6] : BOOT_PERIPH_SETTLED;   // older firmware boots fully
+    LOGI(LM_UART, "<<< STM32 BOOT resumable=%u route=%u/%u lastCp=%u periph=0x%02X",
+         resumable, buf[2], buf[1], lastCp, g_stm32Periph);
+
+    uint8_t m = g_mode;
+    uartSendFrame(Serial2, CMD_SET_MODE, &m, 1);
+    s_resumePending = false;
+    if (g_mode == MODE_AUTO) {
+        if (g_stm32Periph & BOOT_PERIPH_SETTLED) {
+            autoModeStm32Reset(resumable, buf[1], buf[2]);
+        } else {
+            s_resumeArgs[0] = resumable;
+            s_resumeArgs[1] = buf[1];
+            s_resumeArgs[2] = buf[2];
+            s_resumePending = true;
+            s_resumePollMs  = millis();
+        }
+    }
+    stm32TelemetrySubscribe(STM32_TELEM_HZ);
+    stm32RegRead(REG_VERSION, REG_STATUS_LAST + 1);   // learn map version
+    stm32ParamsSync();
+    mqttPublishEvent("stm32_boot");
+}
+
+// ── STM32 peripherals settled (or their status changed) ─────────────
+static void onStm32Ready(const uint8_t *buf, uint8_t len) {
+    if (len < 4) return;
+    uint16_t ms = ((uint16_t)buf[2] << 8) | buf[3];
+    g_stm32Caps   = buf[0];
+    g_stm32Periph = buf[1];
+    relayOnStm32Ready(g_stm32Caps, g_stm32Periph);
+    LOGI(LM_UART, "<<< STM32 READY caps=0x%02X periph=0x%02X (%u ms)",
+         g_stm32Caps, g_stm32Periph, ms);
+    if ((g_stm32Caps & BOOT_CAP_NFC) && !(g_stm32Periph & BOOT_PERIPH_NFC))
+        LOGW(LM_UART, "STM32 NFC reader not responding");
+
+    resumeIfPending();
+    mqttPublishStm32Ready(g_stm32Caps, g_stm32Periph, ms);
+}
+
+// CMD_READY lost: a REG_PERIPH reply newer than the last poll decides
+static void resumePendingLoop() {
+    if (!s_resumePending) return;
+    uint32_t now = millis();
+    uint16_t periph;
+    if (stm32RegAgeMs(REG_PERIPH) <= now - s_resumePollMs &&
+        stm32RegGet(REG_PERIPH, periph) && (periph & BOOT_PERIPH_SETTLED)) {
+        g_stm32Periph = (uint8_t)periph;
+        LOGW(LM_UART, "no CMD_READY – REG_PERIPH=0x%02X settled, resuming", periph);
+        resumeIfPending();
+        return;
+    }
+    if (now - s_resumePollMs >= STM32_READY_POLL_MS) {
+        stm32RegRead(REG_PERIPH, 1);
+        s_resumePollMs = now;
+    }
+}
+
+static volatile bool s_portalReq = false;   // long press → net task
+
+// ── Process frames from STM32 (control task) ────────────────────────
+static void handleFrame(uint8_t cmd, uint8_t *buf, uint8_t len) {
+    switch (cmd) {
+    case CMD_BATTERY:
+        // tạm tắt – luôn giữ 100%
+        // if (len >= 1) g_batteryPercent = buf[0];
+        break;
+
+    case CMD_CHECKPOINT:
+        if (len >= 2) {
+            g_lastCheckpointId = ((uint16_t)buf[0] << 8) | buf[1];
+            g_routeEvents.push({ EV_CHECKPOINT, 0, g_lastCheckpointId, 0 });
+            LOGI(LM_UART, "<<< CHECKPOINT 0x%04X (%u)",
+                 g_lastCheckpointId, g_lastCheckpointId);
+        }
+        break;
+
+    case CMD_OBSTACLE:
+        g_stm32Obstacle = true;
+        buzzerBeep(600, BUZ_ALARM);  // obstacle warning – repeats coalesce
+        break;
+
+    case CMD_BOOT:
+        onStm32Boot(buf, len);
+        break;
+
+    case CMD_TELEMETRY:
+        stm32TelemetryDecode(buf, len);
+        break;
+
+    case CMD_REG_DATA:
+        stm32RegOnData(buf, len);
+        break;
+
+    case CMD_REG_WACK:
+        stm32RegOnWriteAck(buf, len);
+        break;
+
+    case CMD_PROF_DATA:
+        mqttPublishProfile(buf, len);
+        break;
+
+    case CMD_REC_FROZEN:
+        stm32RecorderOnFrozen(buf, len);
+        break;
+
+    case CMD_REC_CHUNK:
+        stm32RecorderOnChunk(buf, len);
+        break;
+
+    case CMD_LOG:
+        tlogForward(buf, len);
+        break;
 
-        case CMD_DEBUG_MSG:
-            if (len > 0) {
-                buf[len] = '\0';   // null-terminate
-                Serial.printf("[STM32] %s\n", (char*)buf);
+    case CMD_READY:
+        onStm32Ready(buf, len);
+        break;
+
+    case CMD_RUN_KPI:
+        kpiOnRunKpi(buf, len);
+        break;
+
+    case CMD_ACK:
+        // acknowledged – no action needed
+        break;
+
+    case CMD_MISSION_DONE:
+        g_routeEvents.push({ EV_MISSION_DONE, 0, 0, 0 });
+        g_stm32Obstacle = false;
+        break;
+
+    case CMD_MISMATCH:
+        if (len >= 4) {
+            uint16_t got = ((uint16_t)buf[0] << 8) | buf[1];
+            uint16_t exp = ((uint16_t)buf[2] << 8) | buf[3];
+            g_routeEvents.push({ EV_MISMATCH, 0, got, exp });
+        }
+        break;
+
+    case CMD_SKIPPED:
+        // STM32 matched a tag further down the route – the listed
+        // checkpoints were passed without a read; arrives before CHECKPOINT
+        if (len >= 1) {
+            uint8_t n = buf[0];
+            if (len < 1 + n * 2) break;
+            for (uint8_t i = 0; i < n; i++) {
+                uint16_t id = ((uint16_t)buf[1 + i * 2] << 8) | buf[2 + i * 2];
+                mqttPublishSkipped(id);
             }
-            break;
+            g_routeEvents.push({ EV_SKIPPED, n, 0, 0 });
+            LOGI(LM_UART, "<<< SKIPPED %u CP", n);
+        }
+        break;
 
-        case CMD_LINE_LOST:
-            Serial.println("[STM32] line lost");
-            mqttPublishEvent("line_lost");
-            break;
+    case CMD_VEL_TIMEOUT:
+        if (len >= 2) {
+            uint16_t age = ((uint16_t)buf[0] << 8) | buf[1];
+            LOGW(LM_UART, "STM32 velocity setpoint stale (%u ms) – stopping", age);
+        }
+        mqttPublishEvent("vel_timeout");
+        break;
 
-        default:
-            Serial.printf("[UART] unknown cmd 0x%02X\n", cmd);
+    case CMD_DEBUG_MSG:
+        if (len > 0) {
+            buf[len] = '\0';   // null-terminate
+            Serial.printf("[STM32] %s\n", (char*)buf);
         }
+        break;
+
+    case CMD_LINE_LOST:
+        LOGW(LM_UART, "STM32 line lost");
+        mqttPublishEvent("line_lost");
+        break;
+
+    default:
+        LOGW(LM_UART, "unknown cmd 0x%02X", cmd);
     }
 }
 
+static void drainLink() {
+    static LinkFrame f;   // 130 B, keep off the control stack
+    while (g_linkFrames.pop(f))
+        handleFrame(f.cmd, f.data, f.len);
+}
+
 // ── Mode switching (double click at MED + IDLE) ─────────────────────
 static void checkModeSwitch() {
-    if (!g_btnDoubleClick) return;
+    if (g_mode != MODE_AUTO || g_autoState != AUTO_IDLE) return;
+    if (!buttonTake(BTN_DOUBLE)) return;
 
-    if (g_mode == MODE_AUTO && g_autoState == AUTO_IDLE
-        && g_lastCheckpointId == MED_CHECKPOINT_ID) {
+    if (g_lastCheckpointId == MED_CHECKPOINT_ID) {
         // Auto → Follow (only when at MED and IDLE)
-        g_btnDoubleClick = false;
         g_mode = MODE_FOLLOW;
         followModeInit();
-        Serial.println("[MODE] AUTO → FOLLOW (at MED)");
-    } else if (g_mode == MODE_AUTO && g_autoState == AUTO_IDLE) {
-        g_btnDoubleClick = false;
-        buzzerBeepN(2);  // reject: not at MED
-        Serial.println("[MODE] switch rejected – not at MED");
+        LOGI(LM_MODE, "AUTO → FOLLOW (at MED)");
+    } else {
+        buzzerBeepN(2, 100, 100, BUZ_WARN);  // reject: not at MED
+        LOGW(LM_MODE, "switch rejected – not at MED");
     }
     // Follow/Find → Recovery is handled inside their own loops
 }
@@ -214,32 +374,162 @@ static void periodicTasks() {
     bool curMqtt = mqttIsConnected();
     if (prevMqtt && !curMqtt) {
         oledError("MQTT disconnected!");
-        buzzerBeep(200);
-        Serial.println("[MQTT] lost connection");
+        buzzerBeep(200, BUZ_WARN);
+        LOGW(LM_MQTT, "lost connection");
     }
     prevMqtt = curMqtt;
 }
 
+// ── Control step (50 Hz) ────────────────────────────────────────────
+static void controlStep() {
+    buttonLoop();
+    buttonNextGesture();
+    mqttProcessInbound();
+    drainLink();
+    resumePendingLoop();
+    stm32ParamsLoop();
+    stm32RecorderLoop();
+    relayLoop();
+    periodicTasks();
+    eventsCheckDrops();
+
+    // long press → force WiFi + MQTT portal (net task owns WiFi)
+    if (buttonTake(BTN_LONG)) {
+        Serial.println("[BTN] long press → force WiFi portal");
+        buzzerBeep(300);
+        s_portalReq = true;   // restarts after save
+    }
+
+    // mode switch check
+    checkModeSwitch();
+
+    // ── MQTT commands: mode change → call proper init here (safe stack) ──
+    CmdEvent ev;
+    while (g_cmdEvents.pop(ev)) {
+        if (ev.type == CMD_EV_FOLLOW_TAG) {
+            followModeLock(ev.arg);
+            continue;
+        }
+        if (ev.type != CMD_EV_SET_MODE) {
+            autoModeCommand(ev);
+            continue;
+        }
+        g_mode = (RobotMode)ev.arg;
+        switch (g_mode) {
+        case MODE_AUTO:     autoModeInit();     break;
+        case MODE_FOLLOW:   followModeInit();   break;
+        case MODE_FIND:     relaySetFollow();   break;   // find dùng relay giống follow
+        case MODE_RECOVERY: recoveryModeInit(); break;
+        }
+        LOGI(LM_MODE, "init after MQTT set_mode → %u", g_mode);
+    }
+
+    // mode-specific loop
+    switch (g_mode) {
+    case MODE_AUTO:     autoModeLoop();     break;
+    case MODE_FOLLOW:   followModeLoop();   g_routeEvents.clear(); break;
+    case MODE_FIND:     findModeLoop();     g_routeEvents.clear(); break;
+    case MODE_RECOVERY:
+        {
+            static bool recInited = false;
+            if (!recInited) { recoveryModeInit(); recInited = true; }
+            recoveryModeLoop();
+            if (g_mode != MODE_RECOVERY) recInited = false;
+        }
+        break;
+    }
+}
+
+// ====================================================================
+//  TASKS
+// ====================================================================
+static void controlTask(void *) {
+    TickType_t wake = xTaskGetTickCount();
+    uint32_t lastOverrunLog = 0;
+    for (;;) {
+        uint32_t t0 = millis();
+        controlStep();
+        uint32_t took = millis() - t0;
+        if (took > CTRL_TASK_MS && t0 - lastOverrunLog > 1000) {
+            lastOverrunLog = t0;
+            LOGW(LM_MAIN, "control step %u ms (budget %u)", took, CTRL_TASK_MS);
+        }
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(CTRL_TASK_MS));
+    }
+}
+
+// UART2 RX only; the e-stop ACK is timed here, the rest waits for ctrl
+static void linkTask(void *) {
+    LinkFrame f;
+    for (;;) {
+        while (uartReceiveFrame(Serial2, f.cmd, f.data, f.len)) {
+            if (f.cmd == CMD_ESTOP_ACK) {
+                estopOnAck(f.data, f.len);
+                continue;
+            }
+            g_linkFrames.push(f);     // full → counted, logged by ctrl
+        }
+        vTaskDelay(pdMS_TO_TICKS(LINK_TASK_MS));
+    }
+}
+
+static void netTask(void *) {
+    for (;;) {
+        if (s_portalReq) startPortal(true);
+        mqttLoop();
+        vTaskDelay(pdMS_TO_TICKS(NET_TASK_MS));
+    }
+}
+
+static void sensorTask(void *) {
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        sensorsPoll();
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(SENSOR_TASK_MS));
+    }
+}
+
+static void uiTask(void *) {
+    for (;;) {
+        oledService(UI_TASK_MS);
+        tlogFlush();
+    }
+}
+
+static void startTask(TaskFunction_t fn, const char *name, uint32_t stack,
+                      UBaseType_t prio, BaseType_t core) {
+    if (xTaskCreatePinnedToCore(fn, name, stack, nullptr, prio, nullptr, core) != pdPASS)
+        LOGE(LM_MAIN, "task %s not created", name);
+}
+
 // ====================================================================
 //  SETUP
 // ====================================================================
 void setup() {
+    Serial.setTxBufferSize(TLOG_TX_BUFFER);   // CMD_LOG frames drain in the driver
     Serial.begin(115200);
+    tlogInit();
     Serial.println("\n=== CarryFinal ESP32 Master ===");
 
-    // peripherals
+    // peripherals – UI task first so boot screens show up
     oledInit();
+    buzzerInit();
+    startTask(uiTask, "ui", UI_TASK_STACK, UI_TASK_PRIO, UI_TASK_CORE);
     oledSplash();
     relayInit();
     relayLineNfcOn();   // power PN532 + line sensors early so STM32 nfcInit() succeeds
-    buzzerInit();
     // batteryInit();      // tạm tắt battery
     g_batteryPercent = 100;
     buttonInit();
+    estopInit();
 
     // UARTs
     Serial2.begin(STM32_BAUD, SERIAL_8N1, PIN_STM32_RX, PIN_STM32_TX);
+    SerialHusky.setRxBufferSize(HUSKY_RX_BUF);
     SerialHusky.begin(HUSKY_BAUD, SERIAL_8N1, PIN_HUSKY_RX, PIN_HUSKY_TX);
+    stm32TelemetrySubscribe(STM32_TELEM_HZ);   // STM32 already up (ESP32-only reset)
+    stm32ParamsInit();
+    stm32ParamsSync();
 
     // WiFi — autoConnect (dùng creds đã lưu, hoặc mở portal nếu chưa có)
     oledBoot(false, false);
@@ -259,7 +549,6 @@ void setup() {
         }
     }
     if (mqttIsConnected()) {
-        g_mqttConnected = true;
         Serial.println("[BOOT] MQTT OK");
     } else {
         Serial.println("[BOOT] MQTT timeout – opening MQTT config portal");
@@ -271,58 +560,22 @@ void setup() {
     servoInit();
     sr05Init();
     huskyInit(SerialHusky);
+    sensorsInit();
 
     // default: Auto mode (only enter idle when both WiFi and MQTT are connected)
     autoModeInit();
     buzzerBeep(60);
+
+    startTask(netTask,     "net",    NET_TASK_STACK,    NET_TASK_PRIO,    NET_TASK_CORE);
+    startTask(linkTask,    "link",   LINK_TASK_STACK,   LINK_TASK_PRIO,   LINK_TASK_CORE);
+    startTask(sensorTask,  "sensor", SENSOR_TASK_STACK, SENSOR_TASK_PRIO, SENSOR_TASK_CORE);
+    startTask(controlTask, "ctrl",   CTRL_TASK_STACK,   CTRL_TASK_PRIO,   CTRL_TASK_CORE);
     Serial.println("[BOOT] ready");
 }
 
 // ====================================================================
-//  LOOP
+//  LOOP – everything runs in the tasks above
 // ====================================================================
 void loop() {
-    // always run
-    buttonLoop();
-    mqttLoop();
-    handleSTM32();
-    periodicTasks();
-
-    // long press → force WiFi + MQTT portal
-    if (g_btnLongPress) {
-        g_btnLongPress = false;
-        Serial.println("[BTN] long press → force WiFi portal");
-        buzzerBeep(300);
-        startPortal(true);   // restarts after save
-    }
-
-    // mode switch check
-    checkModeSwitch();
-
-    // ── MQTT requested mode change → call proper init here (safe stack) ──
-    if (g_modeChangeReq) {
-        g_modeChangeReq = false;
-        switch (g_mode) {
-        case MODE_AUTO:     autoModeInit();     break;
-        case MODE_FOLLOW:   followModeInit();   break;
-        case MODE_FIND:     relaySetFollow();   break;   // find dùng relay giống follow
-        case MODE_RECOVERY: recoveryModeInit(); break;
-        }
-        Serial.printf("[MODE] init after MQTT set_mode → %u\n", g_mode);
-    }
-
-    // mode-specific loop
-    switch (g_mode) {
-    case MODE_AUTO:     autoModeLoop();     break;
-    case MODE_FOLLOW:   followModeLoop();   break;
-    case MODE_FIND:     findModeLoop();     break;
-    case MODE_RECOVERY:
-        {
-            static bool recInited = false;
-            if (!recInited) { recoveryModeInit(); recInited = true; }
-            recoveryModeLoop();
-            if (g_mode != MODE_RECOVERY) recInited = false;
-        }
-        break;
-    }
+    vTaskDelete(nullptr);
 }
@@ -0,0 +1,103 @@
+#include "mission_kpi.h"
+#include "config.h"
+#include "globals.h"
+#include "uart_protocol.h"
+#include "tlog.h"
+
+struct KpiLeg {
+    uint16_t from;
+    uint16_t to;
+    uint32_t ms;
+};
+
+static bool     s_active   = false;
+static uint32_t s_startMs  = 0;
+static RunKpi   s_sum;                  // all runs of this mission, summed
+static uint8_t  s_runs     = 0;
+static uint8_t  s_mismatch = 0;
+static uint8_t  s_resumed  = 0;
+
+static KpiLeg   s_legs[KPI_MAX_LEGS];
+static uint8_t  s_legCount = 0;
+static uint16_t s_legFrom  = 0;
+static uint32_t s_legStart = 0;
+
+void kpiMissionStart() {
+    memset(&s_sum, 0, sizeof(s_sum));
+    s_runs     = 0;
+    s_mismatch = 0;
+    s_resumed  = 0;
+    s_legCount = 0;
+    s_startMs  = millis();
+    s_active   = true;
+}
+
+void kpiRunStart() {
+    s_legFrom  = g_lastCheckpointId;
+    s_legStart = millis();
+}
+
+void kpiCheckpoint(uint16_t id) {
+    if (!s_active) return;
+    uint32_t now = millis();
+    if (s_legCount < KPI_MAX_LEGS)
+        s_legs[s_legCount++] = { s_legFrom, id, now - s_legStart };
+    s_legFrom  = id;
+    s_legStart = now;
+}
+
+void kpiOnRunKpi(const uint8_t *data, uint8_t len) {
+    if (len < sizeof(RunKpi)) return;
+    RunKpi k;
+    memcpy(&k, data, sizeof(k));
+    LOGI(LM_AUTO, "run kpi end=%u %lu ms, follow %lu turn %lu obst %lu lost %lu",
+         k.end, (unsigned long)k.runMs, (unsigned long)k.followMs,
+         (unsigned long)k.turnMs, (unsigned long)k.obstacleMs,
+         (unsigned long)k.lineLostMs);
+    if (!s_active) return;
+
+    s_runs++;
+    if (k.end == KPI_END_MISMATCH)       s_mismatch++;
+    if (k.flags & KPI_FLAG_RESUMED)      s_resumed++;
+    s_sum.runMs       += k.runMs;
+    s_sum.followMs    += k.followMs;
+    s_sum.turnMs      += k.turnMs;
+    s_sum.obstacleMs  += k.obstacleMs;
+    s_sum.lineLostMs  += k.lineLostMs;
+    s_sum.lineLost    += k.lineLost;
+    s_sum.obstacles   += k.obstacles;
+    s_sum.nfcReads    += k.nfcReads;
+    s_sum.nfcHits     += k.nfcHits;
+    s_sum.checkpoints += k.checkpoints;
+    s_sum.skipped     += k.skipped;
+}
+
+// ,"kpi":{"t":..,"run":..,"wait":..,"follow":..,"turn":..,"obst":..,"lost":..,
+//         "lostN":..,"obstN":..,"nfc":[reads,hits],"cp":..,"skip":..,"mm":..,
+//         "runs":..,"resumed":..,"legs":[[from,to,ms],...]}
+int kpiToJson(char *buf, size_t size) {
+    if (!s_active) return 0;
+    s_active = false;
+
+    uint32_t total = millis() - s_startMs;
+    uint32_t wait  = total > s_sum.runMs ? total - s_sum.runMs : 0;
+    int n = snprintf(buf, size,
+        ",\"kpi\":{\"t\":%lu,\"run\":%lu,\"wait\":%lu,\"follow\":%lu,\"turn\":%lu,"
+        "\"obst\":%lu,\"lost\":%lu,\"lostN\":%u,\"obstN\":%u,\"nfc\":[%u,%u],"
+        "\"cp\":%u,\"skip\":%u,\"mm\":%u,\"runs\":%u,\"resumed\":%u,\"legs\":[",
+        (unsigned long)total, (unsigned long)s_sum.runMs, (unsigned long)wait,
+        (unsigned long)s_sum.followMs, (unsigned long)s_sum.turnMs,
+        (unsigned long)s_sum.obstacleMs, (unsigned long)s_sum.lineLostMs,
+        s_sum.lineLost, s_sum.obstacles, s_sum.nfcReads, s_sum.nfcHits,
+        s_sum.checkpoints, s_sum.skipped, s_mismatch, s_runs, s_resumed);
+    for (uint8_t i = 0; i < s_legCount && n > 0 && (size_t)n < size - 32; i++) {
+        n += snprintf(buf + n, size - n, "%s[%u,%u,%lu]", i ? "," : "",
+                      s_legs[i].from, s_legs[i].to, (unsigned long)s_legs[i].ms);
+    }
+    if (n > 0 && (size_t)n < size - 3) n += snprintf(buf + n, size - n, "]}");
+    if (n <= 0 || (size_t)n >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return n;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <Arduino.h>
+
+// ── Per-mission KPI accounting ──────────────────────────────────────
+// A mission (outbound run, wait at the bed, return run, re-routes) is
+// summed from the STM32's CMD_RUN_KPI frames plus the legs timed here
+// between consecutive checkpoint reports, and attached to mission_done.
+
+void kpiMissionStart();                              // button start
+void kpiRunStart();                                  // route sent to STM32 – leg timer restarts
+void kpiCheckpoint(uint16_t id);                     // checkpoint reported – closes a leg
+void kpiOnRunKpi(const uint8_t *data, uint8_t len);  // CMD_RUN_KPI
+
+// Appends  ,"kpi":{...}  to buf; returns chars written (0 = no mission).
+int  kpiToJson(char *buf, size_t size);
@@ -1,15 +1,23 @@
 #include "mqtt_client.h"
 #include "globals.h"
 #include "relay_control.h"
-#include "sr05.h"
+#include "sensors.h"
+#include "events.h"
 #include "auto_mode.h"
 #include "follow_mode.h"
 #include "recovery_mode.h"
-#include "huskylens_uart.h"
+#include "estop.h"
+#include "stm32_telemetry.h"
+#include "stm32_regs.h"
+#include "stm32_params.h"
+#include "stm32_recorder.h"
+#include "tlog.h"
+#include "mission_kpi.h"
 #include <WiFi.h>
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
 #include <Preferences.h>
+#include "freertos/ringbuf.h"
 
 // ── internal state ──────────────────────────────────────────────────
 static WiFiClient   wifiClient;
@@ -20,6 +28,15 @@ static char         s_user[32]    = MQTT_DEFAULT_USER;
 static char         s_pass[32]    = MQTT_DEFAULT_PASS;
 static uint32_t     s_lastTry     = 0;
 
+// ── task hand-off ───────────────────────────────────────────────────
+// PubSubClient belongs to the net task.  Commands are copied into s_rx
+// and parsed on the control task; publishes from any task are queued in
+// s_tx (item = topic pointer + NUL-terminated payload) and sent by the
+// net task.  Only stop / resume act straight from the callback.
+static RingbufHandle_t s_rx = nullptr;
+static RingbufHandle_t s_tx = nullptr;
+static uint32_t     s_lastDropLog = 0;
+
 // ── topics — khớp backend mqttService.js carry stack bridge ─────────
 // ESP32 publishes events → backend subscribes
 static const char *T_EVT         = "carry/robot/evt";
@@ -28,6 +45,27 @@ static const char *T_RETURN_REQ  = "robot/return_request";
 // Backend publishes commands → ESP32 subscribes
 static const char *T_CMD         = "carry/robot/cmd";
 
+static void logDrop(const char *what) {
+    uint32_t now = millis();
+    if (now - s_lastDropLog < 1000) return;
+    s_lastDropLog = now;
+    LOGW(LM_MQTT, "%s ring full – dropped", what);
+}
+
+static bool publish(const char *topic, const char *payload) {
+    if (!s_tx || !g_mqttConnected) return false;
+    size_t n = strlen(payload) + 1;
+    void *item;
+    if (xRingbufferSendAcquire(s_tx, &item, sizeof(topic) + n, 0) != pdTRUE) {
+        logDrop("tx");
+        return false;
+    }
+    memcpy(item, &topic, sizeof(topic));
+    memcpy((char *)item + sizeof(topic), payload, n);
+    xRingbufferSendComplete(s_tx, item);
+    return true;
+}
+
 // ── helper: convert "XX:XX:XX:XX" rfidUid → uint16 (last 2 bytes) ──
 static uint16_t uidStringToId(const char *uid) {
     // Parse colon-separated hex, take last 2 bytes
@@ -44,17 +82,87 @@ static uint16_t uidStringToId(const char *uid) {
     return ((uint16_t)bytes[count - 2] << 8) | bytes[count - 1];
 }
 
+// ── helper: route action → CMD_SEND_ROUTE action byte ───────────────
+// Accepts the protocol char ('F','L','<',…) or a name for the
+// holonomic legs / arcs ("SL", "SR", "REV", "HOLD", "ARC_L", "ARC_R").
+// Unknown → 'F'.
+static uint8_t parseRouteAction(const char *s) {
+    static const struct { const char *name; uint8_t act; } NAMES[] = {
+        { "SL",    ROUTE_ACT_STRAFE_L }, { "SR",    ROUTE_ACT_STRAFE_R },
+        { "REV",   ROUTE_ACT_REVERSE  }, { "HOLD",  ROUTE_ACT_HOLD     },
+        { "ARC_L", ROUTE_ACT_ARC_L    }, { "ARC_R", ROUTE_ACT_ARC_R    },
+    };
+    if (!s || !*s) return ROUTE_ACT_FWD;
+    if (!s[1] && strchr("FLRBS<>VHlr", s[0])) return (uint8_t)s[0];
+    for (const auto &n : NAMES)
+        if (strcasecmp(s, n.name) == 0) return n.act;
+    LOGW(LM_MQTT, "unknown route action '%s' → F", s);
+    return ROUTE_ACT_FWD;
+}
+
+// optional "actions" next to "ids": "FF<FV" or ["F","SL",…]
+static void applyRouteActions(JsonVariant acts) {
+    if (acts.is<const char*>()) {
+        const char *s = acts.as<const char*>();
+        for (uint8_t i = 0; i < g_routeLen && s[i]; i++) {
+            char one[2] = { s[i], 0 };
+            g_route[i].action = parseRouteAction(one);
+        }
+    } else if (acts.is<JsonArray>()) {
+        uint8_t i = 0;
+        for (JsonVariant v : acts.as<JsonArray>()) {
+            if (i >= g_routeLen) break;
+            g_route[i++].action = parseRouteAction(v | "F");
+        }
+    }
+}
+
+// optional "arcs" next to "ids": [[idx, radius cm, speed], …]
+static void applyRouteArcs(JsonArray arcs) {
+    for (JsonArray a : arcs) {
+        uint8_t i = a[0] | 0xFF;
+        if (i >= g_routeLen) continue;
+        g_route[i].arcRadius = a[1] | 0;
+        g_route[i].arcSpeed  = a[2] | 0;
+    }
+}
+
 // ── parse CMD from backend ──────────────────────────────────────────
 // Backend sends on "carry/robot/cmd":
 //   Route assign:  {"action":"route","missionId":"...","patient":"...","destination":"...","ids":[0x8083,...]}
 //   Return route:  {"action":"return_route","ids":[0x8083,...]}
+//                  both take optional "actions":"FFl<V" (default all 'F')
+//                  and "arcs":[[idx,radiusCm,speed],...] for 'l'/'r' points
 //   Cancel:        {"action":"cancel"}
 //   Mission assign (full): {"mission":{"missionId":"...","patientName":"...","bedId":"...","outboundRoute":[{"rfidUid":"XX:XX:XX:XX","action":"F",...}],...}}
+// STM32 log modules – mirrors LogModule in stm32_slave/src/tlog.h
+static const char *const STM32_LOG_NAMES[] = {
+    "MAIN", "UART", "RUN", "LINE", "NFC", "TOF", "VEL", "ESTOP",
+    "STORE", "PARAM", "REC", "PROF", "REG", "TELEM",
+};
+#define STM32_LOG_MODULES  ((uint8_t)(sizeof(STM32_LOG_NAMES) / sizeof(STM32_LOG_NAMES[0])))
+
+// name / index / "*" → module index; "*" returns the module count (= all)
+static int logModuleIndex(JsonVariant v, bool stm32) {
+    uint8_t count = stm32 ? STM32_LOG_MODULES : (uint8_t)LM_COUNT;
+    if (v.is<int>()) {
+        int i = v.as<int>();
+        return (i >= 0 && i < count) ? i : -1;
+    }
+    const char *name = v | "*";
+    if (strcmp(name, "*") == 0) return count;
+    for (uint8_t i = 0; i < count; i++) {
+        const char *n = stm32 ? STM32_LOG_NAMES[i] : tlogModuleName(i);
+        if (strcasecmp(name, n) == 0) return i;
+    }
+    return -1;
+}
+
 static void parseCmdMsg(const uint8_t *payload, unsigned int len) {
     static StaticJsonDocument<MQTT_BUFFER_SIZE> doc;   // static: avoid 4KB stack alloc
     doc.clear();
     DeserializationError err = deserializeJson(doc, payload, len);
-    if (err) { Serial.printf("[MQTT] JSON err: %s\n", err.c_str()); return; }
+    if (err) { LOGW(LM_MQTT, "JSON err: %s", err.c_str()); return; }
 
     // ── Format 1: simple carry stack {"action":"route","ids":[...]} ──
     const char *action = doc["action"] | (const char*)nullptr;
@@ -67,23 +175,24 @@ static void parseCmdMsg(const uint8_t *payload, unsigned int len) {
             g_routeLen = 0;
             for (JsonVariant v : ids) {
                 if (g_routeLen >= MAX_ROUTE_LEN) break;
-                g_route[g_routeLen].checkpointId = v.as<uint16_t>();
-                g_route[g_routeLen].action = 'F';
+                g_route[g_routeLen] = { v.as<uint16_t>(), ROUTE_ACT_FWD, 0, 0 };
                 g_routeLen++;
             }
+            applyRouteActions(doc["actions"]);
+            applyRouteArcs(doc["arcs"]);
             g_routeIdx = 0;
             if (g_mode == MODE_AUTO) {
                 if (g_autoState == AUTO_RUNNING) {
-                    g_mqttCancel = true;
-                    Serial.println("[MQTT] new route while running → cancel old");
+                    g_cmdEvents.push({ CMD_EV_PREEMPT, 0 });
+                    LOGI(LM_MQTT, "new route while running → cancel old");
                 }
                 g_autoState = AUTO_WAIT_START;
             }
-            Serial.printf("[MQTT] route (ids): %d pts\n", g_routeLen);
+            LOGI(LM_MQTT, "route (ids): %d pts", g_routeLen);
             // publish accept
             char buf[48];
             snprintf(buf, sizeof(buf), "{\"evt\":\"route_accept\",\"n\":%u}", g_routeLen);
-            mqtt.publish(T_EVT, buf);
+            publish(T_EVT, buf);
             return;
         }
         if (strcmp(action, "return_route") == 0) {
@@ -91,55 +200,52 @@ static void parseCmdMsg(const uint8_t *payload, unsigned int len) {
             g_routeLen = 0;
             for (JsonVariant v : ids) {
                 if (g_routeLen >= MAX_ROUTE_LEN) break;
-                g_route[g_routeLen].checkpointId = v.as<uint16_t>();
-                g_route[g_routeLen].action = 'F';
+                g_route[g_routeLen] = { v.as<uint16_t>(), ROUTE_ACT_FWD, 0, 0 };
                 g_routeLen++;
             }
+            applyRouteActions(doc["actions"]);
+            applyRouteArcs(doc["arcs"]);
             g_routeIdx = 0;
             if (g_mode == MODE_AUTO) g_autoState = AUTO_RETURNING;
-            Serial.printf("[MQTT] return route (ids): %d pts\n", g_routeLen);
+            LOGI(LM_MQTT, "return route (ids): %d pts", g_routeLen);
             return;
         }
         if (strcmp(action, "cancel") == 0) {
             if (g_mode == MODE_AUTO &&
                 (g_autoState == AUTO_RUNNING || g_autoState == AUTO_WAIT_START)) {
-                g_mqttCancel = true;
+                g_cmdEvents.push({ CMD_EV_CANCEL, 0 });
             }
-            Serial.println("[MQTT] cancel requested");
+            LOGI(LM_MQTT, "cancel requested");
             return;
         }
 
         // ─── start: simulate button press to begin mission ──────────
         if (strcmp(action, "start") == 0) {
-            g_btnSingleClick = true;
-            Serial.println("[MQTT] start → simulating button");
+            g_btnEvents.push(BTN_SINGLE);
+            LOGI(LM_MQTT, "start → simulating button");
             return;
         }
 
-        // ─── stop: emergency stop ───────────────────────────────────
-        if (strcmp(action, "stop") == 0) {
-            g_stopped = true;
-            g_running = false;
-            Serial.println("[MQTT] stop");
-            return;
-        }
+        // stop / resume never get here – see handleUrgent()
 
-        // ─── resume: clear stop flag ────────────────────────────────
-        if (strcmp(action, "resume") == 0) {
-            g_stopped = false;
-            Serial.println("[MQTT] resume");
+        // ─── set_mode: control loop switches mode + runs its init ───
+        if (strcmp(action, "set_mode") == 0) {
+            const char *m = doc["mode"] | "";
+            RobotMode mode = g_mode;
+            if (strcmp(m, "auto") == 0)          mode = MODE_AUTO;
+            else if (strcmp(m, "follow") == 0)   mode = MODE_FOLLOW;
+            else if (strcmp(m, "find") == 0)     mode = MODE_FIND;
+            else if (strcmp(m, "recovery") == 0) mode = MODE_RECOVERY;
+            g_cmdEvents.push({ CMD_EV_SET_MODE, mode });   // main loop sẽ gọi init + relay
+            LOGI(LM_MQTT, "set_mode → %s", m);
             return;
         }
 
-        // ─── set_mode: set mode + flag, main loop handles init ─────
-        if (strcmp(action, "set_mode") == 0) {
-            const char *m = doc["mode"] | "";
-            if (strcmp(m, "auto") == 0)          g_mode = MODE_AUTO;
-            else if (strcmp(m, "follow") == 0)   g_mode = MODE_FOLLOW;
-            else if (strcmp(m, "find") == 0)     g_mode = MODE_FIND;
-            else if (strcmp(m, "recovery") == 0) g_mode = MODE_RECOVERY;
-            g_modeChangeReq = true;   // main loop sẽ gọi init + relay
-            Serial.printf("[MQTT] set_mode → %s\n", m);
+        // ─── follow_tag: tag ID Follow locks onto (0 = first seen) ──
+        if (strcmp(action, "follow_tag") == 0) {
+            uint8_t id = doc["id"] | 0;
+            g_cmdEvents.push({ CMD_EV_FOLLOW_TAG, id });
+            LOGI(LM_MQTT, "follow_tag → %u", id);
             return;
         }
 
@@ -148,15 +254,108 @@ static void parseCmdMsg(const uint8_t *payload, unsigned int len) {
             if (doc.containsKey("spinMs"))  g_tuneSpinMs  = doc["spinMs"].as<uint16_t>();
             if (doc.containsKey("brakeMs")) g_tuneBrakeMs = doc["brakeMs"].as<uint16_t>();
             if (doc.containsKey("wallCm"))  g_tuneWallCm  = doc["wallCm"].as<uint16_t>();
-            Serial.printf("[MQTT] tune_turn spin=%u brake=%u wall=%u\n",
-                          g_tuneSpinMs, g_tuneBrakeMs, g_tuneWallCm);
+            // spin/brake are executed by the STM32 turn/brake routines
+            if (doc.containsKey("spinMs"))  stm32ParamsSetByName("turn90Ms", g_tuneSpinMs);
+            if (doc.containsKey("brakeMs")) stm32ParamsSetByName("brakeMs",  g_tuneBrakeMs);
+            if (doc.containsKey("spinMs") || doc.containsKey("brakeMs")) stm32ParamsCommit();
+            LOGI(LM_MQTT, "tune_turn spin=%u brake=%u wall=%u",
+                 g_tuneSpinMs, g_tuneBrakeMs, g_tuneWallCm);
+            return;
+        }
+
+        // ─── tune_params / tune_get / tune_reset: STM32 parameter table ──
+        // {"action":"tune_params","params":{"runSpeed":180,"kp":0.4}}
+        if (strcmp(action, "tune_params") == 0) {
+            uint8_t n = 0;
+            for (JsonPair kv : doc["params"].as<JsonObject>()) {
+                if (stm32ParamsSetByName(kv.key().c_str(), kv.value().as<float>())) n++;
+                else LOGW(LM_MQTT, "tune_params: '%s' rejected", kv.key().c_str());
+            }
+            if (n && !stm32ParamsCommit()) {
+                mqttPublishEvent("tune_rejected");
+                n = 0;
+            }
+            LOGI(LM_MQTT, "tune_params %u set", n);
+            return;
+        }
+        // ─── prof_dump: STM32 cycle-counter profile ─────────────────
+        // {"action":"prof_dump","reset":true}
+        if (strcmp(action, "prof_dump") == 0) {
+            uint8_t flags = (doc["reset"] | false) ? 0x01 : 0x00;
+            uartSendFrame(Serial2, CMD_PROF_DUMP, &flags, 1);
+            LOGI(LM_MQTT, "prof_dump");
+            return;
+        }
+
+        // ─── rec_dump: freeze + download the STM32 flight recorder ──
+        if (strcmp(action, "rec_dump") == 0) {
+            stm32RecorderRequest();
+            LOGI(LM_MQTT, "rec_dump");
+            return;
+        }
+
+        if (strcmp(action, "tune_get") == 0) {
+            stm32ParamsRequest();
+            return;
+        }
+        if (strcmp(action, "tune_reset") == 0) {
+            stm32ParamsReset();
+            LOGI(LM_MQTT, "tune_reset → STM32 defaults");
+            return;
+        }
+
+        // ─── reg_read / reg_write: STM32 register map passthrough ───
+        // {"action":"reg_read","start":32,"count":12}
+        // {"action":"reg_write","start":64,"values":[1]}
+        if (strcmp(action, "reg_read") == 0) {
+            uint8_t start = doc["start"] | 0;
+            uint8_t count = doc["count"] | 1;
+            stm32RegRead(start, min(count, (uint8_t)REG_BATCH_MAX));
+            LOGI(LM_MQTT, "reg_read 0x%02X+%u", start, count);
+            return;
+        }
+        if (strcmp(action, "reg_write") == 0) {
+            uint8_t  start = doc["start"] | 0;
+            uint16_t vals[REG_BATCH_MAX];
+            uint8_t  n = 0;
+            for (JsonVariant v : doc["values"].as<JsonArray>()) {
+                if (n >= REG_BATCH_MAX) break;
+                vals[n++] = v.as<uint16_t>();
+            }
+            if (n) stm32RegWrite(start, vals, n);
+            LOGI(LM_MQTT, "reg_write 0x%02X+%u", start, n);
+            return;
+        }
+
+        // ─── log_level: runtime level per module (0 off … 4 debug) ──
+        // {"action":"log_level","src":"stm32","module":"NFC","level":4}
+        // module: name, index or "*" (all); src defaults to "esp32"
+        if (strcmp(action, "log_level") == 0) {
+            const char *src   = doc["src"] | "esp32";
+            uint8_t     level = min((uint8_t)(doc["level"] | LOG_INF), (uint8_t)LOG_DBG);
+            bool        stm   = strcmp(src, "stm32") == 0;
+            int         mod   = logModuleIndex(doc["module"], stm);
+            if (mod < 0) {
+                LOGW(LM_MQTT, "log_level: unknown module");
+                return;
+            }
+            if (!stm) {
+                tlogSetLevel(mod, level);
+            } else if (mod >= STM32_LOG_MODULES) {
+                uint16_t vals[STM32_LOG_MODULES];
+                for (uint8_t i = 0; i < STM32_LOG_MODULES; i++) vals[i] = level;
+                stm32RegWrite(REG_LOG_LEVEL_BASE, vals, STM32_LOG_MODULES);
+            } else {
+                stm32RegWrite1(REG_LOG_LEVEL_BASE + mod, level);
+            }
+            LOGI(LM_MQTT, "log_level %s module %d → %u", src, mod, level);
             return;
         }
 
         // ─── test_dashboard: toggle OLED test view ──────────────────
         if (strcmp(action, "test_dashboard") == 0) {
             g_testDashboard = doc["enabled"] | false;
-            Serial.printf("[MQTT] test_dashboard %s\n", g_testDashboard ? "ON" : "OFF");
+            LOGI(LM_MQTT, "test_dashboard %s", g_testDashboard ? "ON" : "OFF");
             return;
         }
 
@@ -167,29 +366,29 @@ static void parseCmdMsg(const uint8_t *payload, unsigned int len) {
             if (strcmp(which, "vision") == 0) { on ? relayVisionOn() : relayVisionOff(); }
             else if (strcmp(which, "line") == 0) { on ? relayLineOn() : relayLineOff(); }
             else if (strcmp(which, "nfc") == 0)  { on ? relayNfcOn()  : relayNfcOff();  }
-            Serial.printf("[MQTT] relay %s → %s\n", which, on ? "ON" : "OFF");
+            LOGI(LM_MQTT, "relay %s → %s", which, on ? "ON" : "OFF");
             // ack back
             char buf[64];
             snprintf(buf, sizeof(buf), "{\"evt\":\"relay_ack\",\"which\":\"%s\",\"on\":%s}",
                      which, on ? "true" : "false");
-            mqtt.publish(T_EVT, buf);
+            publish(T_EVT, buf);
             return;
         }
 
         // ─── relay_resume: restore relays per current mode ──────────
         if (strcmp(action, "relay_resume") == 0) {
             if (g_mode == MODE_AUTO)        relaySetAuto();
-            else if (g_mode == MODE_FOLLOW) { relaySetFollow(); huskyReconnect(); }
-            else                            { relaySetRecovery(); huskyReconnect(); }
-            Serial.println("[MQTT] relay_resume + module reinit");
-            mqtt.publish(T_EVT, "{\"evt\":\"relay_resume\"}");
+            else if (g_mode == MODE_FOLLOW) { relaySetFollow();   sensorsCommand(SENSOR_HUSKY_RECONNECT); }
+            else                            { relaySetRecovery(); sensorsCommand(SENSOR_HUSKY_RECONNECT); }
+            LOGI(LM_MQTT, "relay_resume + module reinit");
+            publish(T_EVT, "{\"evt\":\"relay_resume\"}");
             return;
         }
 
         // ─── status: publish current state ──────────────────────────
         if (strcmp(action, "status") == 0) {
             mqttPublishTelemetry();
-            Serial.println("[MQTT] status requested");
+            LOGI(LM_MQTT, "status requested");
             return;
         }
     }
@@ -213,37 +412,66 @@ static void parseCmdMsg(const uint8_t *payload, unsigned int len) {
             } else {
                 g_route[g_routeLen].checkpointId = p["id"] | 0;
             }
-            const char *act = p["action"] | "F";
-            g_route[g_routeLen].action = act[0];
+            g_route[g_routeLen].action    = parseRouteAction(p["action"] | "F");
+            g_route[g_routeLen].arcRadius = p["arcRadius"] | 0;
+            g_route[g_routeLen].arcSpeed  = p["arcSpeed"]  | 0;
             g_routeLen++;
         }
         g_routeIdx = 0;
 
         if (g_mode == MODE_AUTO) {
             if (g_autoState == AUTO_RUNNING) {
-                g_mqttCancel = true;
-                Serial.println("[MQTT] new mission while running → cancel old");
+                g_cmdEvents.push({ CMD_EV_PREEMPT, 0 });
+                LOGI(LM_MQTT, "new mission while running → cancel old");
             }
             g_autoState = AUTO_WAIT_START;
         }
-        Serial.printf("[MQTT] mission: %d pts  patient=%s  bed=%s\n",
-                      g_routeLen, g_patientName, g_destination);
+        LOGI(LM_MQTT, "mission: %d pts  patient=%s  bed=%s",
+             g_routeLen, g_patientName, g_destination);
 
         char buf[48];
         snprintf(buf, sizeof(buf), "{\"evt\":\"route_accept\",\"n\":%u}", g_routeLen);
-        mqtt.publish(T_EVT, buf);
+        publish(T_EVT, buf);
         return;
     }
 
     Serial.printf("[MQTT] unhandled cmd: %.*s\n", min(len, 120u), payload);
 }
 
-// ── MQTT callback ───────────────────────────────────────────────────
-static void callback(char *topic, byte *payload, unsigned int len) {
-    Serial.printf("[MQTT] << %s (%u B)\n", topic, len);
-    if (strcmp(topic, T_CMD) == 0) {
-        parseCmdMsg(payload, len);
+// ── stop / resume: act in the callback (net task) ───────────────────
+// The e-stop budget is the network, not the 20 ms control tick.  Only
+// the two keys are parsed; the CMD_ESTOP frame is a single Serial2 write,
+// which the UART driver keeps whole against the control task's frames.
+static bool handleUrgent(const uint8_t *payload, unsigned int len) {
+    StaticJsonDocument<32> filter;
+    filter["action"] = true;
+    filter["ts"]     = true;
+    StaticJsonDocument<96> doc;
+    if (deserializeJson(doc, payload, len, DeserializationOption::Filter(filter)))
+        return false;
+    const char *action = doc["action"] | "";
+
+    // ─── stop: emergency stop → STM32 immediately ───────────────────
+    if (strcmp(action, "stop") == 0) {
+        estopEngage(doc["ts"] | 0.0);
+        LOGI(LM_MQTT, "stop");
+        return true;
     }
+    // ─── resume: release e-stop latch ───────────────────────────────
+    if (strcmp(action, "resume") == 0) {
+        estopRelease();
+        LOGI(LM_MQTT, "resume");
+        return true;
+    }
+    return false;
+}
+
+// ── MQTT callback (net task) ────────────────────────────────────────
+static void callback(char *topic, byte *payload, unsigned int len) {
+    LOGD(LM_MQTT, "<< %s (%u B)", topic, len);
+    if (strcmp(topic, T_CMD) != 0) return;
+    if (handleUrgent(payload, len)) return;
+    if (xRingbufferSend(s_rx, payload, len, 0) != pdTRUE) logDrop("rx");
 }
 
 // ── connect / reconnect ─────────────────────────────────────────────
@@ -255,20 +483,22 @@ static bool reconnect() {
 
     char clientId[32];
     snprintf(clientId, sizeof(clientId), "robot-%lu", (unsigned long)now);
-    Serial.printf("[MQTT] connecting %s:%d …\n", s_server, s_port);
+    LOGD(LM_MQTT, "connecting %s:%d …", s_server, s_port);
 
     if (mqtt.connect(clientId, s_user, s_pass)) {
-        Serial.println("[MQTT] connected");
+        LOGI(LM_MQTT, "connected");
         mqtt.subscribe(T_CMD, 1);
         g_mqttConnected = true;
         return true;
     }
-    Serial.printf("[MQTT] failed rc=%d\n", mqtt.state());
+    LOGW(LM_MQTT, "failed rc=%d", mqtt.state());
     g_mqttConnected = false;
     return false;
 }
 
 // ── public API ──────────────────────────────────────────────────────
+static void publishRegs(uint8_t start, uint8_t count, const uint16_t *vals);
+
 void mqttInit() {
     Preferences prefs;
     prefs.begin(NVS_NAMESPACE, true);
@@ -281,70 +511,219 @@ void mqttInit() {
     mqtt.setServer(s_server, s_port);
     mqtt.setBufferSize(MQTT_BUFFER_SIZE);
     mqtt.setCallback(callback);
+    stm32RegSetDataHook(publishRegs);
+    s_rx = xRingbufferCreate(MQTT_RX_RING, RINGBUF_TYPE_NOSPLIT);
+    s_tx = xRingbufferCreate(MQTT_TX_RING, RINGBUF_TYPE_NOSPLIT);
 }
 
 void mqttLoop() {
     if (!mqtt.connected()) reconnect();
     mqtt.loop();
+    g_mqttConnected = mqtt.connected();
+
+    size_t size;
+    char *item;
+    while ((item = (char *)xRingbufferReceive(s_tx, &size, 0)) != nullptr) {
+        const char *topic;
+        memcpy(&topic, item, sizeof(topic));
+        if (g_mqttConnected) mqtt.publish(topic, item + sizeof(topic));
+        vRingbufferReturnItem(s_tx, item);
+    }
+}
+
+void mqttProcessInbound() {
+    size_t size;
+    uint8_t *item;
+    while ((item = (uint8_t *)xRingbufferReceive(s_rx, &size, 0)) != nullptr) {
+        parseCmdMsg(item, size);
+        vRingbufferReturnItem(s_rx, item);
+    }
 }
 
-bool mqttIsConnected() { return mqtt.connected(); }
+bool mqttIsConnected() { return g_mqttConnected; }
 
 // ── publish events to backend (carry/robot/evt) ─────────────────────
 // Format: {"evt":"checkpoint","id":32899}
 void mqttPublishCheckpoint(uint16_t cpId) {
     char buf[64];
     snprintf(buf, sizeof(buf), "{\"evt\":\"checkpoint\",\"id\":%u}", cpId);
-    mqtt.publish(T_EVT, buf);
+    publish(T_EVT, buf);
 }
 
 // Format: {"evt":"idle_scan","id":32899}  — idle NFC scan (no status change)
 void mqttPublishIdleScan(uint16_t cpId) {
     char buf[64];
     snprintf(buf, sizeof(buf), "{\"evt\":\"idle_scan\",\"id\":%u}", cpId);
-    mqtt.publish(T_EVT, buf);
+    publish(T_EVT, buf);
+}
+
+// Format: {"evt":"cp_skipped","id":32899}  — passed without NFC read
+void mqttPublishSkipped(uint16_t cpId) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "{\"evt\":\"cp_skipped\",\"id\":%u}", cpId);
+    publish(T_EVT, buf);
+}
+
+// Format: {"evt":"regs","v":1,"start":32,"vals":[12,0,...]}
+static void publishRegs(uint8_t start, uint8_t count, const uint16_t *vals) {
+    if (!g_mqttConnected) return;
+    char buf[48 + REG_BATCH_MAX * 6];
+    int n = snprintf(buf, sizeof(buf), "{\"evt\":\"regs\",\"v\":%u,\"start\":%u,\"vals\":[",
+                     stm32RegVersion(), start);
+    for (uint8_t i = 0; i < count && n < (int)sizeof(buf) - 8; i++)
+        n += snprintf(buf + n, sizeof(buf) - n, i ? ",%u" : "%u", vals[i]);
+    snprintf(buf + n, sizeof(buf) - n, "]}");
+    publish(T_EVT, buf);
+
+    // parameter block read → also publish it by name
+    // Format: {"evt":"params","p":{"runSpeed":200,"kp":0.350,...}}
+    if (start <= REG_PARAM_BASE && start + count > REG_PARAM_LAST) {
+        char p[320];
+        if (stm32ParamsToJson(p, sizeof(p))) {
+            char out[360];
+            snprintf(out, sizeof(out), "{\"evt\":\"params\",\"p\":%s}", p);
+            publish(T_EVT, out);
+        }
+    }
+}
+
+// Format: {"evt":"prof","probe":"line","n":1234,"minUs":41.2,"meanUs":55.0,
+//          "maxUs":180.3,"hist":[0,0,1200,34,0,0,0,0]}
+void mqttPublishProfile(const uint8_t *data, uint8_t len) {
+    static const char *names[PROF_COUNT] = {
+        "uart", "line", "nfc", "tof", "print", "loop"
+    };
+    if (len < sizeof(ProfRecord)) return;
+    ProfRecord r;
+    memcpy(&r, data, sizeof(r));
+
+    if (r.probes == 0) {
+        LOGW(LM_PROF, "STM32 built without USE_PROFILER");
+        mqttPublishEvent("prof_disabled");
+        return;
+    }
+    if (r.probe >= PROF_COUNT || r.cpuMhz == 0) return;
+
+    float mhz = r.cpuMhz;
+    LOGI(LM_PROF, "%-5s n=%lu min=%.1f mean=%.1f max=%.1f us",
+         names[r.probe], (unsigned long)r.count,
+         r.minCyc / mhz, r.meanCyc / mhz, r.maxCyc / mhz);
+    if (!g_mqttConnected) return;
+
+    char buf[256];
+    int n = snprintf(buf, sizeof(buf),
+        "{\"evt\":\"prof\",\"probe\":\"%s\",\"n\":%lu,"
+        "\"minUs\":%.1f,\"meanUs\":%.1f,\"maxUs\":%.1f,\"hist\":[",
+        names[r.probe], (unsigned long)r.count,
+        r.minCyc / mhz, r.meanCyc / mhz, r.maxCyc / mhz);
+    for (uint8_t i = 0; i < PROF_BUCKETS; i++)
+        n += snprintf(buf + n, sizeof(buf) - n, i ? ",%u" : "%u", r.hist[i]);
+    snprintf(buf + n, sizeof(buf) - n, "]}");
+    publish(T_EVT, buf);
+}
+
+// Format: {"evt":"stm32_ready","caps":119,"periph":131,"ms":412}
+void mqttPublishStm32Ready(uint8_t caps, uint8_t periph, uint16_t ms) {
+    char buf[80];
+    snprintf(buf, sizeof(buf),
+             "{\"evt\":\"stm32_ready\",\"caps\":%u,\"periph\":%u,\"ms\":%u}",
+             caps, periph, ms);
+    publish(T_EVT, buf);
+}
+
+// Format: {"evt":"power_ready","rail":"vision","ok":true,"ms":840}
+void mqttPublishPowerReady(const char *rail, bool ok, uint32_t ms) {
+    char buf[80];
+    snprintf(buf, sizeof(buf),
+             "{\"evt\":\"power_ready\",\"rail\":\"%s\",\"ok\":%s,\"ms\":%lu}",
+             rail, ok ? "true" : "false", (unsigned long)ms);
+    publish(T_EVT, buf);
+}
+
+// Format: {"evt":"rec_frozen","reason":2,"samples":256,"arg":0}
+void mqttPublishRecFrozen(uint8_t reason, uint16_t samples, uint16_t arg) {
+    char buf[96];
+    snprintf(buf, sizeof(buf),
+             "{\"evt\":\"rec_frozen\",\"reason\":%u,\"samples\":%u,\"arg\":%u}",
+             reason, samples, arg);
+    publish(T_EVT, buf);
+}
+
+// Format: {"evt":"rec_chunk","reason":2,"i":0,"n":32,
+//          "s":[[tMs,lineBits,runState,err,fl,fr,bl,br,tofMm,ev,arg],...]}
+bool mqttPublishRecChunk(uint8_t reason, uint8_t chunk, uint8_t chunks,
+                         const RecSample *s, uint8_t n) {
+    if (!g_mqttConnected) return false;
+    char buf[96 + REC_CHUNK_SAMPLES * 64];
+    int len = snprintf(buf, sizeof(buf),
+                       "{\"evt\":\"rec_chunk\",\"reason\":%u,\"i\":%u,\"n\":%u,\"s\":[",
+                       reason, chunk, chunks);
+    for (uint8_t k = 0; k < n && len < (int)sizeof(buf) - 64; k++) {
+        const RecSample &r = s[k];
+        len += snprintf(buf + len, sizeof(buf) - len,
+                        "%s[%u,%u,%u,%d,%d,%d,%d,%d,%u,%u,%u]", k ? "," : "",
+                        r.tMs, r.lineState & 0x07, r.lineState >> 3, r.lineErr,
+                        r.wheel[0] * 2, r.wheel[1] * 2, r.wheel[2] * 2, r.wheel[3] * 2,
+                        r.tof4mm * 4, r.event, r.arg);
+    }
+    snprintf(buf + len, sizeof(buf) - len, "]}");
+    return publish(T_EVT, buf);
 }
 
 // Format: {"evt":"battery","pct":85}
 void mqttPublishBattery(uint8_t pct) {
     char buf[48];
     snprintf(buf, sizeof(buf), "{\"evt\":\"battery\",\"pct\":%u}", pct);
-    mqtt.publish(T_EVT, buf);
+    publish(T_EVT, buf);
 }
 
 // Format: {"checkpoint_id":32899}  on topic "robot/return_request"
 void mqttPublishReturnRequest(uint16_t cpId) {
     char buf[48];
     snprintf(buf, sizeof(buf), "{\"checkpoint_id\":%u}", cpId);
-    mqtt.publish(T_RETURN_REQ, buf);
+    publish(T_RETURN_REQ, buf);
 }
 
 // Format: {"evt":"..."}
 void mqttPublishStatus(const char *status) {
     char buf[80];
     snprintf(buf, sizeof(buf), "{\"evt\":\"%s\"}", status);
-    mqtt.publish(T_EVT, buf);
+    publish(T_EVT, buf);
 }
 
 // Format: {"evt":"mission_done"}
+// Format: {"evt":"mission_done","mission":"..","success":true,"kpi":{..}}
+//   kpi – see mission_kpi.cpp
 void mqttPublishMissionDone(const char *missionId, bool success) {
-    char buf[96];
-    snprintf(buf, sizeof(buf), "{\"evt\":\"mission_done\",\"mission\":\"%s\",\"success\":%s}",
-             missionId, success ? "true" : "false");
-    mqtt.publish(T_EVT, buf);
+    static char buf[384 + KPI_MAX_LEGS * 24];
+    int n = snprintf(buf, sizeof(buf), "{\"evt\":\"mission_done\",\"mission\":\"%s\",\"success\":%s",
+                     missionId, success ? "true" : "false");
+    n += kpiToJson(buf + n, sizeof(buf) - n - 2);
+    snprintf(buf + n, sizeof(buf) - n, "}");
+    publish(T_EVT, buf);
 }
 
 // ── generic sensor/system event ─────────────────────────────────────
 void mqttPublishEvent(const char *evt) {
-    if (!mqtt.connected()) return;
+    if (!g_mqttConnected) return;
     char buf[96];
     snprintf(buf, sizeof(buf), "{\"evt\":\"%s\"}", evt);
-    mqtt.publish(T_EVT, buf);
+    publish(T_EVT, buf);
+}
+
+// Format: {"evt":"estop_ack","ts":<dashboard ms>,"rttUs":..,"cutUs":..,"src":1}
+//   rttUs = ESP32 MQTT rx → STM32 ACK rx, cutUs = STM32 frame → motors off
+void mqttPublishEstopAck(double dashTs, uint32_t rttUs, uint16_t cutUs, uint8_t src) {
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+             "{\"evt\":\"estop_ack\",\"ts\":%.0f,\"rttUs\":%lu,\"cutUs\":%u,\"src\":%u}",
+             dashTs, (unsigned long)rttUs, cutUs, src);
+    publish(T_EVT, buf);
 }
 
 // Format: {"evt":"telemetry","debug":{...}} — periodic sensor snapshot for test lab
 void mqttPublishTelemetry() {
-    if (!mqtt.connected()) return;
+    if (!g_mqttConnected) return;
 
     static const char *modeNames[] = { "auto", "follow", "find", "recovery" };
     const char *modeName = (g_mode < 4) ? modeNames[g_mode] : "?";
@@ -358,28 +737,51 @@ void mqttPublishTelemetry() {
     }
     g_running = running;
 
-    // Read SR05 distances (cached or live - they're cheap on ESP32 side)
-    float sr05L = sr05ReadLeft();
-    float sr05R = sr05ReadRight();
+    // SR05 / pan feedback from the sensor hub snapshot (0 / -1 = none, vision off)
+    SensorSnapshot ss;
+    sensorsSnapshot(ss);
+    bool wallFresh = sensorFresh(ss.wallMs);
+    float sr05L = wallFresh ? ss.wallL : 0.0f;
+    float sr05R = wallFresh ? ss.wallR : 0.0f;
+    int   panFb = sensorFresh(ss.panMs) ? (int)ss.panDeg : -1;
 
-    char buf[300];
-    snprintf(buf, sizeof(buf),
+    // STM32 side from the binary telemetry stream (-1 when stale)
+    const Stm32Telemetry &st = stm32Telemetry();
+    bool stFresh = stm32TelemetryFresh();
+
+    char buf[600];
+    int n = snprintf(buf, sizeof(buf),
         "{\"evt\":\"telemetry\",\"debug\":{"
         "\"battEsp\":%u,"
-        "\"tofMm\":0,"
+        "\"tofMm\":%d,"
         "\"sr05L\":%.0f,"
         "\"sr05R\":%.0f,"
-        "\"line\":0,"
+        "\"panFb\":%d,"
+        "\"snapRetry\":%lu,"
+        "\"line\":%d,"
+        "\"lineErr\":%.2f,"
+        "\"stmState\":%d,"
+        "\"stmRoute\":%u,"
+        "\"loopUs\":%u,"
+        "\"loopMaxUs\":%u,"
+        "\"telDrop\":%lu,"
         "\"spinMs\":%u,"
         "\"brakeMs\":%u,"
         "\"wallCm\":%u,"
         "\"mode\":\"%s\","
         "\"run\":%s,"
         "\"testDash\":%s,"
-        "\"r1\":%d,\"r2\":%d,\"r3\":%d"
-        "}}",
+        "\"r1\":%d,\"r2\":%d,\"r3\":%d,",
         g_batteryPercent,
+        stFresh ? (int)st.f.tofMm : -1,
         sr05L, sr05R,
+        panFb, (unsigned long)sensorsRetries(),
+        stFresh ? (int)st.f.lineBits : -1,
+        st.f.lineErr / 100.0f,
+        stFresh ? (int)st.f.runState : -1,
+        st.f.routeIdx,
+        st.f.loopUs, st.f.loopMaxUs,
+        (unsigned long)st.dropped,
         g_tuneSpinMs, g_tuneBrakeMs, g_tuneWallCm,
         modeName,
         running ? "true" : "false",
@@ -387,5 +789,10 @@ void mqttPublishTelemetry() {
         relayGetVision() ? 1 : 0,
         relayGetLine()   ? 1 : 0,
         relayGetNfc()    ? 1 : 0);
-    mqtt.publish(T_EVT, buf);
+    // event queue high-water marks: [hw, capacity, drops]
+    if (n > 0 && n < (int)sizeof(buf))
+        n += eventsFormatStats(buf + n, sizeof(buf) - n);
+    if (n > 0 && n < (int)sizeof(buf) - 2) strcpy(buf + n, "}}");
+    else return;
+    publish(T_EVT, buf);
 }
@@ -1,15 +1,25 @@
 #pragma once
 #include <Arduino.h>
+#include "uart_protocol.h"
 #include "config.h"
 
 void mqttInit();
-void mqttLoop();             // call frequently
+void mqttLoop();             // net task: connection, callback, queued publishes
+void mqttProcessInbound();   // control task: parse queued carry/robot/cmd messages
 bool mqttIsConnected();
 void mqttPublishCheckpoint(uint16_t cpId);
 void mqttPublishIdleScan(uint16_t cpId);
+void mqttPublishSkipped(uint16_t cpId);
 void mqttPublishBattery(uint8_t pct);
 void mqttPublishReturnRequest(uint16_t cpId);
 void mqttPublishStatus(const char *status);
 void mqttPublishMissionDone(const char *missionId, bool success);
 void mqttPublishEvent(const char *evt);     // generic sensor/system event
 void mqttPublishTelemetry();   // periodic debug telemetry for test lab
+void mqttPublishEstopAck(double dashTs, uint32_t rttUs, uint16_t cutUs, uint8_t src);
+void mqttPublishProfile(const uint8_t *data, uint8_t len);   // CMD_PROF_DATA
+void mqttPublishStm32Ready(uint8_t caps, uint8_t periph, uint16_t ms);   // CMD_READY
+void mqttPublishPowerReady(const char *rail, bool ok, uint32_t ms);
+void mqttPublishRecFrozen(uint8_t reason, uint16_t samples, uint16_t arg);
+bool mqttPublishRecChunk(uint8_t reason, uint8_t chunk, uint8_t chunks,
+                         const RecSample *s, uint8_t n);   // false = not queued
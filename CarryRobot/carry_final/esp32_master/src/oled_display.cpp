@@ -1,11 +1,58 @@
 #include "oled_display.h"
 #include "globals.h"
 #include "config.h"
+#include "stm32_telemetry.h"
 #include <U8g2lib.h>
 #include <Wire.h>
 
 static U8G2_SH1106_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, U8X8_PIN_NONE);
 
+// ── screen requests ─────────────────────────────────────────────────
+// The public oled*() calls only fill a request and overwrite the
+// one-slot mailbox; the UI task keeps the newest one as the retained
+// screen (oledService), renders it into the RAM frame and sends only
+// the tiles that differ from what the panel already shows.
+enum OledScreen : uint8_t {
+    SCR_SPLASH, SCR_BOOT, SCR_IDLE, SCR_AUTO_WAIT_START, SCR_AUTO_RUNNING,
+    SCR_AUTO_WAIT_RETURN, SCR_AUTO_RETURNING, SCR_FOLLOW, SCR_FIND,
+    SCR_RECOVERY, SCR_OBSTACLE, SCR_PORTAL, SCR_BATTERY_LOW, SCR_ERROR
+};
+
+struct OledReq {
+    OledScreen screen;
+    int16_t    a, b, c;
+    float      f1, f2;
+    char       s1[32];
+    char       s2[24];
+};
+
+static QueueHandle_t s_req = nullptr;
+
+// retained screen + what the panel shows (UI task only)
+static OledReq  s_cur = {};
+static bool     s_have    = false;
+static bool     s_dirty   = false;
+static uint32_t s_flushMs = 0;
+static uint8_t  s_shadow[128 * 64 / 8];
+static bool     s_shadowOk = false;
+
+static OledReq request(OledScreen screen) {
+    OledReq r = {};
+    r.screen = screen;
+    return r;
+}
+
+static void post(const OledReq &r) {
+    if (s_req) xQueueOverwrite(s_req, &r);
+}
+
+// field by field: padding and bytes past the strings' NUL are undefined
+static bool sameReq(const OledReq &x, const OledReq &y) {
+    return x.screen == y.screen && x.a == y.a && x.b == y.b && x.c == y.c &&
+           x.f1 == y.f1 && x.f2 == y.f2 &&
+           strcmp(x.s1, y.s1) == 0 && strcmp(x.s2, y.s2) == 0;
+}
+
 // ── helpers ─────────────────────────────────────────────────────────
 static void header(const char *title) {
     u8g2.setFont(u8g2_font_6x10_tr);
@@ -22,158 +69,295 @@ static void statusBar() {
     u8g2.drawStr(0, 63, buf);
 }
 
-// ── public functions ────────────────────────────────────────────────
-void oledInit() {
-    u8g2.begin();
-    u8g2.setContrast(200);
-}
-
-void oledSplash() {
+// ── drawing (UI task) ───────────────────────────────────────────────
+static void drawSplash(const OledReq &) {
     u8g2.clearBuffer();
     u8g2.setFont(u8g2_font_ncenB10_tr);
     u8g2.drawStr(10, 30, "CarryFinal");
     u8g2.setFont(u8g2_font_5x7_tr);
     u8g2.drawStr(30, 50, "ESP32 Master");
-    u8g2.sendBuffer();
 }
 
-void oledBoot(bool wifi, bool mqtt) {
+static void drawBoot(const OledReq &r) {
     u8g2.clearBuffer();
     header("BOOT");
     u8g2.setFont(u8g2_font_6x10_tr);
-    u8g2.drawStr(0, 28, wifi  ? "WiFi:  OK" : "WiFi:  ...");
-    u8g2.drawStr(0, 42, mqtt  ? "MQTT:  OK" : "MQTT:  ...");
-    u8g2.sendBuffer();
+    u8g2.drawStr(0, 28, r.a   ? "WiFi:  OK" : "WiFi:  ...");
+    u8g2.drawStr(0, 42, r.b   ? "MQTT:  OK" : "MQTT:  ...");
 }
 
-void oledIdle() {
+static void drawIdle(const OledReq &) {
     u8g2.clearBuffer();
     header("AUTO  -  IDLE");
     u8g2.setFont(u8g2_font_6x10_tr);
     u8g2.drawStr(0, 30, "Waiting for route...");
     statusBar();
-    u8g2.sendBuffer();
 }
 
-void oledAutoWaitStart(const char *patient, const char *dest, uint8_t totalCp) {
+static void drawAutoWaitStart(const OledReq &r) {
     u8g2.clearBuffer();
     header("AUTO  -  Route Ready");
     u8g2.setFont(u8g2_font_5x7_tr);
     char buf[40];
-    snprintf(buf, sizeof(buf), "Patient: %s", patient);
+    snprintf(buf, sizeof(buf), "Patient: %s", r.s1);
     u8g2.drawStr(0, 26, buf);
-    snprintf(buf, sizeof(buf), "Dest: %s  CP:%u", dest, totalCp);
+    snprintf(buf, sizeof(buf), "Dest: %s  CP:%u", r.s2, (unsigned)r.a);
     u8g2.drawStr(0, 38, buf);
     u8g2.drawStr(0, 52, ">> Press BTN to START");
     statusBar();
-    u8g2.sendBuffer();
 }
 
-void oledAutoRunning(uint8_t cpIdx, uint8_t totalCp, const char *dest) {
+static void drawAutoRunning(const OledReq &r) {
     u8g2.clearBuffer();
     header("AUTO  -  Running");
     u8g2.setFont(u8g2_font_6x10_tr);
     char buf[40];
-    snprintf(buf, sizeof(buf), "CP: %u / %u", cpIdx, totalCp);
+    snprintf(buf, sizeof(buf), "CP: %u / %u", (unsigned)r.a, (unsigned)r.b);
     u8g2.drawStr(0, 30, buf);
-    snprintf(buf, sizeof(buf), "-> %s", dest);
+    snprintf(buf, sizeof(buf), "-> %s", r.s2);
     u8g2.drawStr(0, 44, buf);
     statusBar();
-    u8g2.sendBuffer();
 }
 
-void oledAutoWaitReturn() {
+static void drawAutoWaitReturn(const OledReq &) {
     u8g2.clearBuffer();
     header("AUTO  -  Arrived");
     u8g2.setFont(u8g2_font_6x10_tr);
     u8g2.drawStr(0, 30, "Delivery done.");
     u8g2.drawStr(0, 44, ">> Press BTN to return");
     statusBar();
-    u8g2.sendBuffer();
 }
 
-void oledAutoReturning(uint8_t cpIdx, uint8_t totalCp) {
+static void drawAutoReturning(const OledReq &r) {
     u8g2.clearBuffer();
     header("AUTO  -  Returning");
     u8g2.setFont(u8g2_font_6x10_tr);
     char buf[32];
-    snprintf(buf, sizeof(buf), "CP: %u / %u", cpIdx, totalCp);
+    snprintf(buf, sizeof(buf), "CP: %u / %u", (unsigned)r.a, (unsigned)r.b);
     u8g2.drawStr(0, 30, buf);
     u8g2.drawStr(0, 44, "-> MED (home)");
     statusBar();
-    u8g2.sendBuffer();
 }
 
-void oledFollowMode(int tagX, int tagY, int area, float wallL, float wallR) {
+static void drawFollowMode(const OledReq &r) {
     u8g2.clearBuffer();
     header("FOLLOW");
     u8g2.setFont(u8g2_font_5x7_tr);
     char buf[40];
-    snprintf(buf, sizeof(buf), "Tag x:%d y:%d a:%d", tagX, tagY, area);
+    snprintf(buf, sizeof(buf), "Tag %d  %+d deg  %d cm", r.a, r.b, r.c);
     u8g2.drawStr(0, 26, buf);
-    snprintf(buf, sizeof(buf), "WallL:%.0f  WallR:%.0f", wallL, wallR);
+    snprintf(buf, sizeof(buf), "WallL:%.0f  WallR:%.0f", r.f1, r.f2);
     u8g2.drawStr(0, 38, buf);
     statusBar();
-    u8g2.sendBuffer();
 }
 
-void oledFindMode(uint8_t attempts) {
+static void drawFindMode(const OledReq &r) {
     u8g2.clearBuffer();
     header("FIND  -  Searching");
     u8g2.setFont(u8g2_font_6x10_tr);
     char buf[32];
-    snprintf(buf, sizeof(buf), "Attempts: %u / 3", attempts);
+    snprintf(buf, sizeof(buf), "Attempts: %u / 3", (unsigned)r.a);
     u8g2.drawStr(0, 30, buf);
     statusBar();
-    u8g2.sendBuffer();
 }
 
-void oledRecovery(const char *phase) {
+static void drawRecovery(const OledReq &r) {
     u8g2.clearBuffer();
     header("RECOVERY");
     u8g2.setFont(u8g2_font_6x10_tr);
-    u8g2.drawStr(0, 30, phase);
+    u8g2.drawStr(0, 30, r.s1);
     statusBar();
-    u8g2.sendBuffer();
 }
 
-void oledObstacle() {
+static void drawObstacle(const OledReq &r) {
     u8g2.clearBuffer();
     header("!! OBSTACLE !!");
     u8g2.setFont(u8g2_font_6x10_tr);
     u8g2.drawStr(0, 35, "Waiting for clear...");
+    if (r.a >= 0) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "ToF: %d mm", r.a);
+        u8g2.drawStr(0, 47, buf);
+    }
     statusBar();
-    u8g2.sendBuffer();
 }
 
-void oledPortal(const char *apName, const char *ip) {
+static void drawPortal(const OledReq &r) {
     u8g2.clearBuffer();
     header("WiFiManager Portal");
     u8g2.setFont(u8g2_font_5x7_tr);
     char buf[40];
-    snprintf(buf, sizeof(buf), "AP: %s", apName);
+    snprintf(buf, sizeof(buf), "AP: %s", r.s1);
     u8g2.drawStr(0, 28, buf);
-    snprintf(buf, sizeof(buf), "IP: %s", ip);
+    snprintf(buf, sizeof(buf), "IP: %s", r.s2);
     u8g2.drawStr(0, 40, buf);
     u8g2.drawStr(0, 54, "Connect & configure");
-    u8g2.sendBuffer();
 }
 
-void oledBatteryLow(uint8_t pct) {
+static void drawBatteryLow(const OledReq &r) {
     u8g2.clearBuffer();
     header("LOW BATTERY");
     u8g2.setFont(u8g2_font_6x10_tr);
     char buf[32];
-    snprintf(buf, sizeof(buf), "Battery: %u%%", pct);
+    snprintf(buf, sizeof(buf), "Battery: %u%%", (unsigned)r.a);
     u8g2.drawStr(0, 35, buf);
     u8g2.drawStr(0, 50, "Commands blocked!");
-    u8g2.sendBuffer();
 }
 
-void oledError(const char *msg) {
+static void drawError(const OledReq &r) {
     u8g2.clearBuffer();
     header("ERROR");
     u8g2.setFont(u8g2_font_6x10_tr);
-    u8g2.drawStr(0, 35, msg);
-    u8g2.sendBuffer();
+    u8g2.drawStr(0, 35, r.s1);
+}
+
+// ── page diff: push only the changed tiles of each page ─────────────
+// Buffer layout (full-frame, R0): one page = 8 pixel rows = tw tiles
+// of 8 bytes.  Each page sends one run from its first to its last
+// changed tile; an unchanged frame sends nothing.
+static void flushChanged() {
+    const uint8_t *buf = u8g2.getBufferPtr();
+    uint8_t tw = u8g2.getBufferTileWidth();
+    uint8_t th = u8g2.getBufferTileHeight();
+
+    for (uint8_t ty = 0; ty < th; ty++) {
+        const uint8_t *row = buf + ty * tw * 8;
+        uint8_t       *old = s_shadow + ty * tw * 8;
+        int first = -1, last = -1;
+        for (uint8_t tx = 0; tx < tw; tx++) {
+            if (s_shadowOk && memcmp(row + tx * 8, old + tx * 8, 8) == 0) continue;
+            if (first < 0) first = tx;
+            last = tx;
+        }
+        if (first < 0) continue;
+        u8g2.updateDisplayArea(first, ty, last - first + 1, 1);
+        memcpy(old + first * 8, row + first * 8, (last - first + 1) * 8);
+    }
+    s_shadowOk = true;
+}
+
+static void render(const OledReq &r) {
+    switch (r.screen) {
+    case SCR_SPLASH:           drawSplash(r);          break;
+    case SCR_BOOT:             drawBoot(r);            break;
+    case SCR_IDLE:             drawIdle(r);            break;
+    case SCR_AUTO_WAIT_START:  drawAutoWaitStart(r);   break;
+    case SCR_AUTO_RUNNING:     drawAutoRunning(r);     break;
+    case SCR_AUTO_WAIT_RETURN: drawAutoWaitReturn(r);  break;
+    case SCR_AUTO_RETURNING:   drawAutoReturning(r);   break;
+    case SCR_FOLLOW:           drawFollowMode(r);      break;
+    case SCR_FIND:             drawFindMode(r);        break;
+    case SCR_RECOVERY:         drawRecovery(r);        break;
+    case SCR_OBSTACLE:         drawObstacle(r);        break;
+    case SCR_PORTAL:           drawPortal(r);          break;
+    case SCR_BATTERY_LOW:      drawBatteryLow(r);      break;
+    case SCR_ERROR:            drawError(r);           break;
+    }
+}
+
+// ── UI task: retain the newest request, redraw within the frame budget
+void oledService(uint32_t waitMs) {
+    OledReq r;
+    if (xQueueReceive(s_req, &r, pdMS_TO_TICKS(waitMs)) == pdTRUE &&
+        (!s_have || !sameReq(r, s_cur))) {
+        s_cur   = r;
+        s_have  = true;
+        s_dirty = true;
+    }
+    if (!s_have) return;
+
+    // same request: redraw only for the status bar (battery / MQTT)
+    uint32_t now = millis();
+    if (!s_dirty && now - s_flushMs < OLED_REFRESH_MS) return;
+    if (now - s_flushMs < OLED_FRAME_MS) return;
+
+    render(s_cur);
+    flushChanged();
+    s_flushMs = now;
+    s_dirty   = false;
+}
+
+// ── public functions (any task) ─────────────────────────────────────
+void oledInit() {
+    u8g2.setBusClock(OLED_I2C_HZ);
+    u8g2.begin();
+    u8g2.setContrast(200);
+    s_req = xQueueCreate(1, sizeof(OledReq));
+}
+
+void oledSplash() { post(request(SCR_SPLASH)); }
+
+void oledBoot(bool wifi, bool mqtt) {
+    OledReq r = request(SCR_BOOT);
+    r.a = wifi; r.b = mqtt;
+    post(r);
+}
+
+void oledIdle() { post(request(SCR_IDLE)); }
+
+void oledAutoWaitStart(const char *patient, const char *dest, uint8_t totalCp) {
+    OledReq r = request(SCR_AUTO_WAIT_START);
+    strlcpy(r.s1, patient, sizeof(r.s1));
+    strlcpy(r.s2, dest, sizeof(r.s2));
+    r.a = totalCp;
+    post(r);
+}
+
+void oledAutoRunning(uint8_t cpIdx, uint8_t totalCp, const char *dest) {
+    OledReq r = request(SCR_AUTO_RUNNING);
+    r.a = cpIdx; r.b = totalCp;
+    strlcpy(r.s2, dest, sizeof(r.s2));
+    post(r);
+}
+
+void oledAutoWaitReturn() { post(request(SCR_AUTO_WAIT_RETURN)); }
+
+void oledAutoReturning(uint8_t cpIdx, uint8_t totalCp) {
+    OledReq r = request(SCR_AUTO_RETURNING);
+    r.a = cpIdx; r.b = totalCp;
+    post(r);
+}
+
+void oledFollowMode(int tagId, int bearingDeg, int rangeCm, float wallL, float wallR) {
+    OledReq r = request(SCR_FOLLOW);
+    r.a = tagId; r.b = bearingDeg; r.c = rangeCm;
+    r.f1 = wallL; r.f2 = wallR;
+    post(r);
+}
+
+void oledFindMode(uint8_t attempts) {
+    OledReq r = request(SCR_FIND);
+    r.a = attempts;
+    post(r);
+}
+
+void oledRecovery(const char *phase) {
+    OledReq r = request(SCR_RECOVERY);
+    strlcpy(r.s1, phase, sizeof(r.s1));
+    post(r);
+}
+
+void oledObstacle() {
+    OledReq r = request(SCR_OBSTACLE);
+    r.a = stm32TelemetryFresh() ? (int16_t)stm32Telemetry().f.tofMm : -1;
+    post(r);
+}
+
+void oledPortal(const char *apName, const char *ip) {
+    OledReq r = request(SCR_PORTAL);
+    strlcpy(r.s1, apName, sizeof(r.s1));
+    strlcpy(r.s2, ip, sizeof(r.s2));
+    post(r);
+}
+
+void oledBatteryLow(uint8_t pct) {
+    OledReq r = request(SCR_BATTERY_LOW);
+    r.a = pct;
+    post(r);
+}
+
+void oledError(const char *msg) {
+    OledReq r = request(SCR_ERROR);
+    strlcpy(r.s1, msg, sizeof(r.s1));
+    post(r);
 }
@@ -3,11 +3,13 @@
 #include "config.h"
 #include "relay_control.h"
 #include "uart_protocol.h"
-#include "huskylens_uart.h"
+#include "sensors.h"
+#include "events.h"
 #include "servo_control.h"
 #include "oled_display.h"
 #include "mqtt_client.h"
 #include "buzzer.h"
+#include "tlog.h"
 
 extern HardwareSerial Serial2;
 
@@ -29,6 +31,15 @@ static uint32_t lastMs     = 0;
 static uint32_t cpTimeout  = 0;
 static uint32_t routeTimeout = 0;
 
+// ── next checkpoint event from the STM32 (other route events dropped) ─
+static bool takeCheckpoint(uint16_t &id) {
+    RouteEvent ev;
+    while (g_routeEvents.pop(ev)) {
+        if (ev.type == EV_CHECKPOINT) { id = ev.id; return true; }
+    }
+    return false;
+}
+
 // ── send velocity ───────────────────────────────────────────────────
 static void sendVel(int16_t vx, int16_t vy, int16_t vr) {
     uint8_t buf[6];
@@ -42,26 +53,28 @@ static void stopSTM32() { sendVel(0, 0, 0); }
 // ──────────────────────────────────────────────────────────────────
 void recoveryModeInit() {
     stopSTM32();
-    relaySetRecovery();
-    huskyReconnect();   // re-init after relay vision powered on
+    relaySetRecovery();  // sensor task probes HuskyLens when R1 comes up
 
     servoSetY(100);
     servoSetX(SERVO_X_CENTER);
-    huskySetLineMode();
+    sensorsCommand(SENSOR_HUSKY_LINE);
 
     phase      = REC_FIND_LINE;
+    g_routeEvents.clear();
     sweepAngle = 0;
     sweepDir   = 1;
     sweepRetry = 0;
     lastMs     = millis();
 
     oledRecovery("Finding line...");
-    Serial.println("[RECOVERY] init – finding line");
+    LOGI(LM_RECOVERY, "init – finding line");
 }
 
 void recoveryModeLoop() {
     if (g_mode != MODE_RECOVERY) return;
     uint32_t now = millis();
+    if (phase != REC_ALIGN_LINE && phase != REC_READ_CHECKPOINT)
+        g_routeEvents.clear();      // only the NFC phases listen for checkpoints
 
     switch (phase) {
 
@@ -74,20 +87,21 @@ void recoveryModeLoop() {
             if (sweepAngle < 0) {
                 // full sweep done (0→180→0), no line found
                 sweepRetry++;
-                buzzerBeepN(3);
-                Serial.printf("[RECOVERY] sweep fail #%u\n", sweepRetry);
+                buzzerBeepN(3, 100, 100, BUZ_WARN);
+                LOGW(LM_RECOVERY, "sweep fail #%u", sweepRetry);
                 if (sweepRetry >= 3) {
                     oledError("No line found!");
-                    Serial.println("[RECOVERY] 3 sweep fails – staying");
+                    LOGW(LM_RECOVERY, "3 sweep fails – staying");
                     // stay in phase, keep trying but slower
                 }
                 sweepAngle = 0; sweepDir = 1;
             }
             servoSetX(sweepAngle);
 
-            HuskyResult r = huskyRead();
-            if (r.detected) {
-                Serial.printf("[RECOVERY] line at servo X=%d\n", sweepAngle);
+            SensorSnapshot s;
+            sensorsSnapshot(s);
+            if (sensorFresh(s.tagMs) && s.cam.arrows && s.cam.count) {
+                LOGI(LM_RECOVERY, "line at servo X=%d", sweepAngle);
                 phase = REC_ALIGN_LINE;
             }
         }
@@ -96,10 +110,12 @@ void recoveryModeLoop() {
 
     // ── Phase 2: drive robot so line sensor center picks up line ────
     case REC_ALIGN_LINE: {
-        HuskyResult r = huskyRead();
-        if (r.detected) {
+        SensorSnapshot s;
+        sensorsSnapshot(s);
+        HuskyResult line = huskyPick(s.cam, 0);
+        if (sensorFresh(s.tagMs) && s.cam.arrows && line.detected) {   // not a stale tag frame
             // steer toward line: x offset → rotation
-            float errX = (float)(r.xCenter - 160);
+            float errX = (float)(line.xCenter - 160);
             int16_t vr = (int16_t)(errX * 0.3f);
             sendVel(0, 80, vr);     // crawl forward while aligning
         } else {
@@ -108,10 +124,10 @@ void recoveryModeLoop() {
 
         // ask STM32 for line sensor status via status request
         // when STM32 reports NFC checkpoint, we know we're on track
-        if (g_newCheckpoint) {
-            g_newCheckpoint = false;
+        uint16_t cp;
+        if (takeCheckpoint(cp)) {
             stopSTM32();
-            Serial.printf("[RECOVERY] on line, CP=%u\n", g_lastCheckpointId);
+            LOGI(LM_RECOVERY, "on line, CP=%u", cp);
             phase = REC_READ_CHECKPOINT;
         }
 
@@ -126,19 +142,19 @@ void recoveryModeLoop() {
             routeTimeout = now;
             phase = REC_WAIT_ROUTE;
             oledRecovery("Requesting route...");
-            Serial.printf("[RECOVERY] requesting return from CP %u\n", g_lastCheckpointId);
+            LOGI(LM_RECOVERY, "requesting return from CP %u", g_lastCheckpointId);
         } else {
             // wait for STM32 to read NFC
             cpTimeout = now;
             oledRecovery("Reading NFC...");
-            if (g_newCheckpoint) {
-                g_newCheckpoint = false;
-                mqttPublishReturnRequest(g_lastCheckpointId);
+            uint16_t cp;
+            if (takeCheckpoint(cp)) {
+                mqttPublishReturnRequest(cp);
                 routeTimeout = now;
                 phase = REC_WAIT_ROUTE;
             }
             if (now - cpTimeout > 30000) {
-                buzzerBeepN(5);
+                buzzerBeepN(5, 100, 100, BUZ_WARN);
                 oledError("NFC timeout!");
                 // stay in recovery, keep trying
                 cpTimeout = now;
@@ -157,7 +173,7 @@ void recoveryModeLoop() {
             // retry
             mqttPublishReturnRequest(g_lastCheckpointId);
             routeTimeout = now;
-            Serial.println("[RECOVERY] route timeout, retrying");
+            LOGW(LM_RECOVERY, "route timeout, retrying");
         }
         break;
 
@@ -168,7 +184,7 @@ void recoveryModeLoop() {
         servoSetY(SERVO_Y_LEVEL);
         g_mode = MODE_AUTO;
         // g_autoState already set to AUTO_RETURNING by MQTT callback
-        Serial.println("[RECOVERY] → AUTO (returning)");
+        LOGI(LM_RECOVERY, "→ AUTO (returning)");
         buzzerBeep(100);
         break;
 
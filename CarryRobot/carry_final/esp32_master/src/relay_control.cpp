@@ -1,4 +1,41 @@
 #include "relay_control.h"
+#include "globals.h"
+#include "uart_protocol.h"
+#include "mqtt_client.h"
+#include "tlog.h"
+
+extern HardwareSerial Serial2;  // UART2 → STM32 (begin trong main.cpp)
+
+// ── rail state ──────────────────────────────────────────────────────
+struct Rail {
+    uint8_t           pin;
+    const char       *name;
+    volatile uint32_t gen;          // +1 per off→on edge (control task)
+    volatile uint32_t readyGen;     // generation its peripheral answered on
+    volatile uint32_t readyMs;      // time-to-ready of readyGen
+    uint32_t          onMs;
+    uint32_t          reportedGen;  // power_ready sent for this generation
+    uint32_t          timeoutGen;   // ok=false sent for this generation
+    uint32_t          resetGen;     // CMD_PERIPH_RESET sent (R2 only)
+};
+
+static Rail s_rail[RAIL_COUNT] = {
+    { PIN_RELAY_VISION,   "vision",   0, 0, 0, 0, 0, 0, 0 },
+    { PIN_RELAY_LINE_NFC, "line_nfc", 0, 0, 0, 0, 0, 0, 0 },
+};
+static bool s_prewarm = false;
+
+static void railOn(PowerRail r) {
+    Rail &s = s_rail[r];
+    if (digitalRead(s.pin) == HIGH) return;
+    digitalWrite(s.pin, HIGH);
+    s.onMs = millis();
+    s.gen  = s.gen + 1;
+}
+
+static void railOff(PowerRail r) {
+    digitalWrite(s_rail[r].pin, LOW);
+}
 
 void relayInit() {
     pinMode(PIN_RELAY_VISION,   OUTPUT);
@@ -6,10 +43,10 @@ void relayInit() {
     relayAllOff();
 }
 
-void relayVisionOn()   { digitalWrite(PIN_RELAY_VISION,   HIGH); }
-void relayVisionOff()  { digitalWrite(PIN_RELAY_VISION,   LOW);  }
-void relayLineNfcOn()  { digitalWrite(PIN_RELAY_LINE_NFC, HIGH); }
-void relayLineNfcOff() { digitalWrite(PIN_RELAY_LINE_NFC, LOW);  }
+void relayVisionOn()   { railOn(RAIL_VISION);     }
+void relayVisionOff()  { railOff(RAIL_VISION);    }
+void relayLineNfcOn()  { railOn(RAIL_LINE_NFC);   }
+void relayLineNfcOff() { railOff(RAIL_LINE_NFC);  }
 
 void relayAllOff() {
     relayVisionOff();
@@ -17,22 +54,79 @@ void relayAllOff() {
 }
 
 void relaySetAuto() {
-    relayVisionOff();
+    if (!s_prewarm) relayVisionOff();
     relayLineNfcOn();
-    delay(200);
 }
 
 void relaySetFollow() {
     relayLineNfcOff();
     relayVisionOn();
-    delay(300);
 }
 
 void relaySetRecovery() {
     relayVisionOn();
     relayLineNfcOn();
-    delay(300);
 }
 
 bool relayGetVision()  { return digitalRead(PIN_RELAY_VISION)   == HIGH; }
 bool relayGetLineNfc() { return digitalRead(PIN_RELAY_LINE_NFC) == HIGH; }
+
+// ── readiness ───────────────────────────────────────────────────────
+bool relayReady(PowerRail r) {
+    const Rail &s = s_rail[r];
+    return digitalRead(s.pin) == HIGH && s.gen && s.readyGen == s.gen;
+}
+
+uint32_t relayRailGen(PowerRail r) { return s_rail[r].gen; }
+
+void relayMarkReady(PowerRail r, uint32_t gen) {
+    Rail &s = s_rail[r];
+    if (gen != s.gen || s.readyGen == gen) return;
+    s.readyMs  = millis() - s.onMs;
+    s.readyGen = gen;
+}
+
+// CMD_READY after our CMD_PERIPH_RESET: the PN532 answered (or has no cap)
+void relayOnStm32Ready(uint8_t caps, uint8_t periph) {
+    Rail &s = s_rail[RAIL_LINE_NFC];
+    if (s.resetGen != s.gen) return;              // READY from before the power edge
+    if ((periph & BOOT_PERIPH_NFC) || !(caps & BOOT_CAP_NFC))
+        relayMarkReady(RAIL_LINE_NFC, s.gen);
+}
+
+void relayPrewarmVision(bool on) {
+    if (on == s_prewarm) return;
+    s_prewarm = on;
+    if (on) {
+        relayVisionOn();
+        LOGI(LM_MODE, "pre-warming vision rail");
+    } else if (g_mode == MODE_AUTO) {
+        relayVisionOff();
+    }
+}
+
+void relayLoop() {
+    uint32_t now = millis();
+
+    // R2 powered: have the STM32 re-probe the PN532 instead of guessing
+    Rail &nfc = s_rail[RAIL_LINE_NFC];
+    if (relayGetLineNfc() && nfc.resetGen != nfc.gen) {
+        uint8_t mask = BOOT_PERIPH_NFC;
+        uartSendFrame(Serial2, CMD_PERIPH_RESET, &mask, 1);
+        nfc.resetGen = nfc.gen;
+    }
+
+    for (uint8_t i = 0; i < RAIL_COUNT; i++) {
+        Rail &s = s_rail[i];
+        if (digitalRead(s.pin) != HIGH || s.reportedGen == s.gen) continue;
+        if (s.readyGen == s.gen) {
+            s.reportedGen = s.gen;
+            LOGI(LM_MODE, "%s rail ready in %u ms", s.name, s.readyMs);
+            mqttPublishPowerReady(s.name, true, s.readyMs);
+        } else if (now - s.onMs >= POWER_READY_TIMEOUT_MS && s.timeoutGen != s.gen) {
+            s.timeoutGen = s.gen;                 // keep waiting; ready still reported
+            LOGW(LM_MODE, "%s rail: no answer after %u ms", s.name, now - s.onMs);
+            mqttPublishPowerReady(s.name, false, now - s.onMs);
+        }
+    }
+}
@@ -11,14 +11,33 @@ void relayLineNfcOff();
 
 void relayAllOff();
 
-// convenience presets
-void relaySetAuto();      // R1 off, R2 on
+// convenience presets – switch and return; readiness is tracked below
+void relaySetAuto();      // R1 off, R2 on   (R1 stays on while pre-warmed)
 void relaySetFollow();    // R1 on,  R2 off
 void relaySetRecovery();  // R1 on,  R2 on
 
 bool relayGetVision();    // true = ON (R1)
 bool relayGetLineNfc();   // true = ON (R2)
 
+// ── power sequencing ────────────────────────────────────────────────
+// Each off→on edge starts a new rail generation.  The rail is ready once
+// its peripheral has answered on that generation: HuskyLens via the
+// sensor task's probe, PN532 via the STM32's CMD_READY after
+// CMD_PERIPH_RESET.  relayLoop() reports power_ready with the measured
+// time, or ok=false after POWER_READY_TIMEOUT_MS.
+enum PowerRail : uint8_t {
+    RAIL_VISION,
+    RAIL_LINE_NFC,
+    RAIL_COUNT
+};
+
+void     relayLoop();                               // control task
+bool     relayReady(PowerRail r);
+uint32_t relayRailGen(PowerRail r);                 // 0 = never powered
+void     relayMarkReady(PowerRail r, uint32_t gen); // any task; stale gen ignored
+void     relayOnStm32Ready(uint8_t caps, uint8_t periph);   // CMD_READY
+void     relayPrewarmVision(bool on);               // Auto idle at MED
+
 // backward-compat aliases
 inline void relayLineOn()  { relayLineNfcOn();  }
 inline void relayLineOff() { relayLineNfcOff(); }
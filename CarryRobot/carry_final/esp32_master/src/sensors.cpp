@@ -0,0 +1,123 @@
+#include "sensors.h"
+#include "event_queue.h"
+#include "relay_control.h"
+#include "servo_control.h"
+#include "sr05.h"
+#include "tlog.h"
+
+static Snapshot<SensorSnapshot> s_snap;
+static SensorSnapshot s_work = {};          // sensor task's copy, published whole
+static QueueHandle_t  s_cmds    = nullptr;
+static uint32_t       s_upGen   = 0;        // R1 generation the HuskyLens answered on
+static uint32_t       s_probeGen = 0;       // R1 generation being probed
+static uint32_t       s_probeMs = 0;
+static SensorCmd      s_algo    = SENSOR_HUSKY_TAG;
+
+// per-source schedule (millis() of the last sample)
+static uint32_t s_wallDue = 0;
+static uint32_t s_panDue  = 0;
+
+static void applyAlgo() {
+    if (s_algo == SENSOR_HUSKY_LINE) huskySetLineMode();
+    else                             huskySetTagMode();
+}
+
+// R1 came up (new generation): knock until the HuskyLens answers
+static bool visionUp() {
+    uint32_t gen = relayRailGen(RAIL_VISION);
+    if (s_upGen == gen) return true;
+    if (s_probeGen != gen) {                 // link state belongs to the last power-up
+        s_probeGen = gen;
+        huskyReconnect();
+    }
+    uint32_t now = millis();
+    if (now - s_probeMs < POWER_PROBE_MS) return false;
+    s_probeMs = now;
+    if (!huskyProbe()) return false;
+    applyAlgo();
+    s_upGen = gen;
+    relayMarkReady(RAIL_VISION, gen);
+    LOGI(LM_HUSKY, "up on rail gen %u", gen);
+    return true;
+}
+
+static bool due(uint32_t &last, uint32_t now, uint32_t period) {
+    if (now - last < period) return false;
+    last = now;
+    return true;
+}
+
+// ── per-source samplers (true = s_work changed) ─────────────────────
+// the driver paces its own requests; parse whatever has arrived
+static bool sampleTag() {
+    bool up = visionUp();
+    if (!huskyPoll(s_work.cam) || !up) return false;
+    s_work.tagMs = s_work.cam.captureMs;
+    s_work.tagSeq++;
+    return true;
+}
+
+// the SR05 driver samples in the background; mirror its newest medians
+static bool sampleWalls(uint32_t now) {
+    if (!due(s_wallDue, now, SR05_SLOT_MS)) return false;
+    uint32_t l = sr05StampMs(true), r = sr05StampMs(false);
+    uint32_t ms = (int32_t)(l - r) > 0 ? l : r;
+    if (ms == s_work.wallMs) return false;
+    s_work.wallL  = sr05ReadLeft();
+    s_work.wallR  = sr05ReadRight();
+    s_work.wallMs = ms;
+    return true;
+}
+
+static bool samplePan(uint32_t now) {
+    if (!due(s_panDue, now, SENSOR_PAN_MS)) return false;
+    s_work.panRaw = servoReadXFeedback();
+    s_work.panDeg = servoFeedbackToDeg(s_work.panRaw);
+    s_work.panMs  = now;
+    return true;
+}
+
+// ──────────────────────────────────────────────────────────────────
+void sensorsInit() {
+    s_cmds = xQueueCreate(4, sizeof(SensorCmd));
+}
+
+void sensorsCommand(SensorCmd cmd) {
+    if (xQueueSend(s_cmds, &cmd, 0) != pdTRUE)
+        LOGW(LM_HUSKY, "sensor cmd %u dropped", cmd);
+}
+
+uint32_t sensorsSnapshot(SensorSnapshot &out) {
+    return s_snap.read(out);
+}
+
+bool sensorFresh(uint32_t stampMs) {
+    return stampMs && millis() - stampMs <= SENSOR_STALE_MS;
+}
+
+uint32_t sensorsRetries() { return s_snap.retries(); }
+
+void sensorsPoll() {
+    SensorCmd cmd;
+    while (xQueueReceive(s_cmds, &cmd, 0) == pdTRUE) {
+        if (cmd == SENSOR_HUSKY_RECONNECT) {
+            s_upGen    = 0;
+            s_probeGen = 0;
+        } else {
+            s_algo = cmd;
+            if (s_upGen && s_upGen == relayRailGen(RAIL_VISION)) applyAlgo();
+        }
+    }
+
+    // R1 feeds all three; while it is off the last values go stale
+    if (!relayGetVision()) return;
+
+    uint32_t now = millis();
+    bool changed = sampleTag();
+    changed |= sampleWalls(now);
+    changed |= samplePan(now);
+    if (!changed) return;
+
+    s_work.ver = s_snap.version() + 1;
+    s_snap.publish(s_work);
+}
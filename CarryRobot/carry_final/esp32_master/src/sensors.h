@@ -0,0 +1,42 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "huskylens_uart.h"
+
+// ── sensor hub (sensor task, core 1) ────────────────────────────────
+// The sensor task is the only code that touches the HuskyLens, the
+// SR05 pair and the servo X feedback ADC.  Each source is sampled at
+// its own rate and the result goes out as one versioned snapshot;
+// control, telemetry and the OLED copy it without locking and without
+// going near the hardware.  Every source carries its own timestamp.
+struct SensorSnapshot {
+    uint32_t    ver;       // snapshot version, +1 per publish (0 = none yet)
+
+    HuskyFrame  cam;       // every block of the latest HuskyLens reply, HUSKY_POLL_MS
+    uint32_t    tagMs;     // cam.captureMs, 0 = never
+    uint32_t    tagSeq;    // +1 per camera frame
+
+    float       wallL;     // SR05 median cm, 0 = no echo
+    float       wallR;
+    uint32_t    wallMs;    // newest SR05 sample of the pair, 0 = never
+
+    int16_t     panRaw;    // servo X feedback ADC, SENSOR_PAN_MS
+    float       panDeg;    // mapped to 0–180°
+    uint32_t    panMs;
+};
+
+// The HuskyLens is probed every time R1 comes up (relayRailGen) and
+// gets the last requested algorithm once it answers – the modes only
+// say which algorithm they want.
+enum SensorCmd : uint8_t {
+    SENSOR_HUSKY_RECONNECT,   // force a re-probe on the current rail
+    SENSOR_HUSKY_TAG,         // tag recognition algorithm
+    SENSOR_HUSKY_LINE         // line tracking algorithm
+};
+
+void     sensorsInit();
+void     sensorsCommand(SensorCmd cmd);         // any task, non-blocking
+uint32_t sensorsSnapshot(SensorSnapshot &out);  // any task, lock-free; returns out.ver
+bool     sensorFresh(uint32_t stampMs);         // stamp set and within SENSOR_STALE_MS
+uint32_t sensorsRetries();                      // copies retried: version moved mid-copy
+void     sensorsPoll();                         // sensor task, every SENSOR_TASK_MS
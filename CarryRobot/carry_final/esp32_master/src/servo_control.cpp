@@ -31,8 +31,11 @@ int servoReadXFeedback() {
     return analogRead(PIN_SERVO_X_FB);
 }
 
-float servoReadXAngle() {
-    int raw = servoReadXFeedback();
+float servoFeedbackToDeg(int raw) {
     // map ADC (300–3700) → 0–180°
     return constrain(map(raw, 300, 3700, 0, 180), 0, 180);
 }
+
+float servoReadXAngle() {
+    return servoFeedbackToDeg(servoReadXFeedback());
+}
@@ -9,3 +9,4 @@ int   servoGetX();
 int   servoGetY();
 int   servoReadXFeedback();   // raw ADC feedback for servo X
 float servoReadXAngle();      // estimated angle from feedback
+float servoFeedbackToDeg(int raw);
@@ -1,46 +1,134 @@
 #include "sr05.h"
+#include "relay_control.h"
 #include "mqtt_client.h"
+#include "tlog.h"
+#include "esp_timer.h"
+
+// ── per-side state ──────────────────────────────────────────────────
+struct Side {
+    uint8_t           trig;
+    uint8_t           echo;
+    const char       *name;
+    volatile uint32_t riseUs;       // ISR
+    volatile uint32_t pulseUs;      // ISR, 0 = no falling edge yet
+    float             win[SR05_MEDIAN];
+    uint8_t           winN;
+    uint8_t           winPos;
+    volatile float    cm;           // median, read by any task
+    volatile uint32_t stampMs;
+    uint8_t           fails;
+    bool              reported;
+};
+
+static Side s_side[2];   // 0 = left, 1 = right
+static uint8_t            s_active = 0;
+static esp_timer_handle_t s_timer  = nullptr;
 
 // ── health monitoring (PN532-like pattern) ──────────────────────────
-static uint8_t  s_failsL = 0, s_failsR = 0;
-static const uint8_t MAX_SR05_FAILS = 20;   // ~20 × 100ms = 2s → report
-static bool     s_reportedL = false, s_reportedR = false; // one-shot MQTT
-
-static float readSR05(uint8_t trigPin, uint8_t echoPin,
-                      uint8_t &fails, bool &reported, const char *side) {
-    digitalWrite(trigPin, LOW);
-    delayMicroseconds(2);
-    digitalWrite(trigPin, HIGH);
+static const uint8_t MAX_SR05_FAILS = 30;   // ~30 × 70ms = 2s → report
+
+// ── echo ISRs ───────────────────────────────────────────────────────
+static void IRAM_ATTR onEcho(Side &s) {
+    uint32_t now = micros();
+    if (digitalRead(s.echo)) s.riseUs = now;
+    else if (s.riseUs && !s.pulseUs) s.pulseUs = now - s.riseUs;
+}
+static void IRAM_ATTR onEchoL() { onEcho(s_side[0]); }
+static void IRAM_ATTR onEchoR() { onEcho(s_side[1]); }
+
+// ── median of the window ────────────────────────────────────────────
+// 0 (no echo) means "nothing in range", not "touching": misses are left
+// out, and the side reads 0 only while they are the majority.
+static float median(const Side &s) {
+    float v[SR05_MEDIAN];
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < s.winN; i++)
+        if (s.win[i] > 0.0f) v[n++] = s.win[i];
+    if (!n || n * 2 < s.winN) return 0.0f;
+    for (uint8_t i = 1; i < n; i++) {           // insertion sort, n ≤ 5
+        float x = v[i];
+        int8_t j = i - 1;
+        while (j >= 0 && v[j] > x) { v[j + 1] = v[j]; j--; }
+        v[j + 1] = x;
+    }
+    return v[n / 2];
+}
+
+// ── close the previous slot: pulse → cm (0 = no echo) ───────────────
+static void finish(Side &s) {
+    uint32_t us = s.pulseUs;
+    float d = 0.0f;
+    if (us && us <= SR05_TIMEOUT_US) {
+        d = (float)us * 0.0343f / 2.0f;        // cm
+        s.fails    = 0;
+        s.reported = false;
+    } else if (++s.fails >= MAX_SR05_FAILS && !s.reported) {
+        s.reported = true;
+        LOGW(LM_SR05, "%s: %u consecutive timeouts", s.name, s.fails);
+        char evt[32];
+        snprintf(evt, sizeof(evt), "sr05_%s_timeout", s.name);
+        mqttPublishEvent(evt);
+    }
+    s.win[s.winPos] = d;
+    s.winPos = (s.winPos + 1) % SR05_MEDIAN;
+    if (s.winN < SR05_MEDIAN) s.winN++;
+    s.cm      = median(s);
+    s.stampMs = millis();
+}
+
+static void fire(Side &s) {
+    s.riseUs  = 0;
+    s.pulseUs = 0;
+    digitalWrite(s.trig, HIGH);
     delayMicroseconds(10);
-    digitalWrite(trigPin, LOW);
-
-    unsigned long dur = pulseIn(echoPin, HIGH, SR05_TIMEOUT_US);
-    if (dur == 0) {
-        if (++fails >= MAX_SR05_FAILS && !reported) {
-            reported = true;
-            Serial.printf("[SR05] %s: %u consecutive timeouts\n", side, fails);
-            char evt[32];
-            snprintf(evt, sizeof(evt), "sr05_%s_timeout", side);
-            mqttPublishEvent(evt);
-        }
-        return 0.0f;
+    digitalWrite(s.trig, LOW);
+}
+
+// ── esp_timer task, every SR05_SLOT_MS ──────────────────────────────
+static bool s_fired = false;
+
+static void onSlot(void *) {
+    if (s_fired) finish(s_side[s_active]);
+    s_fired = false;
+
+    if (!relayGetVision()) {                    // R1 off: nothing to measure
+        for (Side &s : s_side) { s.winN = 0; s.fails = 0; s.stampMs = 0; }
+        return;
     }
-    fails = 0;
-    reported = false;
-    return (float)dur * 0.0343f / 2.0f;    // cm
+    s_active ^= 1;
+    fire(s_side[s_active]);
+    s_fired = true;
 }
 
 void sr05Init() {
-    pinMode(PIN_SR05_L_TRIG, OUTPUT);
-    pinMode(PIN_SR05_L_ECHO, INPUT);
-    pinMode(PIN_SR05_R_TRIG, OUTPUT);
-    pinMode(PIN_SR05_R_ECHO, INPUT);
+    s_side[0].trig = PIN_SR05_L_TRIG; s_side[0].echo = PIN_SR05_L_ECHO; s_side[0].name = "left";
+    s_side[1].trig = PIN_SR05_R_TRIG; s_side[1].echo = PIN_SR05_R_ECHO; s_side[1].name = "right";
+    for (Side &s : s_side) {
+        pinMode(s.trig, OUTPUT);
+        digitalWrite(s.trig, LOW);
+        pinMode(s.echo, INPUT);
+    }
+    attachInterrupt(digitalPinToInterrupt(PIN_SR05_L_ECHO), onEchoL, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(PIN_SR05_R_ECHO), onEchoR, CHANGE);
+
+    esp_timer_create_args_t args = {};
+    args.callback        = onSlot;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name            = "sr05";
+    esp_timer_create(&args, &s_timer);
+    esp_timer_start_periodic(s_timer, (uint64_t)SR05_SLOT_MS * 1000);
 }
 
-float sr05ReadLeft()  { return readSR05(PIN_SR05_L_TRIG, PIN_SR05_L_ECHO,
-                                        s_failsL, s_reportedL, "left"); }
-float sr05ReadRight() { return readSR05(PIN_SR05_R_TRIG, PIN_SR05_R_ECHO,
-                                        s_failsR, s_reportedR, "right"); }
+static float reading(const Side &s) {
+    uint32_t t = s.stampMs;
+    if (!t || millis() - t > SR05_STALE_MS) return 0.0f;
+    return s.cm;
+}
+
+float sr05ReadLeft()  { return reading(s_side[0]); }
+float sr05ReadRight() { return reading(s_side[1]); }
+
+uint32_t sr05StampMs(bool left) { return s_side[left ? 0 : 1].stampMs; }
 
 bool sr05WallLeft() {
     float d = sr05ReadLeft();
@@ -2,8 +2,14 @@
 #include <Arduino.h>
 #include "config.h"
 
-void  sr05Init();
-float sr05ReadLeft();    // distance in cm  (0 = timeout / no echo)
-float sr05ReadRight();
-bool  sr05WallLeft();    // < SR05_WALL_WARN_CM
-bool  sr05WallRight();
+// ── Background echo capture ─────────────────────────────────────────
+// An esp_timer fires left and right alternately, one per SR05_SLOT_MS,
+// so one sensor never hears the other's burst; the echo pins time the
+// pulse in a GPIO interrupt.  Readings are the median of the last
+// SR05_MEDIAN samples and cost nothing to read.
+void     sr05Init();              // starts the schedule
+float    sr05ReadLeft();          // distance in cm  (0 = no echo / stale)
+float    sr05ReadRight();
+uint32_t sr05StampMs(bool left);  // millis() of the newest sample, 0 = none
+bool     sr05WallLeft();          // < SR05_WALL_WARN_CM
+bool     sr05WallRight();
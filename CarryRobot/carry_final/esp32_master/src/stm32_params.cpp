@@ -0,0 +1,168 @@
+#include "stm32_params.h"
+#include "stm32_regs.h"
+#include "config.h"
+#include "tlog.h"
+#include <Preferences.h>
+
+#define PARAM_N  (REG_PARAM_LAST - REG_PARAM_BASE + 1)
+
+// ── dashboard key → register (scale 1000 = PID gain) ────────────────
+struct ParamName {
+    const char *key;
+    uint8_t     reg;
+    uint16_t    scale;
+};
+
+static const ParamName NAMES[] = {
+    { "runSpeed",    REG_P_RUN_SPEED,     1    },
+    { "turnSpeed",   REG_P_TURN_SPEED,    1    },
+    { "turn90Ms",    REG_P_TURN_90_MS,    1    },
+    { "turn180Ms",   REG_P_TURN_180_MS,   1    },
+    { "brakePwm",    REG_P_BRAKE_PWM,     1    },
+    { "brakeMs",     REG_P_BRAKE_MS,      1    },
+    { "kp",          REG_P_LF_KP,         1000 },
+    { "ki",          REG_P_LF_KI,         1000 },
+    { "kd",          REG_P_LF_KD,         1000 },
+    { "maxCorr",     REG_P_LF_MAX_CORR,   1    },
+    { "tofStopMm",   REG_P_TOF_STOP_MM,   1    },
+    { "tofResumeMm", REG_P_TOF_RESUME_MM, 1    },
+    { "nfcReadMs",   REG_P_NFC_READ_MS,   1    },
+    { "nfcGuardMs",  REG_P_NFC_GUARD_MS,  1    },
+};
+static const uint8_t NAME_COUNT = sizeof(NAMES) / sizeof(NAMES[0]);
+
+// same tables the STM32 range-checks writes against
+static const uint16_t BOUNDS[PARAM_N][2] = REG_P_BOUNDS;
+static const uint8_t  ORDERED[][2]       = REG_P_ORDERED;
+
+static uint16_t s_override[PARAM_N];
+static uint32_t s_mask     = 0;        // bit i → s_override[i] is set
+static bool     s_pending  = false;    // read-merge-write in progress
+static uint32_t s_reqMs    = 0;
+
+#define PARAM_RETRY_MS  1000
+
+static void savePrefs() {
+    Preferences prefs;
+    prefs.begin(NVS_NAMESPACE, false);
+    prefs.putUInt("stm_pmask", s_mask);
+    prefs.putBytes("stm_pval", s_override, sizeof(s_override));
+    prefs.end();
+}
+
+void stm32ParamsInit() {
+    Preferences prefs;
+    prefs.begin(NVS_NAMESPACE, true);
+    s_mask = prefs.getUInt("stm_pmask", 0);
+    if (prefs.getBytes("stm_pval", s_override, sizeof(s_override)) != sizeof(s_override))
+        s_mask = 0;                     // table size changed → start over
+    prefs.end();
+    LOGI(LM_PARAM, "%u overrides", __builtin_popcount(s_mask));
+}
+
+static void requestBlock() {
+    stm32RegRead(REG_PARAM_BASE, PARAM_N);
+    s_reqMs = millis();
+}
+
+void stm32ParamsSync() {
+    s_pending = true;
+    requestBlock();
+}
+
+void stm32ParamsRequest() {
+    requestBlock();
+}
+
+// block read newer than our request?
+static bool blockFresh() {
+    uint32_t since = millis() - s_reqMs;
+    for (uint8_t i = 0; i < PARAM_N; i++)
+        if (stm32RegAgeMs(REG_PARAM_BASE + i) > since) return false;
+    return true;
+}
+
+void stm32ParamsLoop() {
+    if (!s_pending) return;
+    if (!blockFresh()) {
+        if (millis() - s_reqMs >= PARAM_RETRY_MS) requestBlock();
+        return;
+    }
+    s_pending = false;
+
+    uint16_t vals[PARAM_N];
+    bool differs = false;
+    for (uint8_t i = 0; i < PARAM_N; i++) {
+        stm32RegGet(REG_PARAM_BASE + i, vals[i]);
+        if ((s_mask & (1UL << i)) && vals[i] != s_override[i]) {
+            vals[i] = s_override[i];
+            differs = true;
+        }
+    }
+    if (differs) {
+        stm32RegWrite(REG_PARAM_BASE, vals, PARAM_N);
+        stm32RegWrite1(REG_CTRL, REG_CTRL_SAVE_PARAMS);
+        LOGI(LM_PARAM, "pushed to STM32");
+    }
+    requestBlock();                     // read back what the STM32 accepted
+}
+
+bool stm32ParamsSetByName(const char *key, float value) {
+    for (uint8_t n = 0; n < NAME_COUNT; n++) {
+        if (strcmp(key, NAMES[n].key) != 0) continue;
+        uint8_t i = NAMES[n].reg - REG_PARAM_BASE;
+        float raw = value * NAMES[n].scale + 0.5f;
+        if (raw < BOUNDS[i][0] || raw >= BOUNDS[i][1] + 1.0f) {
+            LOGW(LM_PARAM, "%s=%.3f outside %u..%u", key, value, BOUNDS[i][0], BOUNDS[i][1]);
+            return false;
+        }
+        s_override[i] = (uint16_t)raw;
+        s_mask |= 1UL << i;
+        return true;
+    }
+    return false;
+}
+
+// override, else the mirrored STM32 value; false if neither is known
+static bool effective(uint8_t reg, uint16_t &v) {
+    uint8_t i = reg - REG_PARAM_BASE;
+    if (s_mask & (1UL << i)) { v = s_override[i]; return true; }
+    return stm32RegGet(reg, v);
+}
+
+bool stm32ParamsCommit() {
+    for (const auto &p : ORDERED) {
+        uint16_t a, b;
+        if (effective(p[0], a) && effective(p[1], b) && a >= b) {
+            LOGW(LM_PARAM, "reg 0x%02X=%u not below 0x%02X=%u – dropped", p[0], a, p[1], b);
+            stm32ParamsInit();              // back to the last committed overrides
+            return false;
+        }
+    }
+    savePrefs();
+    stm32ParamsSync();
+    return true;
+}
+
+void stm32ParamsReset() {
+    s_mask = 0;
+    savePrefs();
+    s_pending = false;
+    stm32RegWrite1(REG_CTRL, REG_CTRL_PARAM_DEFAULTS | REG_CTRL_SAVE_PARAMS);
+    requestBlock();
+}
+
+bool stm32ParamsToJson(char *buf, size_t size) {
+    size_t n = snprintf(buf, size, "{");
+    for (uint8_t k = 0; k < NAME_COUNT && n < size; k++) {
+        uint16_t v;
+        if (!stm32RegGet(NAMES[k].reg, v)) return false;
+        if (NAMES[k].scale == 1)
+            n += snprintf(buf + n, size - n, "%s\"%s\":%u", k ? "," : "", NAMES[k].key, v);
+        else
+            n += snprintf(buf + n, size - n, "%s\"%s\":%.3f", k ? "," : "", NAMES[k].key,
+                          (float)v / NAMES[k].scale);
+    }
+    if (n < size) snprintf(buf + n, size - n, "}");
+    return n < size;
+}
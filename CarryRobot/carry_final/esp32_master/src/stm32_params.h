@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// ── STM32 runtime parameters (REG_P_* in the register map) ──────────
+// Dashboard tune_* commands set per-parameter overrides that are kept
+// in NVS and pushed to the STM32, which stores them in its own flash.
+// Pushing is read-merge-write: the whole block is read, overrides are
+// applied and written back in one frame only if something differs.
+
+void stm32ParamsInit();                         // load overrides from NVS
+void stm32ParamsLoop();                         // call from main loop
+void stm32ParamsSync();                         // push overrides (STM32 boot)
+
+bool stm32ParamsSetByName(const char *key, float value);   // stage; false = unknown / out of range
+bool stm32ParamsCommit();                       // persist staged overrides + push;
+                                                // false = REG_P_ORDERED broken, all dropped
+void stm32ParamsReset();                        // drop overrides, STM32 defaults
+void stm32ParamsRequest();                      // read back → params event
+
+// {"runSpeed":200,"kp":0.35,...} from the register mirror; false if not read yet
+bool stm32ParamsToJson(char *buf, size_t size);
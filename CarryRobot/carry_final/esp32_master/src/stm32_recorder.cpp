@@ -0,0 +1,85 @@
+#include "stm32_recorder.h"
+#include "uart_protocol.h"
+#include "mqtt_client.h"
+#include "tlog.h"
+
+#define REC_REQ_TIMEOUT_MS  300
+#define REC_REQ_RETRIES     3
+
+static bool     s_active  = false;
+static uint8_t  s_next    = 0;       // chunk we are waiting for
+static uint8_t  s_retries = 0;
+static uint32_t s_reqMs   = 0;
+static bool     s_waitNet = false;   // chunk not published – hold until MQTT is back
+
+static void requestChunk(uint8_t chunk) {
+    uartSendFrame(Serial2, CMD_REC_DUMP, &chunk, 1);
+    s_next  = chunk;
+    s_reqMs = millis();
+}
+
+static void finish(bool ok) {
+    s_active = false;
+    if (ok) {
+        uint8_t arg = REC_DUMP_REARM;
+        uartSendFrame(Serial2, CMD_REC_DUMP, &arg, 1);
+    }
+    // on failure the STM32 keeps the capture; a later rec_dump retries
+    mqttPublishEvent(ok ? "rec_done" : "rec_failed");
+    LOGI(LM_REC, "download %s", ok ? "done" : "FAILED");
+}
+
+void stm32RecorderRequest() {
+    uint8_t arg = REC_DUMP_FREEZE;
+    uartSendFrame(Serial2, CMD_REC_DUMP, &arg, 1);
+}
+
+void stm32RecorderOnFrozen(const uint8_t *data, uint8_t len) {
+    if (len < 5 || s_active) return;
+    uint8_t  reason  = data[0];
+    uint16_t samples = ((uint16_t)data[1] << 8) | data[2];
+    uint16_t arg     = ((uint16_t)data[3] << 8) | data[4];
+    LOGW(LM_REC, "STM32 frozen: reason %u, %u samples", reason, samples);
+    mqttPublishRecFrozen(reason, samples, arg);
+
+    if (samples == 0) { finish(true); return; }
+    s_active  = true;
+    s_waitNet = false;
+    s_retries = 0;
+    requestChunk(0);
+}
+
+void stm32RecorderOnChunk(const uint8_t *data, uint8_t len) {
+    if (!s_active || len < 4) return;
+    uint8_t chunk  = data[0];
+    uint8_t chunks = data[1];
+    uint8_t reason = data[2];
+    uint8_t n      = data[3];
+    if (chunk != s_next || len < 4 + n * sizeof(RecSample)) return;
+
+    RecSample s[REC_CHUNK_SAMPLES];
+    n = min(n, (uint8_t)REC_CHUNK_SAMPLES);
+    memcpy(s, data + 4, n * sizeof(RecSample));
+    s_retries = 0;
+    if (!mqttPublishRecChunk(reason, chunk, chunks, s, n)) {
+        // the STM32 stays frozen; the same chunk is pulled again later
+        s_waitNet = true;
+        LOGW(LM_REC, "chunk %u not published – waiting for MQTT", chunk);
+        return;
+    }
+
+    if (chunk + 1 >= chunks) finish(true);
+    else                     requestChunk(chunk + 1);
+}
+
+void stm32RecorderLoop() {
+    if (s_active && s_waitNet) {
+        if (!mqttIsConnected()) return;
+        s_waitNet = false;
+        requestChunk(s_next);
+        return;
+    }
+    if (!s_active || millis() - s_reqMs < REC_REQ_TIMEOUT_MS) return;
+    if (++s_retries > REC_REQ_RETRIES) { finish(false); return; }
+    requestChunk(s_next);
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <Arduino.h>
+
+// ── STM32 flight-recorder download ──────────────────────────────────
+// When the STM32 freezes its recorder (CMD_REC_FROZEN) the capture is
+// pulled one chunk at a time, each chunk published to MQTT as it
+// arrives, then the recorder is re-armed.  One request in flight keeps
+// the STM32 RX queue and the MQTT client from being flooded; a chunk
+// that cannot be published is pulled again once MQTT is back.
+
+void stm32RecorderLoop();                                 // retry / timeout
+void stm32RecorderRequest();                              // freeze now + download
+void stm32RecorderOnFrozen(const uint8_t *data, uint8_t len);
+void stm32RecorderOnChunk(const uint8_t *data, uint8_t len);
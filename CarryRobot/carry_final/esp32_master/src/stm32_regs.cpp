@@ -0,0 +1,94 @@
+#include "stm32_regs.h"
+#include "config.h"
+#include "tlog.h"
+
+#define REG_SPACE  128    // addresses 0x00–0x7F
+
+static uint16_t            s_val[REG_SPACE];
+static uint32_t            s_rxMs[REG_SPACE];     // 0 = never read
+static uint8_t             s_version = 0;
+static Stm32RegWriteResult s_write   = {};
+static Stm32RegDataHook    s_hook    = nullptr;
+
+bool stm32RegRead(uint8_t start, uint8_t count) {
+    if (count == 0 || count > REG_BATCH_MAX) return false;
+    uint8_t buf[2] = { start, count };
+    uartSendFrame(Serial2, CMD_REG_READ, buf, 2);
+    return true;
+}
+
+bool stm32RegWrite(uint8_t start, const uint16_t *vals, uint8_t count) {
+    if (count == 0 || count > REG_BATCH_MAX) return false;
+    uint8_t buf[2 + REG_BATCH_MAX * 2];
+    buf[0] = start;
+    buf[1] = count;
+    for (uint8_t i = 0; i < count; i++) {
+        buf[2 + i * 2]     = (uint8_t)(vals[i] >> 8);
+        buf[2 + i * 2 + 1] = (uint8_t)(vals[i] & 0xFF);
+    }
+    uartSendFrame(Serial2, CMD_REG_WRITE, buf, 2 + count * 2);
+    return true;
+}
+
+bool stm32RegWrite1(uint8_t addr, uint16_t value) {
+    return stm32RegWrite(addr, &value, 1);
+}
+
+bool stm32RegGet(uint8_t addr, uint16_t &value) {
+    if (addr >= REG_SPACE || s_rxMs[addr] == 0) return false;
+    value = s_val[addr];
+    return true;
+}
+
+uint32_t stm32RegAgeMs(uint8_t addr) {
+    if (addr >= REG_SPACE || s_rxMs[addr] == 0) return UINT32_MAX;
+    return millis() - s_rxMs[addr];
+}
+
+uint8_t stm32RegVersion() { return s_version; }
+
+const Stm32RegWriteResult &stm32RegLastWrite() { return s_write; }
+
+void stm32RegSetDataHook(Stm32RegDataHook fn) { s_hook = fn; }
+
+void stm32RegOnData(const uint8_t *data, uint8_t len) {
+    if (len < 3) return;
+    uint8_t version = data[0];
+    uint8_t start   = data[1];
+    uint8_t count   = min(data[2], (uint8_t)((len - 3) / 2));
+    if (count > REG_BATCH_MAX) count = REG_BATCH_MAX;
+
+    if (version != s_version) {
+        if (version != REGMAP_VERSION)
+            LOGE(LM_REG, "STM32 map v%u, ESP32 expects v%u",
+                 version, REGMAP_VERSION);
+        s_version = version;
+    }
+
+    uint16_t vals[REG_BATCH_MAX];
+    uint32_t now = millis();
+    if (now == 0) now = 1;                        // 0 marks "never read"
+    for (uint8_t i = 0; i < count; i++) {
+        vals[i] = ((uint16_t)data[3 + i * 2] << 8) | data[4 + i * 2];
+        uint8_t a = start + i;
+        if (a < REG_SPACE) {
+            s_val[a]  = vals[i];
+            s_rxMs[a] = now;
+        }
+    }
+    if (s_hook) s_hook(start, count, vals);
+}
+
+void stm32RegOnWriteAck(const uint8_t *data, uint8_t len) {
+    if (len < 3) return;
+    s_write.start   = data[0];
+    s_write.written = data[1];
+    s_write.status  = data[2];
+    s_write.rejected = len >= 7 ? ((uint32_t)data[3] << 24) | ((uint32_t)data[4] << 16) |
+                                  ((uint32_t)data[5] << 8)  | data[6]
+                                : 0;
+    s_write.rxMs    = millis();
+    if (s_write.status != REG_OK)
+        LOGW(LM_REG, "write 0x%02X: mask 0x%08lX rejected, status %u",
+             s_write.start, (unsigned long)s_write.rejected, s_write.status);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <Arduino.h>
+#include "uart_protocol.h"
+
+// ── STM32 register map client (CMD_REG_READ / CMD_REG_WRITE) ────────
+// Requests are asynchronous: replies are decoded in handleSTM32() into
+// a local mirror of the map, so callers read the cached value (and its
+// age) instead of waiting on the link.
+
+bool stm32RegRead(uint8_t start, uint8_t count);              // ≤ REG_BATCH_MAX
+bool stm32RegWrite(uint8_t start, const uint16_t *vals, uint8_t count);
+bool stm32RegWrite1(uint8_t addr, uint16_t value);
+
+bool     stm32RegGet(uint8_t addr, uint16_t &value);          // false = never read
+uint32_t stm32RegAgeMs(uint8_t addr);                         // UINT32_MAX if never read
+uint8_t  stm32RegVersion();                                   // 0 until first reply
+
+// last CMD_REG_WACK
+struct Stm32RegWriteResult {
+    uint8_t  start;
+    uint8_t  written;    // registers applied
+    uint8_t  status;     // REG_OK / first REG_ERR_*
+    uint32_t rejected;   // bit i → start + i refused
+    uint32_t rxMs;       // 0 = none yet
+};
+const Stm32RegWriteResult &stm32RegLastWrite();
+
+// optional hook, e.g. to forward a bulk read to MQTT
+typedef void (*Stm32RegDataHook)(uint8_t start, uint8_t count, const uint16_t *vals);
+void stm32RegSetDataHook(Stm32RegDataHook fn);
+
+// frames from STM32
+void stm32RegOnData(const uint8_t *data, uint8_t len);
+void stm32RegOnWriteAck(const uint8_t *data, uint8_t len);
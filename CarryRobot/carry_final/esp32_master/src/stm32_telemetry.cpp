@@ -0,0 +1,33 @@
+#include "stm32_telemetry.h"
+#include "config.h"
+#include "tlog.h"
+
+static Stm32Telemetry s_tel = {};
+
+void stm32TelemetrySubscribe(uint8_t rateHz) {
+    uartSendFrame(Serial2, CMD_TELEM_SUBSCRIBE, &rateHz, 1);
+    LOGI(LM_TELEM, "subscribe %u Hz", rateHz);
+}
+
+void stm32TelemetryDecode(const uint8_t *data, uint8_t len) {
+    if (len < sizeof(TelemetryFrame)) return;
+
+    TelemetryFrame f;
+    memcpy(&f, data, sizeof(f));
+
+    if (s_tel.frames > 0) {
+        uint16_t gap = (uint16_t)(f.seq - s_tel.f.seq);
+        if (gap > 1) s_tel.dropped += gap - 1;
+    }
+    s_tel.f    = f;
+    s_tel.rxMs = millis();
+    s_tel.frames++;
+}
+
+const Stm32Telemetry &stm32Telemetry() {
+    return s_tel;
+}
+
+bool stm32TelemetryFresh() {
+    return s_tel.rxMs != 0 && millis() - s_tel.rxMs < STM32_TELEM_STALE_MS;
+}
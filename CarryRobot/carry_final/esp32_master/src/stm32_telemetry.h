@@ -0,0 +1,19 @@
+#pragma once
+#include <Arduino.h>
+#include "uart_protocol.h"
+
+// ── STM32 telemetry snapshot (decoded CMD_TELEMETRY) ────────────────
+// The STM32 streams a fixed-size binary frame at the subscribed rate;
+// the latest one is kept here for MQTT telemetry and the OLED.
+
+struct Stm32Telemetry {
+    TelemetryFrame f;
+    uint32_t rxMs;       // ESP32 millis() when received, 0 = never
+    uint32_t frames;     // frames decoded
+    uint32_t dropped;    // gaps detected via seq
+};
+
+void stm32TelemetrySubscribe(uint8_t rateHz);          // 0 = off
+void stm32TelemetryDecode(const uint8_t *data, uint8_t len);
+const Stm32Telemetry &stm32Telemetry();
+bool stm32TelemetryFresh();                            // newer than STM32_TELEM_STALE_MS
@@ -0,0 +1,99 @@
+#include "target_track.h"
+#include "tlog.h"
+
+// one axis: position + velocity, both at s_t
+struct AlphaBeta {
+    float x;
+    float v;   // per second
+};
+
+static AlphaBeta s_bearing = {};
+static AlphaBeta s_range   = {};
+static uint32_t  s_t       = 0;       // measurement time of the estimate, 0 = no track
+static uint32_t  s_rxMs    = 0;       // millis() the last measurement was processed
+static bool      s_missed  = false;
+static uint8_t   s_outliers = 0;
+
+static float deg(float rad) { return rad * 57.29578f; }
+static float rad(float deg) { return deg * 0.01745329f; }
+
+// innovation: measurement minus the estimate predicted to its time
+static float residual(const AlphaBeta &f, float z, float dt) {
+    return z - (f.x + f.v * dt);
+}
+
+static void abCorrect(AlphaBeta &f, float r, float dt, float maxV) {
+    f.x += f.v * dt + FOLLOW_ALPHA * r;
+    f.v  = constrain(f.v + FOLLOW_BETA * r / dt, -maxV, maxV);
+}
+
+static void restart(float bearing, float range, uint32_t t) {
+    s_bearing  = { bearing, 0.0f };
+    s_range    = { range,   0.0f };
+    s_t        = t;
+    s_outliers = 0;
+}
+
+void trackReset() {
+    s_t        = 0;
+    s_missed   = false;
+    s_outliers = 0;
+}
+
+void trackMeasure(const HuskyResult &tag, uint32_t captureMs, float panDeg, float tiltDeg) {
+    int16_t side = (int16_t)sqrtf((float)tag.width * tag.height);
+    if (side <= 0) return;
+
+    // pinhole camera: bearing from the X offset plus the gimbal pan,
+    // slant range from the calibrated tag size, ground range from the
+    // camera elevation
+    float bearing = panDeg + deg(atanf((tag.xCenter - HUSKY_CX) / HUSKY_FOCAL_PX));
+    float slant   = FOLLOW_TAG_CM * HUSKY_FOCAL_PX / side;
+    float elev    = rad(tiltDeg - SERVO_Y_LEVEL) - atanf((tag.yCenter - HUSKY_CY) / HUSKY_FOCAL_PX);
+    float range   = slant * cosf(elev);
+
+    // the camera's frame is older than the request that fetched it
+    uint32_t t = captureMs - FOLLOW_CAM_LAT_MS;
+    s_rxMs   = millis();
+    s_missed = false;
+
+    float dt = (s_t ? (int32_t)(t - s_t) : 0) / 1000.0f;
+    if (!s_t || dt <= 0.0f || dt > FOLLOW_COAST_MS / 1000.0f) {
+        restart(bearing, range, t);
+        return;
+    }
+
+    float rb = residual(s_bearing, bearing, dt);
+    float rr = residual(s_range,   range,   dt);
+    if (fabsf(rb) <= FOLLOW_GATE_DEG && fabsf(rr) <= FOLLOW_GATE_CM) {
+        abCorrect(s_bearing, rb, dt, FOLLOW_MAX_DEG_S);
+        abCorrect(s_range,   rr, dt, FOLLOW_MAX_CM_S);
+        s_t = t;
+        s_outliers = 0;
+    } else if (++s_outliers >= 3) {
+        // three in a row disagree with the track: the target jumped
+        LOGD(LM_FOLLOW, "track re-init b=%.0f r=%.0f", bearing, range);
+        restart(bearing, range, t);
+    }
+}
+
+void trackMiss() { s_missed = true; }
+
+bool trackPredict(uint32_t now, TrackState &out) {
+    if (!s_t) return false;
+    uint32_t age = now - s_t;
+    if (age > FOLLOW_COAST_MS) {
+        s_t = 0;
+        return false;
+    }
+
+    float h = (age + FOLLOW_ACT_LAT_MS) / 1000.0f;
+    out.bearingDeg  = s_bearing.x + s_bearing.v * h;
+    out.bearingRate = s_bearing.v;
+    out.rangeCm     = max(0.0f, s_range.x + s_range.v * h);
+    out.rangeRate   = s_range.v;
+    out.ageMs       = age;
+    out.latencyMs   = s_rxMs - s_t;
+    out.coasting    = s_missed;
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "huskylens_uart.h"
+
+// ── Follow target tracker ───────────────────────────────────────────
+// Constant-velocity alpha-beta filter on bearing and ground range.
+// Each camera frame is a measurement stamped at its capture time; the
+// estimate is then predicted forward to "now + actuation latency", so
+// the command sent this tick is aimed at where the target will be when
+// the wheels respond.  Short detection gaps coast on the velocity.
+struct TrackState {
+    float    bearingDeg;   // + = target right of the chassis axis
+    float    bearingRate;  // deg/s
+    float    rangeCm;      // ground distance to the tag
+    float    rangeRate;    // cm/s, + = walking away
+    uint16_t ageMs;        // since the last measurement was captured
+    uint16_t latencyMs;    // capture → now of the last frame (measured)
+    bool     coasting;     // no measurement in the last camera frame
+};
+
+void trackReset();
+// panDeg: chassis-relative pan when the frame was captured (gimbalPanAt)
+void trackMeasure(const HuskyResult &tag, uint32_t captureMs, float panDeg, float tiltDeg);
+void trackMiss();                                   // camera frame without the tag
+bool trackPredict(uint32_t now, TrackState &out);   // false = no track / coasted out
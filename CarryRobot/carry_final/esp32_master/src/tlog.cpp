@@ -0,0 +1,108 @@
+#include "tlog.h"
+#include "uart_protocol.h"
+
+static const char *const MODULE_NAMES[LM_COUNT] = {
+    "MAIN", "MODE", "UART", "AUTO", "FOLLOW", "FIND", "RECOVERY", "MQTT",
+    "HUSKY", "SR05", "ESTOP", "PARAM", "REC", "REG", "TELEM", "PROF",
+};
+
+uint8_t g_tlogLevel[LM_COUNT];
+
+// ── byte ring of whole records (ESP32 + forwarded STM32) ────────────
+static uint8_t  s_ring[TLOG_RING_SIZE];
+static uint16_t s_head    = 0;         // write
+static uint16_t s_tail    = 0;         // read
+static uint16_t s_used    = 0;
+static uint8_t  s_dropped = 0;         // since last frame, saturating
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void tlogInit() {
+    tlogSetLevel(LM_COUNT, TLOG_DEFAULT_LEVEL);
+}
+
+void tlogSetLevel(uint8_t module, uint8_t level) {
+    if (module >= LM_COUNT) {
+        for (uint8_t i = 0; i < LM_COUNT; i++) g_tlogLevel[i] = level;
+    } else {
+        g_tlogLevel[module] = level;
+    }
+}
+
+const char *tlogModuleName(uint8_t module) {
+    return module < LM_COUNT ? MODULE_NAMES[module] : "?";
+}
+
+void tlogBegin(TlogRec &r, uint32_t token, uint8_t module, uint8_t level) {
+    uint32_t t = millis();
+    uint8_t  h = (TLOG_SOURCE << 7) | ((module & 0x0F) << 3) | (level & 0x07);
+    r.n = 1;                                   // [0] = length, set on commit
+    r.put(&token, 4);
+    r.put(&h, 1);
+    r.put(&t, 4);
+}
+
+static void push(const uint8_t *rec, uint8_t len, uint8_t dropped) {
+    portENTER_CRITICAL(&s_mux);
+    uint16_t d = s_dropped + dropped;
+    if (TLOG_RING_SIZE - s_used < len) d++;
+    else {
+        for (uint8_t i = 0; i < len; i++) {
+            s_ring[s_head] = rec[i];
+            s_head = (s_head + 1) % TLOG_RING_SIZE;
+        }
+        s_used += len;
+    }
+    s_dropped = d > 0xFF ? 0xFF : d;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void tlogCommit(TlogRec &r) {
+    r.d[0] = r.n;
+    push(r.d, r.n, 0);
+}
+
+// STM32 frame: [dropped][record…] – records keep their source bit
+void tlogForward(const uint8_t *data, uint8_t len) {
+    if (len < 1) return;
+    uint8_t dropped = data[0];
+    uint8_t i = 1;
+    while (i < len) {
+        uint8_t n = data[i];
+        if (n < 10 || i + n > len) break;      // malformed tail
+        push(data + i, n, dropped);
+        dropped = 0;
+        i += n;
+    }
+    if (dropped) push(nullptr, 0, dropped);
+}
+
+// ── drain: one CMD_LOG frame per call, only if it fits the TX buffer ─
+//   same payload as the STM32 frame: [dropped u8][record…]
+void tlogFlush() {
+    if (s_used == 0 && s_dropped == 0) return;
+
+    uint8_t buf[TLOG_FRAME_MAX];
+    uint8_t n = 1;
+    portENTER_CRITICAL(&s_mux);
+    uint16_t tail = s_tail, used = s_used, taken = 0;
+    while (used > 0) {
+        uint8_t len = s_ring[tail];
+        if (n + len > TLOG_FRAME_MAX) break;
+        for (uint8_t i = 0; i < len; i++)
+            buf[n++] = s_ring[(tail + i) % TLOG_RING_SIZE];
+        tail   = (tail + len) % TLOG_RING_SIZE;
+        used  -= len;
+        taken += len;
+    }
+    buf[0] = s_dropped;
+    portEXIT_CRITICAL(&s_mux);
+
+    if (Serial.availableForWrite() < n + 4) return;   // retry next loop
+    uartSendFrame(Serial, CMD_LOG, buf, n);
+
+    portENTER_CRITICAL(&s_mux);
+    s_tail     = tail;
+    s_used    -= taken;
+    s_dropped -= buf[0];
+    portEXIT_CRITICAL(&s_mux);
+}
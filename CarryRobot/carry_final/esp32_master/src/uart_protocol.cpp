@@ -29,7 +29,7 @@ void uartSendFrame(HardwareSerial &port, uint8_t cmd,
     frame[idx] = crc8(&frame[2], payloadLen);
     idx++;
 
-    port.write(frame, idx);
+    port.write(frame, idx);     // one write: the UART driver keeps it whole across tasks
 }
 
 // ── Receive (state machine, non-blocking) ───────────────────────────
@@ -7,24 +7,23 @@
 #include "pn532_reader.h"
 #include "tof_sensor.h"
 #include "uart_protocol.h"
+#include "mission_store.h"
+#include "regmap.h"
+#include "params.h"
+#include "profiler.h"
+#include "recorder.h"
+#include "tlog.h"
 
 extern HardwareSerial Serial2;   // UART to ESP32
 
 // ── line-lost threshold (~50 × 2ms main loop = ~100ms) ─────────────
 #define LINE_LOST_THRESHOLD  50
-static bool     s_lineLostSent = false;
 static uint32_t s_lastLineLostLog = 0;
 
-// Send short debug text to ESP32 (shows as [STM32] ... on monitor)
-static void sendDebug(const char *msg) {
-    uint8_t n = strlen(msg);
-    if (n > 100) n = 100;
-    uartSendFrame(Serial2, CMD_DEBUG_MSG, (const uint8_t*)msg, n);
-}
-
 // ── PID state ───────────────────────────────────────────────────────
 static float prevErr    = 0.0f;
 static float integral   = 0.0f;
+static float pidP = 0.0f, pidI = 0.0f, pidD = 0.0f;   // last terms (telemetry)
 
 // ── auto runner states ──────────────────────────────────────────────
 enum RunState : uint8_t {
@@ -32,6 +31,8 @@ enum RunState : uint8_t {
     RUN_LINE_FOLLOW,
     RUN_TURNING,
     RUN_OBSTACLE,
+    RUN_LINE_SEARCH,    // local sweep after losing the line
+    RUN_LINE_LOST,      // search gave up – holding, ESP32 informed
     RUN_DONE
 };
 
@@ -39,18 +40,160 @@ static RunState  runState = RUN_IDLE;
 static uint32_t  turnEnd  = 0;
 static bool      obstacleReported = false;
 
+// ── line search state ───────────────────────────────────────────────
+static uint32_t  searchStart    = 0;
+static uint32_t  sweepEnd       = 0;
+static int8_t    sweepDir       = 1;     // -1 left, +1 right
+static uint8_t   sweepCount     = 0;
+
+// ── leg frame ───────────────────────────────────────────────────────
+// Travel direction relative to the chassis, in clockwise quarter turns.
+// Turns rotate the chassis back to LEG_FWD; holonomic actions only move
+// the frame.  Every route starts on LEG_FWD; the frame is persisted with
+// the progress index so a resumed mission continues on the right leg.
+enum LegFrame : uint8_t { LEG_FWD, LEG_RIGHT, LEG_REV, LEG_LEFT };
+
+static uint8_t s_leg = LEG_FWD;
+static const char *const LEG_NAMES[] = { "fwd", "right", "rev", "left" };
+
+static uint8_t actionQuarters(uint8_t action) {
+    switch (action) {
+    case ROUTE_ACT_RIGHT: case ROUTE_ACT_STRAFE_R: return 1;
+    case ROUTE_ACT_BACK:  case ROUTE_ACT_REVERSE:  return 2;
+    case ROUTE_ACT_LEFT:  case ROUTE_ACT_STRAFE_L: return 3;
+    default: return 0;
+    }
+}
+
+static bool isHolonomic(uint8_t action) {
+    return action == ROUTE_ACT_STRAFE_L || action == ROUTE_ACT_STRAFE_R ||
+           action == ROUTE_ACT_REVERSE;
+}
+
+static bool isArc(uint8_t action) {
+    return action == ROUTE_ACT_ARC_L || action == ROUTE_ACT_ARC_R;
+}
+
+static bool isTurn(uint8_t action) {
+    return action == ROUTE_ACT_LEFT || action == ROUTE_ACT_RIGHT ||
+           action == ROUTE_ACT_BACK || isArc(action);
+}
+
+// travel velocity of the current leg in chassis coordinates
+static void legVector(int speed, int &vx, int &vy) {
+    switch (s_leg) {
+    case LEG_RIGHT: vx =  speed; vy = 0;      break;
+    case LEG_REV:   vx = 0;      vy = -speed; break;
+    case LEG_LEFT:  vx = -speed; vy = 0;      break;
+    default:        vx = 0;      vy =  speed; break;
+    }
+}
+
+// motorBrake() pulses backwards – pulse against the leg instead
+static void legBrake() {
+    int vx, vy;
+    legVector(param(P_BRAKE_PWM), vx, vy);
+    mecanumDrive(-vx, -vy, 0);
+    motorDelay(param(P_BRAKE_MS));
+    motorStop();
+}
+
+static void setLeg(uint8_t leg) {
+    s_leg    = leg & 3;
+    prevErr  = 0.0f;
+    integral = 0.0f;
+    LOGI(LM_RUN, "leg %s", LEG_NAMES[s_leg]);
+}
+
+// frame once the action at a checkpoint has run (what startTurn leaves)
+static uint8_t legThrough(uint8_t leg, uint8_t action) {
+    if (isTurn(action))      return LEG_FWD;
+    if (isHolonomic(action)) return (leg + actionQuarters(action)) & 3;
+    return leg;
+}
+
+// travel speed of a leg; the ToF only watches LEG_FWD's direction, so
+// the others never exceed LEG_BLIND_MAX_SPEED (nor the run speed)
+static int legSpeed(int nominal) {
+    return min(nominal, min((int)LEG_BLIND_MAX_SPEED, (int)param(P_RUN_SPEED)));
+}
+
+// ── per-run KPI (CMD_RUN_KPI) ───────────────────────────────────────
+// Loop time is charged to the bucket of the current run state; blocking
+// turns are timed around the call.  Gaps longer than KPI_MAX_TICK_MS
+// (e-stop hold – loop() skips the runner) stay out of every bucket.
+#define KPI_MAX_TICK_MS  100
+
+static RunKpi   s_kpi;
+static bool     s_kpiActive = false;
+static uint32_t s_kpiStart  = 0;
+static uint32_t s_kpiTick   = 0;
+static uint32_t s_kpiReads0 = 0, s_kpiHits0 = 0;
+
+static void kpiStart(uint8_t flags) {
+    memset(&s_kpi, 0, sizeof(s_kpi));
+    s_kpi.flags = flags;
+    s_kpiStart  = s_kpiTick = millis();
+    nfcStats(s_kpiReads0, s_kpiHits0);
+    s_kpiActive = true;
+}
+
+static void kpiAccount() {
+    uint32_t now = millis();
+    uint32_t dt  = now - s_kpiTick;
+    s_kpiTick = now;
+    if (!s_kpiActive || dt > KPI_MAX_TICK_MS) return;
+    switch (runState) {
+    case RUN_LINE_FOLLOW: s_kpi.followMs   += dt; break;
+    case RUN_TURNING:     s_kpi.turnMs     += dt; break;
+    case RUN_OBSTACLE:    s_kpi.obstacleMs += dt; break;
+    case RUN_LINE_SEARCH:
+    case RUN_LINE_LOST:   s_kpi.lineLostMs += dt; break;
+    default: break;
+    }
+}
+
+// blocking turn finished: charge it and restart the tick
+static void kpiTurn(uint32_t t0) {
+    s_kpiTick = millis();
+    if (s_kpiActive) s_kpi.turnMs += s_kpiTick - t0;
+}
+
+static void kpiFinish(uint8_t end) {
+    if (!s_kpiActive) return;
+    s_kpiActive = false;
+    uint32_t reads, hits;
+    nfcStats(reads, hits);
+    s_kpi.end      = end;
+    s_kpi.runMs    = millis() - s_kpiStart;
+    s_kpi.nfcReads = (uint16_t)min(reads - s_kpiReads0, (uint32_t)0xFFFF);
+    s_kpi.nfcHits  = (uint16_t)min(hits - s_kpiHits0, (uint32_t)0xFFFF);
+    uartSendFrame(Serial2, CMD_RUN_KPI, (const uint8_t *)&s_kpi, sizeof(s_kpi));
+    LOGI(LM_RUN, "kpi run=%lu ms follow=%lu turn=%lu obst=%lu lost=%lu",
+         (unsigned long)s_kpi.runMs, (unsigned long)s_kpi.followMs,
+         (unsigned long)s_kpi.turnMs, (unsigned long)s_kpi.obstacleMs,
+         (unsigned long)s_kpi.lineLostMs);
+}
+
 // ── report checkpoint to ESP32 ──────────────────────────────────────
 static void reportCheckpoint(uint16_t id) {
+    if (s_kpiActive && s_kpi.checkpoints < 0xFF) s_kpi.checkpoints++;
     uint8_t buf[2] = { (uint8_t)(id >> 8), (uint8_t)(id & 0xFF) };
     uartSendFrame(Serial2, CMD_CHECKPOINT, buf, 2);
+    regCount(REG_CNT_CHECKPOINT);
+    recEvent(REC_EV_CHECKPOINT, id);
 }
 
 static void reportMissionDone() {
     uartSendFrame(Serial2, CMD_MISSION_DONE, nullptr, 0);
+    regCount(REG_CNT_MISSION_DONE);
 }
 
 static void reportObstacle() {
+    s_kpi.obstacles++;
     uartSendFrame(Serial2, CMD_OBSTACLE, nullptr, 0);
+    regCount(REG_CNT_OBSTACLE);
+    recTrigger(REC_TRIG_OBSTACLE, (uint16_t)tofLastMm());
 }
 
 static void reportMismatch(uint16_t got, uint16_t expected) {
@@ -59,56 +202,260 @@ static void reportMismatch(uint16_t got, uint16_t expected) {
         (uint8_t)(expected >> 8), (uint8_t)(expected & 0xFF)
     };
     uartSendFrame(Serial2, CMD_MISMATCH, buf, 4);
+    regCount(REG_CNT_MISMATCH);
+    recTrigger(REC_TRIG_MISMATCH, got);
+}
+
+static void reportSkipped(uint8_t from, uint8_t count) {
+    uint8_t buf[1 + ROUTE_LOOKAHEAD * 2];
+    buf[0] = count;
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t id = g_route[from + i].checkpointId;
+        buf[1 + i * 2]     = (uint8_t)(id >> 8);
+        buf[1 + i * 2 + 1] = (uint8_t)(id & 0xFF);
+    }
+    uartSendFrame(Serial2, CMD_SKIPPED, buf, 1 + count * 2);
+    s_kpi.skipped += count;
+    regCount(REG_CNT_SKIPPED, count);
+    recEvent(REC_EV_SKIPPED, count);
+}
+
+// ── look-ahead match after a missed NFC read ────────────────────────
+// Returns how many route points were skipped (1..ROUTE_LOOKAHEAD) if `id`
+// is a little further down the route, 0 if it is off-route.
+// Skipping is only consistent when every missed point was a straight
+// pass ('F') – a missed turn or leg change means we cannot be at the
+// later tag.
+static uint8_t matchAhead(uint16_t id) {
+    for (uint8_t k = 1; k <= ROUTE_LOOKAHEAD; k++) {
+        uint8_t idx = g_routeIdx + k;
+        if (idx >= g_routeLen) break;
+        if (g_route[idx - 1].action != ROUTE_ACT_FWD) break;
+        if (g_route[idx].checkpointId == id) return k;
+    }
+    return 0;
 }
 
 // ── line-follow PID step ────────────────────────────────────────────
-static void lineFollowStep() {
+// Returns false once the line has been missing for LINE_LOST_THRESHOLD
+// reads; the caller then starts the local search.
+static bool lineFollowStep() {
+    PROF_SCOPE(PROF_LINE_FOLLOW);
     float err = lineReadError();
 
-    // ── line-lost health check ──────────────────────────────────────
-    uint16_t lost = lineConsecLost();
-    if (lost >= LINE_LOST_THRESHOLD) {
-        if (!s_lineLostSent) {
-            s_lineLostSent = true;
-            sendDebug("LINE: lost line");
-            uartSendFrame(Serial2, CMD_LINE_LOST, nullptr, 0);
-        }
-        // throttle repeated debug logs to every 2s
-        uint32_t now = millis();
-        if (now - s_lastLineLostLog > 2000) {
-            s_lastLineLostLog = now;
-            Serial.printf("[LINE] lost %u reads\n", lost);
-        }
-    } else {
-        s_lineLostSent = false;
-    }
+    if (lineConsecLost() >= LINE_LOST_THRESHOLD) return false;
 
     integral += err;
     float deriv = err - prevErr;
     prevErr = err;
 
-    float correction = LF_KP * err + LF_KI * integral + LF_KD * deriv;
-    correction = constrain(correction, -LF_MAX_CORR, LF_MAX_CORR);
+    pidP = paramGain(P_LF_KP) * err;
+    pidI = paramGain(P_LF_KI) * integral;
+    pidD = paramGain(P_LF_KD) * deriv;
+    float correction = pidP + pidI + pidD;
+    float maxCorr = param(P_LF_MAX_CORR);
+    correction = constrain(correction, -maxCorr, maxCorr);
 
     int vr = (int)correction;
-    int vy = LF_BASE_SPEED;
 
-    mecanumDrive(0, vy, vr);
+    switch (s_leg) {
+    case LEG_FWD:
+        mecanumDrive(0, param(P_RUN_SPEED), vr);
+        break;
+    case LEG_REV:
+        // the bar trails – shift it sideways onto the line, no steering
+        mecanumDrive(vr, -legSpeed(LEG_REVERSE_SPEED), 0);
+        break;
+    default: {
+        // The bar lies along the line, so a reading only says which end
+        // is off it – never whether the chassis sits fore or aft of it,
+        // and no yaw or fore/aft correction has a sign that follows.
+        // Translation only, then: an off leading eye means the line bends
+        // or ends ahead, so the strafe slows (to half with only the
+        // trailing eye left) and a full loss starts the fore/aft search
+        // close to where the line went.
+        int   dir  = (s_leg == LEG_RIGHT) ? 1 : -1;     // R eye leads on LEG_RIGHT
+        float lead = err * dir;                          // < 0: leading end off
+        float k    = 1.0f + 0.5f * min(lead, 0.0f);
+        mecanumDrive(dir * (int)(legSpeed(LEG_STRAFE_SPEED) * k), 0, 0);
+        break;
+    }
+    }
+    return true;
+}
+
+// ── line-lost local search ──────────────────────────────────────────
+// First sweep arcs toward the side that last saw the line (the usual
+// case: overshooting a curve); following sweeps rotate in place across
+// the centre with twice the duration.  Bounded by LINE_SEARCH_MAX_MS.
+// Holonomic legs translate instead: sideways on reverse legs, fore/aft
+// across the line on strafe legs.
+static void startSweep(uint32_t now) {
+    bool first = (sweepCount == 0);
+    uint32_t dur = first ? LINE_SEARCH_SWEEP_MS : 2 * LINE_SEARCH_SWEEP_MS;
+    switch (s_leg) {
+    case LEG_FWD:
+        mecanumDrive(0, first ? LINE_SEARCH_VY : 0, sweepDir * LINE_SEARCH_VR);
+        break;
+    case LEG_REV:
+        mecanumDrive(sweepDir * legSpeed(LINE_SEARCH_VX), first ? -LINE_SEARCH_VY : 0, 0);
+        break;
+    default:
+        mecanumDrive(0, sweepDir * legSpeed(LINE_SEARCH_VX), 0);
+        break;
+    }
+    sweepEnd = now + dur;
+}
+
+static void startLineSearch() {
+    uint32_t now = millis();
+    bool strafe = (s_leg == LEG_LEFT || s_leg == LEG_RIGHT);
+    int8_t side = strafe ? 0 : lineLastSide();   // no side info along the bar
+    sweepDir    = (side != 0) ? side : 1;
+    sweepCount  = 0;
+    searchStart = now;
+    startSweep(now);
+    runState = RUN_LINE_SEARCH;
+    s_kpi.lineLost++;
+    regCount(REG_CNT_LINE_SEARCH);
+    recEvent(REC_EV_LINE_SEARCH, (uint16_t)(int16_t)sweepDir);
+    LOGI(LM_LINE, "lost – searching %s",
+         strafe ? (sweepDir < 0 ? "aft" : "fore")
+                : (sweepDir < 0 ? "left" : "right"));
+}
+
+static void lineSearchStep() {
+    uint32_t now = millis();
+
+    if (lineDetected()) {
+        lineHealthReset();
+        prevErr  = 0.0f;
+        integral = 0.0f;
+        runState = RUN_LINE_FOLLOW;
+        LOGI(LM_LINE, "reacquired after %lu ms", (unsigned long)(now - searchStart));
+        return;
+    }
+
+    if (now - searchStart >= LINE_SEARCH_MAX_MS) {
+        motorStop();
+        runState = RUN_LINE_LOST;
+        LOGW(LM_LINE, "lost line, search failed");
+        uartSendFrame(Serial2, CMD_LINE_LOST, nullptr, 0);
+        regCount(REG_CNT_LINE_LOST);
+        recTrigger(REC_TRIG_LINE_LOST);
+        return;
+    }
+
+    if ((int32_t)(now - sweepEnd) >= 0) {
+        sweepCount++;
+        sweepDir = -sweepDir;
+        startSweep(now);
+    }
+}
+
+// ── arc turn ────────────────────────────────────────────────────────
+// Drives through the corner instead of stop–rotate–go: starts at the
+// tag, ramps vr in over ARC_RAMP_MS and hands back to the PID once the
+// centre sensor finds the new line past ARC_ACQUIRE_PCT of the nominal
+// arc.  Only in the forward frame – holonomic legs rotate instead.
+// The tag sits on the junction, so a pure arc would end r past it and
+// never cross the new line: the distance travelled along the old line
+// is dead-reckoned from the heading and strafed back out with vx
+// toward the inside of the corner.
+static uint32_t arcStart   = 0;
+static uint32_t arcNominal = 0;      // ms for 90° at arcVr
+static uint32_t arcTick    = 0;
+static int      arcVy = 0, arcVr = 0;
+static float    arcOver = 0.0f;      // along the old line past the tag, PWM·s
+static int      arcVx   = 0;
+static uint32_t arcPaused = 0;       // elapsed arc time when an obstacle stopped it
+
+static void startArc(uint8_t action, const RoutePoint &p) {
+    int vy = p.arcSpeed  ? p.arcSpeed  : ARC_DEFAULT_SPEED;
+    int r  = p.arcRadius ? p.arcRadius : ARC_DEFAULT_RADIUS_CM;
+    int vr = max(1, vy * ARC_LXY_CM / r);
+    // mecanumDrive() scales both terms alike above 255 – do it here so
+    // the timing below matches
+    int peak = vy + vr;
+    if (peak > 255) {
+        vy = vy * 255 / peak;
+        vr = max(1, vr * 255 / peak);
+    }
+    arcVy = vy;
+    arcVr = (action == ROUTE_ACT_ARC_L) ? -vr : vr;
+    arcNominal = (uint32_t)param(P_TURN_90_MS) * param(P_TURN_SPEED) / vr
+               + ARC_RAMP_MS / 2;
+    arcStart = arcTick = millis();
+    arcOver  = 0.0f;
+    arcVx    = 0;
+    runState = RUN_TURNING;
+    LOGI(LM_RUN, "arc %c r=%d cm vy=%d vr=%d ~%lu ms", action, r, arcVy, arcVr,
+         (unsigned long)arcNominal);
+}
+
+static void arcStep() {
+    uint32_t now = millis();
+    uint32_t t   = now - arcStart;
+
+    // heading from the nominal timing; the overshoot grows with vy along
+    // the old line and shrinks with the inward strafe
+    float th = min(1.0f, (float)t / arcNominal) * 1.5707963f;
+    float dt = (now - arcTick) / 1000.0f;
+    arcTick  = now;
+    arcOver += (arcVy * cosf(th) - abs(arcVx) * sinf(th)) * dt;
+    int vxIn = constrain((int)(arcOver * ARC_VX_GAIN), 0, arcVy);
+    arcVx    = (arcVr < 0) ? -vxIn : vxIn;
+
+    int vr = (t < ARC_RAMP_MS) ? arcVr * (int)t / ARC_RAMP_MS : arcVr;
+    mecanumDrive(arcVx, arcVy, vr);
+
+    if (t >= arcNominal * ARC_ACQUIRE_PCT / 100 && lineCenter()) {
+        lineHealthReset();
+        prevErr  = 0.0f;
+        integral = 0.0f;
+        runState = RUN_LINE_FOLLOW;
+        LOGD(LM_RUN, "arc done %lu ms", (unsigned long)t);
+        return;
+    }
+    if (t >= arcNominal * ARC_TIMEOUT_PCT / 100) {
+        LOGW(LM_RUN, "arc: no line after %lu ms", (unsigned long)t);
+        startLineSearch();
+    }
 }
 
 // ── execute turn action ─────────────────────────────────────────────
 static void startTurn(uint8_t action) {
+    if (action != ROUTE_ACT_FWD) recEvent(REC_EV_TURN, action);
     switch (action) {
-    case 'L':
-        mecanumTurnLeft90();
-        break;
-    case 'R':
-        mecanumTurnRight90();
+    case ROUTE_ACT_ARC_L:
+    case ROUTE_ACT_ARC_R:
+        if (s_leg == LEG_FWD) {
+            startArc(action, g_route[g_routeIdx - 1]);   // point just passed
+            return;
+        }
+        action = (action == ROUTE_ACT_ARC_L) ? ROUTE_ACT_LEFT : ROUTE_ACT_RIGHT;
+        // fall through
+    case ROUTE_ACT_LEFT:
+    case ROUTE_ACT_RIGHT:
+    case ROUTE_ACT_BACK:
+        // relative to travel: on a holonomic leg the chassis needs a
+        // different rotation (or none) to face the new leg
+        if (s_leg != LEG_FWD) legBrake();
+        switch ((s_leg + actionQuarters(action)) & 3) {
+        case 1: mecanumTurnRight90(); break;
+        case 2: mecanumTurn180();     break;
+        case 3: mecanumTurnLeft90();  break;
+        default: break;
+        }
+        setLeg(LEG_FWD);
         break;
-    case 'B':
-        mecanumTurn180();
+    case ROUTE_ACT_STRAFE_L:
+    case ROUTE_ACT_STRAFE_R:
+    case ROUTE_ACT_REVERSE:
+        legBrake();
+        setLeg(s_leg + actionQuarters(action));
         break;
-    case 'S':  // stop at destination
+    case ROUTE_ACT_STOP:  // stop at destination
         motorStop();
         break;
     default:   // 'F' – just keep going
@@ -119,17 +466,42 @@ static void startTurn(uint8_t action) {
 // ──────────────────────────────────────────────────────────────────
 void autoRunnerInit() {
     runState  = RUN_IDLE;
+    s_leg     = LEG_FWD;
+    arcPaused = 0;
     prevErr   = 0.0f;
     integral  = 0.0f;
     obstacleReported = false;
     lineHealthReset();
-    s_lineLostSent = false;
 }
 
 bool autoRunnerBusy() {
     return runState == RUN_LINE_FOLLOW ||
            runState == RUN_TURNING ||
-           runState == RUN_OBSTACLE;
+           runState == RUN_OBSTACLE ||
+           runState == RUN_LINE_SEARCH ||
+           runState == RUN_LINE_LOST;
+}
+
+uint8_t autoRunnerState() { return runState; }
+
+void autoRunnerPidTerms(float &p, float &i, float &d) {
+    p = pidP; i = pidI; d = pidD;
+}
+
+bool autoRunnerResume() {
+    if (!missionStoreLoad()) return false;
+    g_missionStart   = false;
+    g_missionCancel  = false;
+    g_missionRunning = true;
+    prevErr  = 0.0f;
+    integral = 0.0f;
+    lineHealthReset();
+    s_leg    = missionStoreLeg();
+    runState = RUN_LINE_FOLLOW;
+    kpiStart(KPI_FLAG_RESUMED);
+    LOGI(LM_RUN, "resumed at %u/%u leg %s", g_routeIdx, g_routeLen,
+         LEG_NAMES[s_leg]);
+    return true;
 }
 
 void autoRunnerLoop() {
@@ -142,9 +514,11 @@ void autoRunnerLoop() {
         g_missionRunning = true;
         g_routeIdx = 0;
         runState = RUN_LINE_FOLLOW;
-        prevErr  = 0.0f;
-        integral = 0.0f;
-        Serial.println("[RUN] mission start");
+        setLeg(LEG_FWD);
+        missionStoreSaveRoute();
+        kpiStart(0);
+        recEvent(REC_EV_MISSION, g_routeLen);
+        LOGI(LM_RUN, "mission start");
     }
 
     // ── cancel ─────────────────────────────────────────────────────
@@ -152,17 +526,24 @@ void autoRunnerLoop() {
         g_missionCancel  = false;
         g_missionRunning = false;
         motorStop();
-        runState = RUN_IDLE;
-        Serial.println("[RUN] cancelled → reading NFC");
+        if (runState != RUN_IDLE && runState != RUN_DONE)
+            recTrigger(REC_TRIG_CANCEL, g_routeIdx);
+        kpiFinish(KPI_END_CANCEL);
+        runState  = RUN_IDLE;
+        arcPaused = 0;
+        missionStoreClear();
+        LOGI(LM_RUN, "cancelled → reading NFC");
         // read current NFC checkpoint and report to ESP32
         uint16_t nfcId = nfcReadCheckpoint();
         if (nfcId != 0) {
             reportCheckpoint(nfcId);
-            Serial.printf("[RUN] cancel CP=%u\n", nfcId);
+            LOGI(LM_RUN, "cancel CP=%u", nfcId);
         }
         return;
     }
 
+    kpiAccount();
+
     switch (runState) {
 
     case RUN_IDLE:
@@ -182,50 +563,135 @@ void autoRunnerLoop() {
         obstacleReported = false;
 
         // line follow
-        lineFollowStep();
+        if (!lineFollowStep()) {
+            startLineSearch();
+            break;
+        }
 
         // NFC checkpoint check
         {
             uint16_t nfcId = nfcReadCheckpoint();
             if (nfcId != 0 && g_routeIdx < g_routeLen) {
                 uint16_t expected = g_route[g_routeIdx].checkpointId;
-                uint8_t  action   = g_route[g_routeIdx].action;
+
+                if (nfcId != expected) {
+                    uint8_t skipped = matchAhead(nfcId);
+                    if (skipped > 0) {
+                        reportSkipped(g_routeIdx, skipped);
+                        LOGW(LM_RUN, "skipped %u CP → got=%u", skipped, nfcId);
+                        g_routeIdx += skipped;
+                        expected = nfcId;
+                    }
+                }
+                uint8_t action = g_route[g_routeIdx].action;
 
                 if (nfcId == expected) {
                     reportCheckpoint(nfcId);
                     g_routeIdx++;
+                    missionStoreSaveProgress(g_routeIdx, legThrough(s_leg, action));
 
                     // last checkpoint?
-                    if (g_routeIdx >= g_routeLen || action == 'S') {
-                        motorStop();
-                        mecanumTurn180();     // quay 180° tại đích
-                        motorStop();
+                    bool hold = (action == ROUTE_ACT_HOLD);
+                    if (g_routeIdx >= g_routeLen || action == ROUTE_ACT_STOP || hold) {
+                        uint32_t t0 = millis();
+                        if (hold) {
+                            legBrake();       // no 180°: the next route starts on LEG_FWD
+                        } else {
+                            motorStop();
+                            mecanumTurn180(); // quay 180° tại đích
+                            motorStop();
+                        }
+                        kpiTurn(t0);
+                        kpiFinish(KPI_END_DONE);
                         reportMissionDone();
                         g_missionRunning = false;
                         runState = RUN_DONE;
-                        Serial.println("[RUN] arrived → 180° → done");
+                        missionStoreClear();
+                        LOGI(LM_RUN, "arrived → %s → done", hold ? "hold" : "180°");
                     } else {
                         // execute action at this checkpoint
+                        uint32_t t0 = millis();
                         startTurn(action);
+                        kpiTurn(t0);
                     }
                 } else {
-                    // mismatch!
-                    motorBrake();
+                    // off-route tag – mismatch!
+                    uint32_t t0 = millis();
+                    legBrake();
                     reportMismatch(nfcId, expected);
                     mecanumTurn180();
+                    kpiTurn(t0);
+                    kpiFinish(KPI_END_MISMATCH);
                     // wait for ESP32 to send new route
                     g_missionRunning = false;
                     runState = RUN_IDLE;
-                    Serial.printf("[RUN] mismatch got=%u exp=%u\n", nfcId, expected);
+                    missionStoreClear();
+                    LOGW(LM_RUN, "mismatch got=%u exp=%u", nfcId, expected);
                 }
             }
         }
         break;
 
+    case RUN_TURNING:
+        if (tofObstacle()) {
+            motorStop();
+            if (!obstacleReported) {
+                reportObstacle();
+                obstacleReported = true;
+            }
+            arcPaused = max((uint32_t)1, millis() - arcStart);   // resume the corner, not the PID
+            runState = RUN_OBSTACLE;
+            break;
+        }
+        arcStep();
+        break;
+
     case RUN_OBSTACLE:
         if (tofClear()) {
+            if (arcPaused) {
+                // same heading and overshoot, the time left unchanged
+                arcTick   = millis();
+                arcStart  = arcTick - arcPaused;
+                arcPaused = 0;
+                runState  = RUN_TURNING;
+            } else {
+                runState = RUN_LINE_FOLLOW;
+            }
+            LOGI(LM_RUN, "obstacle cleared");
+        }
+        break;
+
+    case RUN_LINE_SEARCH:
+        if (tofObstacle()) {
+            motorStop();
+            if (!obstacleReported) {
+                reportObstacle();
+                obstacleReported = true;
+            }
+            runState = RUN_OBSTACLE;
+            break;
+        }
+        lineSearchStep();
+        break;
+
+    case RUN_LINE_LOST:
+        // hold until the line shows up again (e.g. robot put back on it)
+        if (lineDetected()) {
+            lineHealthReset();
+            prevErr  = 0.0f;
+            integral = 0.0f;
             runState = RUN_LINE_FOLLOW;
-            Serial.println("[RUN] obstacle cleared");
+            LOGI(LM_LINE, "line back, resuming");
+            break;
+        }
+        {
+            // throttle repeated debug logs to every 2s
+            uint32_t now = millis();
+            if (now - s_lastLineLostLog > 2000) {
+                s_lastLineLostLog = now;
+                LOGD(LM_LINE, "still lost (%lu s)",
+                     (unsigned long)((now - searchStart) / 1000));
+            }
         }
         break;
 
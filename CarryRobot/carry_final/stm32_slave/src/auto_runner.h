@@ -4,3 +4,8 @@
 void autoRunnerInit();
 void autoRunnerLoop();   // call from main loop when in AUTO mode
 bool autoRunnerBusy();
+bool autoRunnerResume(); // continue persisted mission after a reset
+
+// telemetry accessors
+uint8_t autoRunnerState();
+void    autoRunnerPidTerms(float &p, float &i, float &d);
@@ -0,0 +1,57 @@
+#include "boot.h"
+#include "uart_protocol.h"
+#include "mission_store.h"
+#include "pn532_reader.h"
+#include "tof_sensor.h"
+#include "tlog.h"
+
+extern HardwareSerial Serial2;   // UART to ESP32
+
+static uint8_t  s_sentPeriph = 0;
+static bool     s_ready      = false;    // CMD_READY sent at least once
+
+uint8_t bootCaps() {
+    return BOOT_CAP_NFC | BOOT_CAP_RESUME | BOOT_CAP_RECORDER
+         | (USE_TOF        ? BOOT_CAP_TOF        : 0)
+         | (USE_ESTOP_LINE ? BOOT_CAP_ESTOP_LINE : 0)
+         | (USE_PROFILER   ? BOOT_CAP_PROFILER   : 0)
+         | (TLOG_TEXT      ? 0 : BOOT_CAP_TLOG);
+}
+
+uint8_t bootPeriph() {
+    return (nfcAvailable() ? BOOT_PERIPH_NFC : 0)
+         | (tofAvailable() ? BOOT_PERIPH_TOF : 0)
+         | ((nfcSettled() && tofSettled()) ? BOOT_PERIPH_SETTLED : 0);
+}
+
+// data: uint8 resumable, len, idx, uint16 lastCp, uint8 caps, periph
+void bootSendFrame() {
+    uint8_t  len = missionStoreRouteLen();
+    uint8_t  idx = missionStoreRouteIdx();
+    uint16_t cp  = missionStoreLastCheckpoint();
+    uint8_t buf[7] = { (uint8_t)missionStoreResumable(), len, idx,
+                       (uint8_t)(cp >> 8), (uint8_t)(cp & 0xFF),
+                       bootCaps(), bootPeriph() };
+    uartSendFrame(Serial2, CMD_BOOT, buf, 7);
+    s_sentPeriph = buf[6];
+}
+
+void bootRearm() {
+    s_sentPeriph = 0;      // settled bitmap always differs → next settle is sent
+}
+
+// data: uint8 caps, periph, uint16 ms since power-on
+void bootTick() {
+    uint8_t periph = bootPeriph();
+    if (!(periph & BOOT_PERIPH_SETTLED)) return;
+    if (s_ready && periph == s_sentPeriph) return;
+
+    uint32_t now = millis();
+    uint16_t ms  = now > 0xFFFF ? 0xFFFF : (uint16_t)now;
+    uint8_t buf[4] = { bootCaps(), periph, (uint8_t)(ms >> 8), (uint8_t)(ms & 0xFF) };
+    uartSendFrame(Serial2, CMD_READY, buf, 4);
+    if (!s_ready) LOGI(LM_MAIN, "ready after %u ms, periph 0x%02X", ms, periph);
+    else          LOGI(LM_MAIN, "periph 0x%02X", periph);
+    s_ready      = true;
+    s_sentPeriph = periph;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// ── Boot / readiness handshake ──────────────────────────────────────
+// setup() brings the UART up first and sends CMD_BOOT straight away, so
+// the ESP32 can talk to us within a few ms of power-on.  NFC and ToF
+// come up afterwards in nfcPoll()/tofPoll(); bootTick() sends
+// CMD_READY once every peripheral has settled and again whenever the
+// peripheral bitmap changes.
+
+uint8_t bootCaps();        // BOOT_CAP_*    (compile-time features)
+uint8_t bootPeriph();      // BOOT_PERIPH_* (live status)
+
+void bootSendFrame();      // CMD_BOOT – call once, at the end of setup()
+void bootTick();           // call every loop
+void bootRearm();          // send CMD_READY again once settled (after a re-probe)
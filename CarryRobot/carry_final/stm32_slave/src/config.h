@@ -47,6 +47,8 @@
 #define TOF_RESUME_MM       300       // resume distance (≥ 30 cm)
 
 // ── Motor parameters ────────────────────────────────────────────────
+//  Speeds/times below, PID gains, ToF thresholds and NFC timing are the
+//  defaults of the runtime table in params.cpp (tunable over UART).
 #define PWM_FREQ            20000     // 20 kHz
 #define PWM_RES             8         // 8-bit
 #define MOTOR_RUN_SPEED     200       // 0-255
@@ -63,17 +65,90 @@
 #define LF_MAX_CORR          180.0f
 #define LF_BASE_SPEED        MOTOR_RUN_SPEED
 
+// ── Line-lost local search (arc toward last side, then oscillate) ──
+#define LINE_SEARCH_VY       60        // forward creep on the first arc
+#define LINE_SEARCH_VR       140       // rotation speed while sweeping
+#define LINE_SEARCH_SWEEP_MS 300       // first sweep; later sweeps 2×
+#define LINE_SEARCH_MAX_MS   900       // give up → CMD_LINE_LOST
+#define LINE_SEARCH_VX       120       // translating sweeps on holonomic legs
+
+// ── Arc turns (ROUTE_ACT_ARC_*) ────────────────────────────────────
+// vr = vy · ARC_LXY_CM / radius; duration scales from the calibrated
+// in-place turn (P_TURN_90_MS at P_TURN_SPEED).
+#define ARC_DEFAULT_RADIUS_CM 25
+#define ARC_DEFAULT_SPEED    140       // forward PWM through the corner
+#define ARC_LXY_CM           18        // half wheelbase + half track
+#define ARC_RAMP_MS          120       // vr ramp-in from the straight
+#define ARC_ACQUIRE_PCT      60        // ignore the line before 60 % of the arc
+#define ARC_TIMEOUT_PCT      160       // no line by then → line search
+#define ARC_VX_GAIN          4         // 1/s on the dead-reckoned overshoot past the junction
+
+// ── Holonomic route legs (ROUTE_ACT_STRAFE_* / ROUTE_ACT_REVERSE) ──
+// The ToF only looks forward.  It still stops these legs (anything in
+// front of the chassis halts the robot), but nothing watches their
+// travel direction, so their speed is capped at LEG_BLIND_MAX_SPEED.
+#define LEG_STRAFE_SPEED     150       // rollers slip more sideways – keep it slower
+#define LEG_REVERSE_SPEED    150       // sensor bar trails on reverse legs
+#define LEG_BLIND_MAX_SPEED  100       // cap for legs the ToF cannot see ahead of
+
+// ── Direct velocity (CMD_DIRECT_VEL) ───────────────────────────────
+#define VEL_INTERP_MIN_MS    10        // interpolation window clamp
+#define VEL_INTERP_MAX_MS    100       //   (tracks ESP32 command period)
+#define VEL_STALE_MS         250       // no setpoint → decelerate to 0
+#define VEL_STOP_SLEW        2         // units/ms while stopping (255→0 ≈ 130 ms)
+
 // ── NFC ─────────────────────────────────────────────────────────────
 #define NFC_READ_MS          100
 #define NFC_REPEAT_GUARD_MS  700
+#define NFC_POWERUP_MS       100       // PN532 start-up after boot / relay on
+#define NFC_PROBE_TIMEOUT_MS 10        // ACK wait per probe (unpowered chip never ACKs)
+#define NFC_PROBE_RETRY_MS   250       // probe period during bring-up …
+#define NFC_BOOT_TRIES       8         //   … for this many tries (then "settled")
+#define NFC_RETRY_MS         2000      // slow retry afterwards (relay may come on later)
 
 // ── UART Protocol ───────────────────────────────────────────────────
 #define UART_STX             0x7E
 #define UART_MAX_FRAME       128
+#define UART_RX_QUEUE        4         // decoded frames buffered by uartPump()
+
+// ── Emergency stop ──────────────────────────────────────────────────
+#define USE_ESTOP_LINE       0         // 1 = dedicated ESP32 GPIO19 → PB10 (EXTI)
+#define PIN_ESTOP            PB10      // active LOW, falling edge latches
+
+// ── Cycle-counter profiler (CMD_PROF_DUMP) ──────────────────────────
+#define USE_PROFILER         0         // 1 = DWT probes compiled in; 0 = zero cost
+
+// ── Flight recorder (RAM ring, frozen on failures) ──────────────────
+#define REC_SAMPLES          256       // × 12 B = 3 KB RAM
+#define REC_PERIOD_MS        10        // periodic sample rate (events always logged)
+#define REC_POST_SAMPLES     48        // keep recording this long after a trigger
+#define REC_FROZEN_RESEND_MS 1000      // repeat CMD_REC_FROZEN while the ESP32 is not pulling
+
+// ── Tokenized logging (tlog.h, CMD_LOG) ────────────────────────────
+#define TLOG_SOURCE          1         // 0 = ESP32, 1 = STM32 (record header bit 7)
+#define TLOG_TEXT            0         // 1 = plain Serial.printf, no host decoder needed
+#define TLOG_MAX_LEVEL       4         // compile-time cap: higher levels cost nothing
+#define TLOG_DEFAULT_LEVEL   3         // runtime level per module at boot (LOG_INF)
+#define TLOG_RING_SIZE       512       // bytes, records dropped (and counted) when full
+#define TLOG_FRAME_MAX       96        // CMD_LOG payload bytes per frame
+#define TLOG_TX_HEADROOM     80        // TX bytes kept free for control frames (REG_DATA ≤ 71)
+
+// ── Telemetry stream (CMD_TELEMETRY) ────────────────────────────────
+#define TELEM_MIN_HZ         10
+#define TELEM_MAX_HZ         100
 
 // ── Timing ──────────────────────────────────────────────────────────
 #define MAIN_LOOP_DELAY_MS   2
 #define TOF_READ_MS          50
+#define TOF_IO_TIMEOUT_MS    100       // VL53L0X library I/O timeout
+#define TOF_PROBE_RETRY_MS   250       // ID probe period during bring-up …
+#define TOF_BOOT_TRIES       4         //   … for this many tries (then "settled")
+#define TOF_RETRY_MS         5000      // slow retry afterwards
 
 // ── Route ───────────────────────────────────────────────────────────
 #define MAX_ROUTE_LEN        30
+#define MISSION_FLASH_ADDR   0x0800FC00  // last 1 KB page of 64 KB flash
+#define MISSION_FLASH_SIZE   1024
+#define PARAM_FLASH_ADDR     0x0800F800  // page before the mission log
+#define PARAM_FLASH_SIZE     1024        //   (reserved: platformio.ini maximum_size)
+#define ROUTE_LOOKAHEAD      3         // max missed tags tolerated before mismatch
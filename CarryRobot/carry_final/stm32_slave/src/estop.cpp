@@ -0,0 +1,80 @@
+#include "estop.h"
+#include "config.h"
+#include "globals.h"
+#include "motor_control.h"
+#include "uart_protocol.h"
+#include "regmap.h"
+#include "recorder.h"
+#include "tlog.h"
+
+extern HardwareSerial Serial2;   // UART to ESP32
+
+#define ESTOP_SRC_UART  1
+#define ESTOP_SRC_LINE  2
+
+static volatile bool     s_lineAckPending = false;
+static volatile uint32_t s_lineCutUs      = 0;
+
+static void sendAck(uint32_t tag, uint32_t cutUs, uint8_t source) {
+    uint16_t us = (uint16_t)min(cutUs, (uint32_t)0xFFFF);
+    uint8_t buf[7] = {
+        (uint8_t)(tag >> 24), (uint8_t)(tag >> 16),
+        (uint8_t)(tag >> 8),  (uint8_t)(tag & 0xFF),
+        (uint8_t)(us >> 8),   (uint8_t)(us & 0xFF),
+        source
+    };
+    uartSendFrame(Serial2, CMD_ESTOP_ACK, buf, 7);
+}
+
+// ── UART priority handler: runs when the frame is decoded ───────────
+static void onEstopFrame(uint8_t cmd, const uint8_t *data, uint8_t len) {
+    uint32_t t0 = micros();
+    g_estop = true;
+    motorCut();
+    uint32_t cutUs = micros() - t0;
+    regCount(REG_CNT_ESTOP);
+    recEvent(REC_EV_ESTOP, ESTOP_SRC_UART);
+
+    uint32_t tag = 0;
+    if (len >= 4)
+        tag = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+              ((uint32_t)data[2] << 8)  |  data[3];
+    sendAck(tag, cutUs, ESTOP_SRC_UART);
+}
+
+#if USE_ESTOP_LINE
+static void estopIsr() {
+    uint32_t t0 = micros();
+    g_estop = true;
+    motorCut();
+    s_lineCutUs      = micros() - t0;
+    s_lineAckPending = true;
+}
+#endif
+
+void estopInit() {
+    uartSetPriorityHandler(CMD_ESTOP, onEstopFrame);
+#if USE_ESTOP_LINE
+    pinMode(PIN_ESTOP, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(PIN_ESTOP), estopIsr, FALLING);
+#endif
+}
+
+bool estopActive() { return g_estop; }
+
+void estopClear() {
+#if USE_ESTOP_LINE
+    if (digitalRead(PIN_ESTOP) == LOW) return;   // line still asserted
+#endif
+    g_estop = false;
+    LOGI(LM_ESTOP, "cleared");
+}
+
+void estopLoop() {
+    if (!s_lineAckPending) return;
+    s_lineAckPending = false;
+    regCount(REG_CNT_ESTOP);
+    recEvent(REC_EV_ESTOP, ESTOP_SRC_LINE);
+    sendAck(0, s_lineCutUs, ESTOP_SRC_LINE);
+    LOGW(LM_ESTOP, "line triggered");
+}
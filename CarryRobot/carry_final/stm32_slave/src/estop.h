@@ -0,0 +1,14 @@
+#pragma once
+#include <Arduino.h>
+
+// ── Emergency stop ──────────────────────────────────────────────────
+// CMD_ESTOP is a UART priority command (handled as soon as it is decoded,
+// also inside blocking turns); with USE_ESTOP_LINE an EXTI on PIN_ESTOP
+// cuts the motors straight from the interrupt.  Latched until
+// CMD_ESTOP_CLEAR.  Each stop is acknowledged with CMD_ESTOP_ACK carrying
+// the ESP32 tag and the measured cut time for latency instrumentation.
+
+void estopInit();
+bool estopActive();
+void estopClear();
+void estopLoop();      // sends pending ACK for line-triggered stops
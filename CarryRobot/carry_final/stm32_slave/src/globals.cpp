@@ -17,5 +17,7 @@ volatile bool    g_missionRunning = false;
 
 volatile bool    g_obstacleDetected = false;
 
+volatile bool    g_estop = false;
+
 volatile uint16_t g_lastNfcId = 0;
 volatile bool     g_newNfc    = false;
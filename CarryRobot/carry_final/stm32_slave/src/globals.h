@@ -13,7 +13,9 @@ enum RobotMode : uint8_t {
 // ── Route point ─────────────────────────────────────────────────────
 struct RoutePoint {
     uint16_t checkpointId;
-    uint8_t  action;        // 'F','L','R','B','S'
+    uint8_t  action;        // ROUTE_ACT_* (uart_protocol.h)
+    uint8_t  arcRadius;     // cm, 0 = ARC_DEFAULT_RADIUS_CM  (CMD_ROUTE_ARCS)
+    uint8_t  arcSpeed;      // PWM, 0 = ARC_DEFAULT_SPEED
 };
 
 // ── Shared globals ──────────────────────────────────────────────────
@@ -38,6 +40,9 @@ extern volatile bool    g_missionRunning;
 // obstacle
 extern volatile bool    g_obstacleDetected;
 
+// emergency stop latch (motorSet forces 0 while set)
+extern volatile bool    g_estop;
+
 // latest NFC
 extern volatile uint16_t g_lastNfcId;
 extern volatile bool     g_newNfc;
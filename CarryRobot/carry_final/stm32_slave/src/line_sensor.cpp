@@ -1,12 +1,16 @@
 #include "line_sensor.h"
 
 static uint16_t s_consecLost = 0;
+static int8_t   s_lastSide   = 0;
+static uint8_t  s_lastBits   = 0;
+static float    s_lastErr    = 0.0f;
 
 void lineInit() {
     pinMode(LINE_S1, INPUT_PULLUP);
     pinMode(LINE_S2, INPUT_PULLUP);
     pinMode(LINE_S3, INPUT_PULLUP);
     s_consecLost = 0;
+    s_lastSide   = 0;
 }
 
 // active LOW: LOW = line detected
@@ -20,10 +24,12 @@ float lineReadError() {
     bool l = lineLeft();
     bool c = lineCenter();
     bool r = lineRight();
+    s_lastBits = (l ? 0x01 : 0) | (c ? 0x02 : 0) | (r ? 0x04 : 0);
 
     // track consecutive no-line reads
     if (!l && !c && !r) {
         s_consecLost++;
+        s_lastErr = 0.0f;
         return 0.0f;
     }
 
@@ -35,8 +41,19 @@ float lineReadError() {
     if (c) { sum +=  0.0f; count += 1.0f; }
     if (r) { sum +=  1.0f; count += 1.0f; }
 
-    return sum / count;                     // -1.0 … +1.0
+    float err = sum / count;                // -1.0 … +1.0
+
+    // remember where the line was last seen (centre-only clears it)
+    if (err < 0.0f)      s_lastSide = -1;
+    else if (err > 0.0f) s_lastSide =  1;
+    else if (!l && !r)   s_lastSide =  0;
+
+    s_lastErr = err;
+    return err;
 }
 
 uint16_t lineConsecLost() { return s_consecLost; }
 void     lineHealthReset() { s_consecLost = 0; }
+int8_t   lineLastSide()    { return s_lastSide; }
+uint8_t  lineLastBits()    { return s_lastBits; }
+float    lineLastError()   { return s_lastErr; }
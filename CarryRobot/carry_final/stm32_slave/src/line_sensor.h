@@ -18,3 +18,10 @@ bool lineDetected();
 // ── health check (PN532-like) ───────────────────────────────────────
 uint16_t lineConsecLost();     // consecutive reads with no line
 void     lineHealthReset();    // reset counter (call on mode init)
+
+// side that last saw the line before it was lost: -1 left, +1 right, 0 centre
+int8_t   lineLastSide();
+
+// last lineReadError() sample: bit0 L, bit1 C, bit2 R  /  error value
+uint8_t  lineLastBits();
+float    lineLastError();
@@ -12,6 +12,16 @@
 #include "pn532_reader.h"
 #include "tof_sensor.h"
 #include "auto_runner.h"
+#include "vel_control.h"
+#include "estop.h"
+#include "mission_store.h"
+#include "telemetry.h"
+#include "regmap.h"
+#include "params.h"
+#include "profiler.h"
+#include "recorder.h"
+#include "tlog.h"
+#include "boot.h"
 
 // USART2 for ESP32 communication
 HardwareSerial Serial2(USART2);
@@ -28,14 +38,10 @@ static void handleESP32() {
                 g_mode = (RobotMode)buf[0];
                 motorStop();
                 autoRunnerInit();
+                velCmdReset();
+                // the PN532 rail is the ESP32's business: CMD_PERIPH_RESET
 
-                // NFC relay may have been power-cycled; force re-init for
-                // modes that need it (AUTO = navigation, RECOVERY = return)
-                if (g_mode == MODE_AUTO || g_mode == MODE_RECOVERY) {
-                    nfcReset();   // marks not-ready → re-init on next read
-                }
-
-                Serial.printf("[UART] mode=%u\n", g_mode);
+                LOGI(LM_UART, "mode=%u", g_mode);
 
                 // ACK
                 uint8_t ack = cmd;
@@ -54,7 +60,31 @@ static void handleESP32() {
                 }
                 g_routeIdx = 0;
                 g_missionStart = true;
-                Serial.printf("[UART] route: %u points\n", g_routeLen);
+                LOGI(LM_UART, "route: %u points", g_routeLen);
+            }
+            break;
+
+        case CMD_ROUTE_ARCS:
+            // precedes CMD_SEND_ROUTE, which leaves the arc fields alone
+            for (uint8_t i = 0; i < MAX_ROUTE_LEN; i++)
+                g_route[i].arcRadius = g_route[i].arcSpeed = 0;
+            if (len >= 1) {
+                uint8_t n = min((uint8_t)buf[0], (uint8_t)((len - 1) / 3));
+                for (uint8_t i = 0; i < n; i++) {
+                    const uint8_t *a = &buf[1 + i * 3];
+                    if (a[0] >= MAX_ROUTE_LEN) continue;
+                    g_route[a[0]].arcRadius = a[1];
+                    g_route[a[0]].arcSpeed  = a[2];
+                }
+                LOGD(LM_UART, "route arcs: %u", n);
+            }
+            break;
+
+        case CMD_PERIPH_RESET:
+            // relay rail switched on: probe again, CMD_READY reports the result
+            if (len >= 1 && (buf[0] & BOOT_PERIPH_NFC)) {
+                nfcReset();
+                bootRearm();
             }
             break;
 
@@ -64,59 +94,110 @@ static void handleESP32() {
                 g_cmdVy = (int16_t)(((uint16_t)buf[2] << 8) | buf[3]);
                 g_cmdVr = (int16_t)(((uint16_t)buf[4] << 8) | buf[5]);
                 g_newVelCmd = true;
+                velCmdSet(g_cmdVx, g_cmdVy, g_cmdVr);
             }
             break;
 
         case CMD_REQUEST_STATUS:
-            // send battery (placeholder: 100%)
-            {
-                uint8_t pct = 100;
-                uartSendFrame(Serial2, CMD_BATTERY, &pct, 1);
-            }
+            // whole status block as one CMD_REG_DATA frame
+            regSendStatus();
+            break;
+
+        case CMD_REG_READ:
+            regHandleRead(buf, len);
+            break;
+
+        case CMD_REG_WRITE:
+            regHandleWrite(buf, len);
+            break;
+
+        case CMD_PROF_DUMP:
+            profDump(buf, len);
+            break;
+
+        case CMD_REC_DUMP:
+            recHandleDump(buf, len);
             break;
 
         case CMD_CANCEL_MISSION:
             g_missionCancel = true;
             motorStop();
-            Serial.println("[UART] cancel mission");
+            LOGI(LM_UART, "cancel mission");
             break;
 
         case CMD_CONFIRM_ARRIVAL:
             // ESP32 confirms checkpoint – no additional action needed
             break;
 
+        case CMD_RESUME_MISSION:
+            // ESP32 saw our boot frame and wants the persisted route back
+            if (g_mode == MODE_AUTO && autoRunnerResume()) {
+                uint8_t ack = cmd;
+                uartSendFrame(Serial2, CMD_ACK, &ack, 1);
+            }
+            break;
+
+        case CMD_TELEM_SUBSCRIBE:
+            if (len >= 1) telemetrySetRate(buf[0]);
+            break;
+
+        case CMD_ESTOP_CLEAR:
+            // (CMD_ESTOP itself is a priority frame – see estop.cpp)
+            estopClear();
+            velCmdReset();
+            {
+                uint8_t ack = cmd;
+                uartSendFrame(Serial2, CMD_ACK, &ack, 1);
+            }
+            break;
+
         default:
-            Serial.printf("[UART] unknown cmd 0x%02X\n", cmd);
+            LOGW(LM_UART, "unknown cmd 0x%02X", cmd);
         }
     }
 }
 
+// deferred parameter save: no mission leg running, every wheel at rest
+static bool robotStopped() {
+    int16_t w[4];
+    motorGetLast(w);
+    return !autoRunnerBusy() && !w[0] && !w[1] && !w[2] && !w[3];
+}
+
 // ── Follow mode: apply velocity commands from ESP32 ─────────────────
+// Setpoints are interpolated at loop rate; stale setpoints ramp to 0.
 static void followDrive() {
-    if (g_newVelCmd) {
-        g_newVelCmd = false;
-        mecanumDrive(g_cmdVx, g_cmdVy, g_cmdVr);
-    }
+    g_newVelCmd = false;
+    velCmdStep();
 }
 
 // ====================================================================
 //  SETUP
 // ====================================================================
 void setup() {
+    // UART to ESP32 first – nothing below may block
+    Serial2.begin(ESP_BAUD);
     Serial.begin(115200);
     Serial.println("\n=== CarryFinal STM32 Slave ===");
 
-    // UART to ESP32
-    Serial2.begin(ESP_BAUD);
+    // logging, then tunables – motor/NFC/ToF code reads them
+    tlogInit();
+    paramInit();
+    profInit();
 
-    // hardware
+    // motors safe before anything can move them
     motorInit();
+    estopInit();
     lineInit();
+    autoRunnerInit();
+    missionStoreInit();
+
+    // NFC/ToF only start here; bring-up continues in nfcPoll()/tofPoll()
     nfcInit();
     tofInit();
-    autoRunnerInit();
 
-    Serial.println("[BOOT] ready");
+    bootSendFrame();
+    LOGI(LM_MAIN, "link up after %lu ms", (unsigned long)millis());
 }
 
 // ====================================================================
@@ -124,8 +205,24 @@ void setup() {
 // ====================================================================
 static uint32_t lastTofPrint = 0;
 
-void loop() {
-    handleESP32();
+// one pass of work; PROF_LOOP times this, not the delay after it
+static void loopWork() {
+    PROF_SCOPE(PROF_LOOP);
+    {
+        PROF_SCOPE(PROF_HANDLE_ESP32);
+        handleESP32();
+    }
+    telemetryTick();
+    recTick();
+    tlogFlush();
+    nfcPoll();
+    tofPoll();
+    bootTick();
+    paramSaveTick(robotStopped());
+
+    // ── e-stop latched: motors held off, only the link keeps running ─
+    estopLoop();
+    if (estopActive()) return;
 
     // ── ToF debug print mỗi 200ms ──────────────────────────────────
     {
@@ -133,9 +230,10 @@ void loop() {
         if (now - lastTofPrint >= 200) {
             lastTofPrint = now;
             int d = tofReadMm();
-            Serial.printf("[TOF] %d mm  %s\n", d,
-                          d <= TOF_STOP_MM ? "** OBSTACLE **" :
-                          d <= TOF_RESUME_MM ? "(close)" : "ok");
+            PROF_SCOPE(PROF_DEBUG_PRINT);
+            LOGD(LM_TOF, "%d mm  %s", d,
+                 d <= param(P_TOF_STOP_MM)   ? "** OBSTACLE **" :
+                 d <= param(P_TOF_RESUME_MM) ? "(close)" : "ok");
         }
     }
 
@@ -148,7 +246,7 @@ void loop() {
             if (nfcId != 0) {
                 uint8_t buf[2] = { (uint8_t)(nfcId >> 8), (uint8_t)(nfcId & 0xFF) };
                 uartSendFrame(Serial2, CMD_CHECKPOINT, buf, 2);
-                Serial.printf("[NFC] idle scan: 0x%04X\n", nfcId);
+                LOGI(LM_NFC, "idle scan: 0x%04X", nfcId);
             }
         }
         break;
@@ -172,6 +270,9 @@ void loop() {
         }
         break;
     }
+}
 
+void loop() {
+    loopWork();
     delay(MAIN_LOOP_DELAY_MS);
 }
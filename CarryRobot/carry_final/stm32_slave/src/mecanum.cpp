@@ -1,6 +1,7 @@
 #include "mecanum.h"
 #include "motor_control.h"
 #include "config.h"
+#include "params.h"
 
 // ── kinematics ──────────────────────────────────────────────────────
 //   FL = Vy + Vx + Vr
@@ -25,22 +26,22 @@ void mecanumDrive(int vx, int vy, int vr) {
 }
 
 void mecanumTurnLeft90() {
-    motorSet(-MOTOR_TURN_SPEED, MOTOR_TURN_SPEED,
-             -MOTOR_TURN_SPEED, MOTOR_TURN_SPEED);
-    delay(MOTOR_TURN_90_MS);
+    int ts = param(P_TURN_SPEED);
+    motorSet(-ts, ts, -ts, ts);
+    motorDelay(param(P_TURN_90_MS));
     motorBrake();
 }
 
 void mecanumTurnRight90() {
-    motorSet(MOTOR_TURN_SPEED, -MOTOR_TURN_SPEED,
-             MOTOR_TURN_SPEED, -MOTOR_TURN_SPEED);
-    delay(MOTOR_TURN_90_MS);
+    int ts = param(P_TURN_SPEED);
+    motorSet(ts, -ts, ts, -ts);
+    motorDelay(param(P_TURN_90_MS));
     motorBrake();
 }
 
 void mecanumTurn180() {
-    motorSet(MOTOR_TURN_SPEED, -MOTOR_TURN_SPEED,
-             MOTOR_TURN_SPEED, -MOTOR_TURN_SPEED);
-    delay(MOTOR_TURN_180_MS);
+    int ts = param(P_TURN_SPEED);
+    motorSet(ts, -ts, ts, -ts);
+    motorDelay(param(P_TURN_180_MS));
     motorBrake();
 }
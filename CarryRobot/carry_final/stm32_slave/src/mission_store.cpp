@@ -0,0 +1,179 @@
+#include "mission_store.h"
+#include "config.h"
+#include "globals.h"
+#include "uart_protocol.h"
+#include "tlog.h"
+
+// ── record layout (half-words, erased flash = 0xFFFF) ───────────────
+//   route:    [TAG_ROUTE][seq][len][id,action]×len[crc]
+//   progress: [TAG_PROG ][seq][idx | active<<8 | leg<<9][crc]
+#define TAG_ROUTE   0xA55A
+#define TAG_PROG    0xA5B5
+#define PROG_ACTIVE 0x0100
+#define PROG_LEG(v) (((v) >> 9) & 3)
+
+static const uint32_t PAGE_END = MISSION_FLASH_ADDR + MISSION_FLASH_SIZE;
+
+static uint32_t s_writeAddr = MISSION_FLASH_ADDR;   // first free half-word
+static uint32_t s_routeAddr = 0;                    // latest route record
+static uint16_t s_seq       = 0;
+static uint8_t  s_routeLen  = 0;
+static uint8_t  s_routeIdx  = 0;
+static uint8_t  s_leg       = 0;
+static bool     s_active    = false;
+
+static inline uint16_t rd(uint32_t addr) { return *(volatile uint16_t *)addr; }
+
+static uint16_t crcOf(uint32_t addr, uint16_t halfWords) {
+    return crc8((const uint8_t *)addr, halfWords * 2);
+}
+
+// ── scan ────────────────────────────────────────────────────────────
+void missionStoreInit() {
+    uint32_t a = MISSION_FLASH_ADDR;
+    s_active = false;
+    s_routeAddr = 0;
+
+    while (a + 8 <= PAGE_END) {
+        uint16_t tag = rd(a);
+        if (tag == 0xFFFF) break;
+
+        if (tag == TAG_ROUTE) {
+            uint16_t len = rd(a + 4);
+            uint16_t n   = 3 + len * 2;              // half-words before crc
+            if (len > MAX_ROUTE_LEN || a + (n + 1) * 2 > PAGE_END) break;
+            if (rd(a + n * 2) != crcOf(a, n)) break;
+            s_routeAddr = a;
+            s_seq       = rd(a + 2);
+            s_routeLen  = len;
+            s_routeIdx  = 0;
+            s_leg       = 0;
+            s_active    = false;
+            a += (n + 1) * 2;
+        } else if (tag == TAG_PROG) {
+            if (rd(a + 6) != crcOf(a, 3)) break;
+            uint16_t v = rd(a + 4);
+            if (s_routeAddr && rd(a + 2) == s_seq) {
+                s_routeIdx = v & 0xFF;
+                s_leg      = PROG_LEG(v);
+                s_active   = (v & PROG_ACTIVE) != 0;
+            }
+            a += 8;
+        } else {
+            break;                                   // corrupt → erase on next write
+        }
+    }
+    s_writeAddr = a;
+
+    LOGI(LM_STORE, "seq=%u len=%u idx=%u leg=%u %s", s_seq, s_routeLen,
+         s_routeIdx, s_leg, s_active ? "ACTIVE" : "idle");
+}
+
+// ── flash helpers ───────────────────────────────────────────────────
+static void erasePage() {
+    FLASH_EraseInitTypeDef e = {};
+    e.TypeErase   = FLASH_TYPEERASE_PAGES;
+    e.PageAddress = MISSION_FLASH_ADDR;
+    e.NbPages     = MISSION_FLASH_SIZE / FLASH_PAGE_SIZE;
+    uint32_t err  = 0;
+    HAL_FLASHEx_Erase(&e, &err);
+    s_writeAddr = MISSION_FLASH_ADDR;
+}
+
+static bool program(const uint16_t *hw, uint16_t n) {
+    uint32_t a = s_writeAddr;
+    for (uint16_t i = 0; i < n; i++, a += 2) {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, a, hw[i]) != HAL_OK)
+            return false;
+    }
+    s_writeAddr = a;
+    return true;
+}
+
+static void writeRoute() {
+    uint16_t hw[4 + MAX_ROUTE_LEN * 2];
+    uint16_t n = 0;
+    hw[n++] = TAG_ROUTE;
+    hw[n++] = s_seq;
+    hw[n++] = g_routeLen;
+    for (uint8_t i = 0; i < g_routeLen; i++) {
+        hw[n++] = g_route[i].checkpointId;
+        hw[n++] = g_route[i].action;
+    }
+    hw[n] = crc8((const uint8_t *)hw, n * 2);
+
+    if (s_writeAddr + (n + 1) * 2 > PAGE_END || rd(s_writeAddr) != 0xFFFF)
+        erasePage();
+    s_routeAddr = s_writeAddr;
+    program(hw, n + 1);
+}
+
+static void writeProgress(uint8_t idx, uint8_t leg, bool active) {
+    uint16_t hw[4] = { TAG_PROG, s_seq,
+                       (uint16_t)(idx | (active ? PROG_ACTIVE : 0) | (leg & 3) << 9), 0 };
+    hw[3] = crc8((const uint8_t *)hw, 6);
+
+    if (s_writeAddr + 8 > PAGE_END || rd(s_writeAddr) != 0xFFFF) {
+        // page full: compact to route + this progress record
+        if (!active) { erasePage(); return; }
+        erasePage();
+        writeRoute();
+    }
+    program(hw, 4);
+}
+
+// ── public API ──────────────────────────────────────────────────────
+void missionStoreSaveRoute() {
+    HAL_FLASH_Unlock();
+    s_seq++;
+    if (s_seq == 0xFFFF) s_seq = 0;
+    writeRoute();
+    writeProgress(0, 0, true);               // every route starts on LEG_FWD
+    HAL_FLASH_Lock();
+    s_routeLen = g_routeLen;
+    s_routeIdx = 0;
+    s_leg      = 0;
+    s_active   = true;
+}
+
+void missionStoreSaveProgress(uint8_t routeIdx, uint8_t leg) {
+    if (!s_active) return;
+    HAL_FLASH_Unlock();
+    writeProgress(routeIdx, leg, true);
+    HAL_FLASH_Lock();
+    s_routeIdx = routeIdx;
+    s_leg      = leg & 3;
+}
+
+void missionStoreClear() {
+    if (!s_active) return;
+    HAL_FLASH_Unlock();
+    writeProgress(s_routeIdx, s_leg, false);
+    HAL_FLASH_Lock();
+    s_active = false;
+}
+
+bool    missionStoreResumable() { return s_active && s_routeAddr != 0; }
+uint8_t missionStoreRouteLen()  { return s_routeLen; }
+uint8_t missionStoreRouteIdx()  { return s_routeIdx; }
+uint8_t missionStoreLeg()       { return s_leg; }
+
+uint16_t missionStoreLastCheckpoint() {
+    if (!missionStoreResumable() || s_routeIdx == 0 || s_routeIdx > s_routeLen)
+        return 0;
+    return rd(s_routeAddr + 6 + (s_routeIdx - 1) * 4);
+}
+
+bool missionStoreLoad() {
+    if (!missionStoreResumable()) return false;
+    uint32_t a = s_routeAddr + 6;
+    g_routeLen = s_routeLen;
+    for (uint8_t i = 0; i < g_routeLen; i++, a += 4) {
+        g_route[i].checkpointId = rd(a);
+        g_route[i].action       = (uint8_t)rd(a + 2);
+        g_route[i].arcRadius    = 0;        // arcs are not persisted
+        g_route[i].arcSpeed     = 0;
+    }
+    g_routeIdx = s_routeIdx;
+    return true;
+}
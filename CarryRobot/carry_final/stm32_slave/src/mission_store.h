@@ -0,0 +1,20 @@
+#pragma once
+#include <Arduino.h>
+
+// ── Mission persistence (survives STM32 reset / brown-out) ──────────
+// Append-only log in the last flash page: a route record when a mission
+// starts and a small progress record at every confirmed checkpoint.
+// The page is only erased when full (then the live route is rewritten),
+// so one erase covers many missions.
+
+void    missionStoreInit();              // scan page, locate latest state
+void    missionStoreSaveRoute();         // g_route / g_routeLen, new mission
+void    missionStoreSaveProgress(uint8_t routeIdx, uint8_t leg);
+void    missionStoreClear();             // mission finished / aborted
+
+bool     missionStoreResumable();        // active mission found at boot
+uint8_t  missionStoreRouteLen();
+uint8_t  missionStoreRouteIdx();
+uint8_t  missionStoreLeg();            // leg frame the route continues on
+uint16_t missionStoreLastCheckpoint();   // last confirmed, 0 if none
+bool     missionStoreLoad();             // restore into g_route / g_routeIdx
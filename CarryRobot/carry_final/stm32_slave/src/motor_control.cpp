@@ -1,4 +1,12 @@
 #include "motor_control.h"
+#include "globals.h"
+#include "uart_protocol.h"
+#include "params.h"
+#include "recorder.h"
+
+extern HardwareSerial Serial2;   // UART to ESP32
+
+static int16_t s_last[4] = { 0, 0, 0, 0 };
 
 // ── single motor helper ─────────────────────────────────────────────
 static void driveMotor(int enPin, int in1, int in2, int speed) {
@@ -29,20 +37,43 @@ void motorInit() {
 }
 
 void motorSet(int fl, int fr, int bl, int br) {
+    if (g_estop) { fl = fr = bl = br = 0; }
+    s_last[0] = fl; s_last[1] = fr; s_last[2] = bl; s_last[3] = br;
     driveMotor(L1_ENA, L1_IN1, L1_IN2, fl);   // Front-Left
     driveMotor(L1_ENB, L1_IN3, L1_IN4, fr);   // Front-Right
     driveMotor(L2_ENA, L2_IN1, L2_IN2, bl);   // Back-Left
     driveMotor(L2_ENB, L2_IN3, L2_IN4, br);   // Back-Right
 }
 
+void motorGetLast(int16_t out[4]) {
+    for (uint8_t i = 0; i < 4; i++) out[i] = s_last[i];
+}
+
 void motorStop() {
     motorSet(0, 0, 0, 0);
 }
 
 void motorBrake() {
     // brief reverse pulse
-    motorSet(-MOTOR_BRAKE_PWM, -MOTOR_BRAKE_PWM,
-             -MOTOR_BRAKE_PWM, -MOTOR_BRAKE_PWM);
-    delay(MOTOR_BRAKE_MS);
+    int pwm = param(P_BRAKE_PWM);
+    motorSet(-pwm, -pwm, -pwm, -pwm);
+    motorDelay(param(P_BRAKE_MS));
     motorStop();
 }
+
+void motorCut() {
+    digitalWrite(L1_IN1, LOW); digitalWrite(L1_IN2, LOW);
+    digitalWrite(L1_IN3, LOW); digitalWrite(L1_IN4, LOW);
+    digitalWrite(L2_IN1, LOW); digitalWrite(L2_IN2, LOW);
+    digitalWrite(L2_IN3, LOW); digitalWrite(L2_IN4, LOW);
+}
+
+void motorDelay(uint32_t ms) {
+    uint32_t start = millis();
+    while (millis() - start < ms) {
+        uartPump(Serial2);
+        recTick();                       // keep recording through turns/brakes
+        if (g_estop) { motorStop(); return; }
+        delay(1);
+    }
+}
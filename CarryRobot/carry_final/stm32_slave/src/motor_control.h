@@ -7,8 +7,18 @@ void motorInit();
 // set individual motor PWM (-255 … +255)
 void motorSet(int fl, int fr, int bl, int br);
 
+// last applied wheel commands (FL, FR, BL, BR) for telemetry
+void motorGetLast(int16_t out[4]);
+
 // stop all motors immediately
 void motorStop();
 
 // brake: brief reverse pulse then stop
 void motorBrake();
+
+// e-stop cut: all direction pins LOW (coast) – ISR-safe
+void motorCut();
+
+// delay that keeps decoding UART (so CMD_ESTOP lands mid-manoeuvre);
+// returns early if the e-stop latches
+void motorDelay(uint32_t ms);
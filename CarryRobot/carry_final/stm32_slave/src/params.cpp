@@ -0,0 +1,180 @@
+#include "params.h"
+#include "config.h"
+#include "tlog.h"
+
+// ── table: defaults (same order as ParamId), bounds from REG_P_BOUNDS ─
+#define GAIN(x)  ((uint16_t)((x) * 1000.0f + 0.5f))
+
+static const uint16_t DEFS[PARAM_COUNT] = {
+    MOTOR_RUN_SPEED,          // P_RUN_SPEED
+    MOTOR_TURN_SPEED,         // P_TURN_SPEED
+    MOTOR_TURN_90_MS,         // P_TURN_90_MS
+    MOTOR_TURN_180_MS,        // P_TURN_180_MS
+    MOTOR_BRAKE_PWM,          // P_BRAKE_PWM
+    MOTOR_BRAKE_MS,           // P_BRAKE_MS
+    GAIN(LF_KP),              // P_LF_KP
+    GAIN(LF_KI),              // P_LF_KI
+    GAIN(LF_KD),              // P_LF_KD
+    (uint16_t)LF_MAX_CORR,    // P_LF_MAX_CORR
+    TOF_STOP_MM,              // P_TOF_STOP_MM
+    TOF_RESUME_MM,            // P_TOF_RESUME_MM
+    NFC_READ_MS,              // P_NFC_READ_MS
+    NFC_REPEAT_GUARD_MS,      // P_NFC_GUARD_MS
+};
+
+static const uint16_t BOUNDS[PARAM_COUNT][2] = REG_P_BOUNDS;
+static const uint8_t  ORDERED[][2]            = REG_P_ORDERED;
+#define ORDERED_N  (sizeof(ORDERED) / sizeof(ORDERED[0]))
+
+static uint16_t s_val[PARAM_COUNT];
+static bool     s_dirty   = false;
+static bool     s_saveReq = false;     // REG_CTRL_SAVE_PARAMS, waiting for idle
+static uint16_t s_stage[PARAM_COUNT];  // batch write being checked
+static uint32_t s_staged  = 0;         // bit id → s_stage[id] written
+
+// ── flash record (half-words, erased = 0xFFFF) ──────────────────────
+//   [TAG_PARAMS][PARAM_TABLE_VER][count][value × count][crc]
+// Appended on every save; the page is erased only when full.  A record
+// from an older firmware with fewer entries still loads its prefix.
+#define TAG_PARAMS       0xA5D2
+#define PARAM_TABLE_VER  1
+
+static const uint32_t PAGE_END = PARAM_FLASH_ADDR + PARAM_FLASH_SIZE;
+static uint32_t s_writeAddr = PARAM_FLASH_ADDR;
+
+static inline uint16_t rd(uint32_t addr) { return *(volatile uint16_t *)addr; }
+
+static bool inBounds(uint8_t id, uint16_t v) {
+    return v >= BOUNDS[id][0] && v <= BOUNDS[id][1];
+}
+
+// ids of both members of every REG_P_ORDERED pair that v breaks
+static uint32_t crossBad(const uint16_t *v) {
+    uint32_t bad = 0;
+    for (uint8_t k = 0; k < ORDERED_N; k++) {
+        uint8_t a = ORDERED[k][0] - REG_PARAM_BASE;
+        uint8_t b = ORDERED[k][1] - REG_PARAM_BASE;
+        if (v[a] >= v[b]) bad |= (1UL << a) | (1UL << b);
+    }
+    return bad;
+}
+
+void paramDefaults() {
+    for (uint8_t i = 0; i < PARAM_COUNT; i++) s_val[i] = DEFS[i];
+    s_dirty = true;
+}
+
+void paramInit() {
+    paramDefaults();
+    s_dirty = false;
+
+    uint32_t a = PARAM_FLASH_ADDR, rec = 0;
+    while (a + 8 <= PAGE_END && rd(a) == TAG_PARAMS) {
+        uint16_t n = rd(a + 4);
+        if (n > 64 || a + (3 + n + 1) * 2 > PAGE_END) break;
+        if (rd(a + (3 + n) * 2) != crc8((const uint8_t *)a, (3 + n) * 2)) break;
+        if (rd(a + 2) == PARAM_TABLE_VER) rec = a;
+        a += (3 + n + 1) * 2;
+    }
+    s_writeAddr = a;
+
+    if (rec) {
+        uint16_t n = min(rd(rec + 4), (uint16_t)PARAM_COUNT);
+        for (uint8_t i = 0; i < n; i++) {
+            uint16_t v = rd(rec + 6 + i * 2);
+            if (inBounds(i, v)) s_val[i] = v;
+        }
+        if (n < PARAM_COUNT) s_dirty = true;
+    }
+    uint32_t bad = crossBad(s_val);
+    if (bad) {
+        for (uint8_t i = 0; i < PARAM_COUNT; i++)
+            if (bad & (1UL << i)) s_val[i] = DEFS[i];
+        s_dirty = true;
+        LOGW(LM_PARAM, "stored pairs out of order (0x%04lX) → defaults", (unsigned long)bad);
+    }
+    LOGI(LM_PARAM, "%s (%u params)", rec ? "loaded" : "defaults", PARAM_COUNT);
+}
+
+uint16_t param(ParamId id)     { return s_val[id]; }
+float    paramGain(ParamId id) { return s_val[id] * 0.001f; }
+bool     paramDirty()          { return s_dirty; }
+
+void paramStageBegin() {
+    memcpy(s_stage, s_val, sizeof(s_stage));
+    s_staged = 0;
+}
+
+uint8_t paramStage(uint8_t id, uint16_t value) {
+    if (id >= PARAM_COUNT) return REG_ERR_ADDR;
+    if (!inBounds(id, value)) return REG_ERR_RANGE;
+    s_stage[id] = value;
+    s_staged   |= 1UL << id;
+    return REG_OK;
+}
+
+// Pairs are checked on the whole batch, so one frame may move both ends
+// past each other (raise stop and resume together).  A staged member of
+// a broken pair is refused; the live pair then stays as it was.
+uint32_t paramStageCommit() {
+    uint32_t bad = crossBad(s_stage) & s_staged;
+    for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+        if (!(s_staged & (1UL << i)) || (bad & (1UL << i))) continue;
+        if (s_val[i] != s_stage[i]) {
+            s_val[i] = s_stage[i];
+            s_dirty  = true;
+        }
+    }
+    s_staged = 0;
+    return bad;
+}
+
+uint8_t paramSet(uint8_t id, uint16_t value) {
+    paramStageBegin();
+    uint8_t status = paramStage(id, value);
+    if (status != REG_OK) return status;
+    return paramStageCommit() ? REG_ERR_RANGE : REG_OK;
+}
+
+void paramSaveRequest() { s_saveReq = true; }
+
+// the page erase stalls the core for tens of ms – never while moving
+void paramSaveTick(bool idle) {
+    if (!s_saveReq || !idle) return;
+    s_saveReq = false;
+    paramSave();
+}
+
+bool paramSave() {
+    if (!s_dirty) return true;
+
+    uint16_t hw[4 + PARAM_COUNT];
+    uint16_t n = 0;
+    hw[n++] = TAG_PARAMS;
+    hw[n++] = PARAM_TABLE_VER;
+    hw[n++] = PARAM_COUNT;
+    for (uint8_t i = 0; i < PARAM_COUNT; i++) hw[n++] = s_val[i];
+    hw[n] = crc8((const uint8_t *)hw, n * 2);
+    n++;
+
+    HAL_FLASH_Unlock();
+    if (s_writeAddr + n * 2 > PAGE_END || rd(s_writeAddr) != 0xFFFF) {
+        FLASH_EraseInitTypeDef e = {};
+        e.TypeErase   = FLASH_TYPEERASE_PAGES;
+        e.PageAddress = PARAM_FLASH_ADDR;
+        e.NbPages     = PARAM_FLASH_SIZE / FLASH_PAGE_SIZE;
+        uint32_t err  = 0;
+        HAL_FLASHEx_Erase(&e, &err);
+        s_writeAddr = PARAM_FLASH_ADDR;
+    }
+    bool ok = true;
+    for (uint16_t i = 0; i < n && ok; i++, s_writeAddr += 2)
+        ok = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, s_writeAddr, hw[i]) == HAL_OK;
+    HAL_FLASH_Lock();
+
+    if (ok) s_dirty = false;
+    else    s_writeAddr = PAGE_END;          // half-written record → erase next time
+    if (ok) LOGI(LM_PARAM, "save ok");
+    else    LOGE(LM_PARAM, "save FAILED");
+    return ok;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <Arduino.h>
+#include "uart_protocol.h"
+
+// ── Runtime parameter table ─────────────────────────────────────────
+// Tunables that used to be compile-time constants.  Defaults and bounds
+// come from config.h; the dashboard writes them through the register
+// map (REG_P_*) and REG_CTRL_SAVE_PARAMS appends the table to its own
+// flash page, so tuning survives a reset without reflashing.
+
+enum ParamId : uint8_t {
+    P_RUN_SPEED      = REG_P_RUN_SPEED     - REG_PARAM_BASE,
+    P_TURN_SPEED     = REG_P_TURN_SPEED    - REG_PARAM_BASE,
+    P_TURN_90_MS     = REG_P_TURN_90_MS    - REG_PARAM_BASE,
+    P_TURN_180_MS    = REG_P_TURN_180_MS   - REG_PARAM_BASE,
+    P_BRAKE_PWM      = REG_P_BRAKE_PWM     - REG_PARAM_BASE,
+    P_BRAKE_MS       = REG_P_BRAKE_MS      - REG_PARAM_BASE,
+    P_LF_KP          = REG_P_LF_KP         - REG_PARAM_BASE,
+    P_LF_KI          = REG_P_LF_KI         - REG_PARAM_BASE,
+    P_LF_KD          = REG_P_LF_KD         - REG_PARAM_BASE,
+    P_LF_MAX_CORR    = REG_P_LF_MAX_CORR   - REG_PARAM_BASE,
+    P_TOF_STOP_MM    = REG_P_TOF_STOP_MM   - REG_PARAM_BASE,
+    P_TOF_RESUME_MM  = REG_P_TOF_RESUME_MM - REG_PARAM_BASE,
+    P_NFC_READ_MS    = REG_P_NFC_READ_MS   - REG_PARAM_BASE,
+    P_NFC_GUARD_MS   = REG_P_NFC_GUARD_MS  - REG_PARAM_BASE,
+    PARAM_COUNT
+};
+
+void     paramInit();                    // defaults, then latest flash record
+uint16_t param(ParamId id);
+float    paramGain(ParamId id);          // value / 1000 (PID gains)
+uint8_t  paramSet(uint8_t id, uint16_t value);   // REG_OK / REG_ERR_*
+
+// batch write: stage, then commit checks REG_P_ORDERED on the result
+void     paramStageBegin();
+uint8_t  paramStage(uint8_t id, uint16_t value); // bounds only
+uint32_t paramStageCommit();             // → ids refused (bit per ParamId)
+void     paramDefaults();
+bool     paramSave();                    // no-op when unchanged; blocks on erase
+void     paramSaveRequest();             // save on the next idle paramSaveTick()
+void     paramSaveTick(bool idle);       // main loop: idle = nothing moving
+bool     paramDirty();
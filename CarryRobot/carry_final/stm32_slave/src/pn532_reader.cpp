@@ -2,74 +2,106 @@
 #include <SPI.h>
 #include <Adafruit_PN532.h>
 #include "uart_protocol.h"
+#include "globals.h"
+#include "regmap.h"
+#include "params.h"
+#include "profiler.h"
+#include "recorder.h"
+#include "tlog.h"
 
 extern HardwareSerial Serial2;   // UART to ESP32
 
 // Software SPI — much more reliable on STM32duino than hardware SPI
 static Adafruit_PN532 nfc(PN532_SCK, PN532_MISO, PN532_MOSI, PN532_SS);
-static bool s_ready = false;
 static uint32_t lastReadMs = 0;
 static uint8_t  lastUid[7] = {};
 static uint8_t  lastUidLen  = 0;
 static uint32_t lastUidTime = 0;
-static uint32_t lastRetryMs = 0;
 static uint8_t  consecutiveFails = 0;
+static uint32_t s_reads = 0;          // PN532 polls actually issued
+static uint32_t s_hits  = 0;          // new tags returned to the caller
 static const uint8_t  MAX_CONSEC_FAILS = 20;  // ~20 × 100ms = 2s of failures → re-init
 
-// Send short debug text to ESP32 (shows as [STM32] ... on monitor)
-static void sendDebug(const char *msg) {
-    uint8_t n = strlen(msg);
-    if (n > 100) n = 100;
-    uartSendFrame(Serial2, CMD_DEBUG_MSG, (const uint8_t*)msg, n);
+// ── bring-up state machine (nfcPoll) ────────────────────────────────
+// The PN532 sits behind a relay and may be unpowered at boot, where a
+// full getFirmwareVersion() stalls.  One short ACK probe per step
+// keeps every loop iteration bounded; the full handshake only runs
+// once the chip has answered.
+enum NfcState : uint8_t { NFC_WAIT, NFC_PROBE, NFC_READY };
+static NfcState s_state   = NFC_WAIT;
+static uint32_t s_stateMs = 0;
+static uint16_t s_waitMs  = 0;
+static uint8_t  s_tries   = 0;        // failed probes since last reset
+
+static void enterWait(uint16_t ms) {
+    s_state   = NFC_WAIT;
+    s_stateMs = millis();
+    s_waitMs  = ms;
 }
 
 void nfcInit() {
     nfc.begin();
+    s_tries = 0;
+    enterWait(NFC_POWERUP_MS);
+}
+
+static bool probe() {
+    uint8_t cmd = PN532_COMMAND_GETFIRMWAREVERSION;
+    if (!nfc.sendCommandCheckAck(&cmd, 1, NFC_PROBE_TIMEOUT_MS)) return false;
     uint32_t ver = nfc.getFirmwareVersion();
-    if (!ver) {
-        Serial.println("[NFC] PN532 not found (relay may be off)");
-        sendDebug("NFC: PN532 not found");
-        s_ready = false;
-        return;
-    }
+    if (!ver) return false;
     nfc.SAMConfig();
-    s_ready = true;
-    char tmp[40];
-    snprintf(tmp, sizeof(tmp), "NFC: PN532 FW %u.%u OK", (ver >> 16) & 0xFF, (ver >> 8) & 0xFF);
-    Serial.println(tmp);
-    sendDebug(tmp);
+    LOGI(LM_NFC, "PN532 FW %u.%u OK", (ver >> 16) & 0xFF, (ver >> 8) & 0xFF);
+    return true;
 }
 
-bool nfcAvailable() { return s_ready; }
+void nfcPoll() {
+    switch (s_state) {
+    case NFC_WAIT:
+        if (millis() - s_stateMs >= s_waitMs) s_state = NFC_PROBE;
+        break;
+    case NFC_PROBE:
+        if (probe()) {
+            s_state          = NFC_READY;
+            consecutiveFails = 0;
+            break;
+        }
+        if (s_tries < 0xFF) s_tries++;
+        if (s_tries == NFC_BOOT_TRIES)
+            LOGW(LM_NFC, "PN532 not found (relay may be off)");
+        else
+            LOGD(LM_NFC, "probe %u failed", s_tries);
+        enterWait(s_tries < NFC_BOOT_TRIES ? NFC_PROBE_RETRY_MS : NFC_RETRY_MS);
+        break;
+    case NFC_READY:
+        break;
+    }
+}
 
-// Force s_ready=false so next nfcReadCheckpoint() triggers re-init.
-// Call this after relay R3 is power-cycled (e.g. mode switch).
-void nfcReset() {
-    s_ready = false;
-    Serial.println("[NFC] reset – will re-init");
-    sendDebug("NFC: reset, will re-init");
+bool nfcAvailable() { return s_state == NFC_READY; }
+
+void nfcStats(uint32_t &reads, uint32_t &hits) {
+    reads = s_reads;
+    hits  = s_hits;
 }
+bool nfcSettled()   { return s_state == NFC_READY || s_tries >= NFC_BOOT_TRIES; }
 
-// Retry init periodically if PN532 not detected (e.g. relay was off at boot)
-static void nfcRetryInit() {
-    uint32_t now = millis();
-    if (now - lastRetryMs < 2000) return;   // retry every 2s
-    lastRetryMs = now;
-    Serial.println("[NFC] retrying init...");
-    sendDebug("NFC: retrying init...");
-    nfcInit();
+// Restart bring-up after the ESP32 powers the NFC rail (CMD_PERIPH_RESET).
+void nfcReset() {
+    s_tries = 0;
+    enterWait(NFC_POWERUP_MS);
+    LOGI(LM_NFC, "reset – will re-init");
 }
 
 uint16_t nfcReadCheckpoint() {
-    if (!s_ready) {
-        nfcRetryInit();
-        return 0;
-    }
+    if (s_state != NFC_READY) return 0;
 
     uint32_t now = millis();
 
-    if (now - lastReadMs < NFC_READ_MS) return 0;
+    if (now - lastReadMs < param(P_NFC_READ_MS)) return 0;
     lastReadMs = now;
+    PROF_SCOPE(PROF_NFC_READ);
+    s_reads++;
 
     uint8_t uid[7];
     uint8_t uidLen = 0;
@@ -77,9 +109,9 @@ uint16_t nfcReadCheckpoint() {
         // Track consecutive read failures — if PN532 lost power, re-init
         if (++consecutiveFails >= MAX_CONSEC_FAILS) {
             consecutiveFails = 0;
-            Serial.println("[NFC] too many fails – re-init");
-            sendDebug("NFC: too many fails, re-init");
-            s_ready = false;
+            LOGW(LM_NFC, "too many fails – re-init");
+            s_tries = 0;
+            enterWait(NFC_PROBE_RETRY_MS);
         }
         return 0;
     }
@@ -88,7 +120,7 @@ uint16_t nfcReadCheckpoint() {
     // repeat guard: same UID within guard time → ignore
     if (uidLen == lastUidLen &&
         memcmp(uid, lastUid, uidLen) == 0 &&
-        (now - lastUidTime) < NFC_REPEAT_GUARD_MS)
+        (now - lastUidTime) < param(P_NFC_GUARD_MS))
         return 0;
 
     memcpy(lastUid, uid, uidLen);
@@ -102,5 +134,11 @@ uint16_t nfcReadCheckpoint() {
     } else if (uidLen == 1) {
         id = uid[0];
     }
+    g_lastNfcId = id;
+    if (id != 0) {
+        s_hits++;
+        regCount(REG_CNT_NFC_READ);
+        recEvent(REC_EV_NFC, id);
+    }
     return id;
 }
@@ -2,7 +2,10 @@
 #include <Arduino.h>
 #include "config.h"
 
-void     nfcInit();
-void     nfcReset();           // force re-init on next read (call after relay power cycle)
+void     nfcInit();            // non-blocking: bring-up runs in nfcPoll()
+void     nfcPoll();            // call every loop – one bounded bus step at most
+void     nfcReset();           // restart bring-up (CMD_PERIPH_RESET after relay power-on)
 bool     nfcAvailable();      // true if reader is present
+bool     nfcSettled();        // ready, or boot-time probes exhausted
 uint16_t nfcReadCheckpoint(); // returns checkpoint ID or 0 if none
+void     nfcStats(uint32_t &reads, uint32_t &hits);   // since boot: polls issued, tags returned
@@ -0,0 +1,79 @@
+#include "profiler.h"
+#include "tlog.h"
+
+extern HardwareSerial Serial2;   // UART to ESP32
+
+#define PROF_FLAG_RESET  0x01
+
+#if USE_PROFILER
+
+struct ProbeStats {
+    uint32_t count;
+    uint32_t minCyc;
+    uint32_t maxCyc;
+    uint64_t sumCyc;
+    uint16_t hist[PROF_BUCKETS];
+};
+
+static ProbeStats s_stats[PROF_COUNT];
+static uint8_t    s_mhz = 72;
+
+static void resetStats() {
+    memset(s_stats, 0, sizeof(s_stats));
+    for (uint8_t i = 0; i < PROF_COUNT; i++) s_stats[i].minCyc = UINT32_MAX;
+}
+
+void profInit() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+    s_mhz = (uint8_t)(SystemCoreClock / 1000000UL);
+    resetStats();
+    LOGI(LM_PROF, "DWT on, %u MHz", s_mhz);
+}
+
+void profRecord(uint8_t probe, uint32_t cycles) {
+    if (probe >= PROF_COUNT) return;
+    ProbeStats &s = s_stats[probe];
+    s.count++;
+    s.sumCyc += cycles;
+    if (cycles < s.minCyc) s.minCyc = cycles;
+    if (cycles > s.maxCyc) s.maxCyc = cycles;
+
+    uint32_t us = cycles / s_mhz;
+    uint8_t  b  = 0;
+    while (us >= 4 && b < PROF_BUCKETS - 1) { us >>= 2; b++; }
+    if (s.hist[b] != UINT16_MAX) s.hist[b]++;
+}
+
+void profDump(const uint8_t *data, uint8_t len) {
+    // snapshot first so the dump itself does not skew the numbers
+    ProbeStats snap[PROF_COUNT];
+    memcpy(snap, s_stats, sizeof(snap));
+    if (len >= 1 && (data[0] & PROF_FLAG_RESET)) resetStats();
+
+    for (uint8_t i = 0; i < PROF_COUNT; i++) {
+        const ProbeStats &s = snap[i];
+        ProfRecord r;
+        r.probe   = i;
+        r.probes  = PROF_COUNT;
+        r.cpuMhz  = s_mhz;
+        r.count   = s.count;
+        r.minCyc  = s.count ? s.minCyc : 0;
+        r.maxCyc  = s.maxCyc;
+        r.meanCyc = s.count ? (uint32_t)(s.sumCyc / s.count) : 0;
+        memcpy(r.hist, s.hist, sizeof(r.hist));
+        uartSendFrame(Serial2, CMD_PROF_DATA, (const uint8_t *)&r, sizeof(r));
+    }
+}
+
+#else   // ── profiler compiled out ──────────────────────────────────────
+
+void profInit() {}
+
+void profDump(const uint8_t *, uint8_t) {
+    ProfRecord r = {};               // probes = 0 → "disabled"
+    uartSendFrame(Serial2, CMD_PROF_DATA, (const uint8_t *)&r, sizeof(r));
+}
+
+#endif
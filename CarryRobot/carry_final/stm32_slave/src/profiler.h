@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "uart_protocol.h"
+
+// ── DWT cycle-counter profiler ──────────────────────────────────────
+// PROF_SCOPE(PROF_x) times the rest of the enclosing block with the
+// Cortex-M3 cycle counter (1 cycle = 1/72 µs).  With USE_PROFILER 0 the
+// macro expands to nothing and no probe state is linked in.
+//
+//     { PROF_SCOPE(PROF_TOF_READ); d = sensor.readRange…(); }
+
+void profInit();                      // enable DWT->CYCCNT
+void profDump(const uint8_t *data, uint8_t len);   // CMD_PROF_DUMP
+
+#if USE_PROFILER
+
+void profRecord(uint8_t probe, uint32_t cycles);
+
+struct ProfScope {
+    uint8_t  probe;
+    uint32_t t0;
+    explicit ProfScope(uint8_t p) : probe(p), t0(DWT->CYCCNT) {}
+    ~ProfScope() { profRecord(probe, DWT->CYCCNT - t0); }
+};
+
+#define PROF_CAT2(a, b) a##b
+#define PROF_CAT(a, b)  PROF_CAT2(a, b)
+#define PROF_SCOPE(p)   ProfScope PROF_CAT(_prof_, __LINE__)(p)
+
+#else
+
+#define PROF_SCOPE(p)   do {} while (0)
+
+#endif
@@ -0,0 +1,123 @@
+#include "recorder.h"
+#include "config.h"
+#include "line_sensor.h"
+#include "motor_control.h"
+#include "tof_sensor.h"
+#include "auto_runner.h"
+#include "tlog.h"
+
+extern HardwareSerial Serial2;   // UART to ESP32
+
+#define REC_CHUNKS  ((REC_SAMPLES + REC_CHUNK_SAMPLES - 1) / REC_CHUNK_SAMPLES)
+
+static RecSample s_buf[REC_SAMPLES];
+static uint16_t  s_head     = 0;       // next write
+static uint16_t  s_count    = 0;
+static uint32_t  s_lastMs   = 0;
+static uint16_t  s_postLeft = 0;       // > 0: triggered, still recording
+static bool      s_frozen   = false;
+static uint8_t   s_reason   = 0;
+static uint16_t  s_trigArg  = 0;
+static uint32_t  s_heardMs  = 0;       // last CMD_REC_FROZEN sent / CMD_REC_DUMP seen
+
+static void sendFrozen() {
+    s_heardMs = millis();
+    uint8_t buf[5] = { s_reason,
+                       (uint8_t)(s_count >> 8),   (uint8_t)(s_count & 0xFF),
+                       (uint8_t)(s_trigArg >> 8), (uint8_t)(s_trigArg & 0xFF) };
+    uartSendFrame(Serial2, CMD_REC_FROZEN, buf, 5);
+}
+
+static void push(uint8_t ev, uint16_t arg) {
+    RecSample &r = s_buf[s_head];
+    int16_t w[4];
+    motorGetLast(w);
+    int tof = tofLastMm() / 4;
+
+    r.tMs       = (uint16_t)millis();
+    r.lineState = (lineLastBits() & 0x07) | (autoRunnerState() << 3);
+    r.lineErr   = (int8_t)(lineLastError() * 100.0f);
+    for (uint8_t i = 0; i < 4; i++) r.wheel[i] = (int8_t)(w[i] / 2);
+    r.tof4mm    = (uint8_t)constrain(tof, 0, 255);
+    r.event     = ev;
+    r.arg       = arg;
+
+    s_head = (s_head + 1) % REC_SAMPLES;
+    if (s_count < REC_SAMPLES) s_count++;
+
+    if (s_postLeft && --s_postLeft == 0) {
+        s_frozen = true;
+        sendFrozen();
+        LOGW(LM_REC, "frozen, reason %u, %u samples", s_reason, s_count);
+    }
+}
+
+void recTick() {
+    uint32_t now = millis();
+    if (s_frozen) {
+        // the frame may have been lost, or the ESP32 gave up mid-download:
+        // keep announcing the capture until it is pulled and re-armed
+        if (now - s_heardMs >= REC_FROZEN_RESEND_MS) sendFrozen();
+        return;
+    }
+    if (now - s_lastMs < REC_PERIOD_MS) return;
+    s_lastMs = now;
+    push(0, 0);
+}
+
+void recEvent(uint8_t ev, uint16_t arg) {
+    if (!s_frozen) push(ev, arg);
+}
+
+void recTrigger(uint8_t reason, uint16_t arg) {
+    if (s_frozen || s_postLeft) return;      // keep the first failure
+    s_reason   = reason;
+    s_trigArg  = arg;
+    s_postLeft = REC_POST_SAMPLES;
+    push(REC_EV_TRIGGER | reason, arg);
+}
+
+bool recFrozen() { return s_frozen; }
+
+static void rearm() {
+    s_head = s_count = 0;
+    s_postLeft = 0;
+    s_frozen   = false;
+    s_reason   = 0;
+}
+
+static void sendChunk(uint8_t chunk) {
+    uint8_t  buf[4 + REC_CHUNK_SAMPLES * sizeof(RecSample)];
+    uint16_t first = chunk * REC_CHUNK_SAMPLES;
+    uint8_t  n     = 0;
+    uint16_t oldest = (s_head + REC_SAMPLES - s_count) % REC_SAMPLES;
+
+    for (; n < REC_CHUNK_SAMPLES && first + n < s_count; n++) {
+        const RecSample &r = s_buf[(oldest + first + n) % REC_SAMPLES];
+        memcpy(&buf[4 + n * sizeof(RecSample)], &r, sizeof(RecSample));
+    }
+    buf[0] = chunk;
+    buf[1] = (uint8_t)((s_count + REC_CHUNK_SAMPLES - 1) / REC_CHUNK_SAMPLES);
+    buf[2] = s_reason;
+    buf[3] = n;
+    uartSendFrame(Serial2, CMD_REC_CHUNK, buf, 4 + n * sizeof(RecSample));
+}
+
+void recHandleDump(const uint8_t *data, uint8_t len) {
+    if (len < 1) return;
+    s_heardMs = millis();
+    switch (data[0]) {
+    case REC_DUMP_REARM:
+        rearm();
+        LOGI(LM_REC, "re-armed");
+        break;
+    case REC_DUMP_FREEZE:
+        if (s_frozen) { sendFrozen(); break; }     // already holding a capture
+        recTrigger(REC_TRIG_MANUAL);
+        s_postLeft = 1;                            // freeze on the next sample
+        push(0, 0);
+        break;
+    default:
+        if (data[0] < REC_CHUNKS) sendChunk(data[0]);
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <Arduino.h>
+#include "uart_protocol.h"
+
+// ── RAM flight recorder ─────────────────────────────────────────────
+// Ring of compact RecSample records: one every REC_PERIOD_MS plus one
+// per event.  A trigger (mismatch, line lost, obstacle, cancel) keeps
+// recording REC_POST_SAMPLES more, then freezes the ring and tells the
+// ESP32 (CMD_REC_FROZEN, repeated while it is not pulling), which pulls
+// it chunk by chunk and re-arms.
+
+void recTick();                                   // periodic sample (cheap)
+void recEvent(uint8_t ev, uint16_t arg = 0);
+void recTrigger(uint8_t reason, uint16_t arg = 0);
+bool recFrozen();
+void recHandleDump(const uint8_t *data, uint8_t len);   // CMD_REC_DUMP
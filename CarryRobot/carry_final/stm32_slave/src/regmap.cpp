@@ -0,0 +1,171 @@
+#include "regmap.h"
+#include "config.h"
+#include "globals.h"
+#include "uart_protocol.h"
+#include "line_sensor.h"
+#include "motor_control.h"
+#include "tof_sensor.h"
+#include "auto_runner.h"
+#include "mission_store.h"
+#include "telemetry.h"
+#include "params.h"
+#include "tlog.h"
+#include "boot.h"
+
+extern HardwareSerial Serial2;   // UART to ESP32
+
+#define CNT_COUNT  (REG_CNT_LAST - REG_CNT_BASE + 1)
+
+static volatile uint16_t s_cnt[CNT_COUNT];
+
+void regCount(uint8_t reg, uint16_t n) {
+    if (reg < REG_CNT_BASE || reg > REG_CNT_LAST) return;
+    s_cnt[reg - REG_CNT_BASE] += n;
+}
+
+void regClearCounters() {
+    for (uint8_t i = 0; i < CNT_COUNT; i++) s_cnt[i] = 0;
+    telemetryClearPeak();
+}
+
+// ── status registers ────────────────────────────────────────────────
+static uint16_t readStatus(uint8_t addr) {
+    switch (addr) {
+    case REG_VERSION:      return REGMAP_VERSION;
+    case REG_UPTIME_S_LO:  return (uint16_t)(millis() / 1000);
+    case REG_UPTIME_S_HI:  return (uint16_t)((millis() / 1000) >> 16);
+    case REG_MODE:         return g_mode;
+    case REG_RUN_STATE:    return autoRunnerState();
+    case REG_ROUTE_IDX:    return g_routeIdx;
+    case REG_ROUTE_LEN:    return g_routeLen;
+    case REG_LAST_NFC:     return g_lastNfcId;
+    case REG_TOF_MM:       return (uint16_t)constrain(tofLastMm(), 0, 0xFFFF);
+    case REG_LINE_BITS:    return lineLastBits();
+    case REG_LINE_ERR:     return (uint16_t)(int16_t)(lineLastError() * 100.0f);
+    case REG_FLAGS:        return telemetryFlags();
+    case REG_LOOP_US:      return telemetryLoopUs();
+    case REG_LOOP_PEAK_US: return telemetryLoopPeakUs();
+    case REG_RESUMABLE:    return missionStoreResumable();
+    case REG_CAPS:         return bootCaps();
+    case REG_PERIPH:       return bootPeriph();
+    }
+    if (addr >= REG_WHEEL_FL && addr <= REG_WHEEL_BR) {
+        int16_t w[4];
+        motorGetLast(w);
+        return (uint16_t)w[addr - REG_WHEEL_FL];
+    }
+    return 0xFFFF;
+}
+
+uint16_t regRead(uint8_t addr) {
+    if (addr <= REG_STATUS_LAST)
+        return readStatus(addr);
+    if (addr >= REG_CNT_BASE && addr <= REG_CNT_LAST)
+        return s_cnt[addr - REG_CNT_BASE];
+    if (addr >= REG_PARAM_BASE && addr <= REG_PARAM_LAST)
+        return param((ParamId)(addr - REG_PARAM_BASE));
+    if (addr >= REG_LOG_LEVEL_BASE && addr < REG_LOG_LEVEL_BASE + LM_COUNT)
+        return g_tlogLevel[addr - REG_LOG_LEVEL_BASE];
+    switch (addr) {
+    case REG_CTRL:        return 0;
+    case REG_TELEM_HZ:    return telemetryRate();
+    case REG_PARAM_COUNT: return PARAM_COUNT;
+    case REG_PARAM_DIRTY: return paramDirty();
+    }
+    return 0xFFFF;
+}
+
+#define REG_CTRL_ALL  (REG_CTRL_CLEAR_CNT | REG_CTRL_SAVE_PARAMS | REG_CTRL_PARAM_DEFAULTS)
+
+uint8_t regWrite(uint8_t addr, uint16_t value) {
+    if (addr >= REG_PARAM_BASE && addr <= REG_PARAM_LAST)
+        return paramSet(addr - REG_PARAM_BASE, value);
+    if (addr >= REG_LOG_LEVEL_BASE && addr < REG_LOG_LEVEL_BASE + LM_COUNT) {
+        if (value > LOG_DBG) return REG_ERR_RANGE;
+        tlogSetLevel(addr - REG_LOG_LEVEL_BASE, (uint8_t)value);
+        return REG_OK;
+    }
+
+    switch (addr) {
+    case REG_CTRL:
+        if (value & ~REG_CTRL_ALL) return REG_ERR_RANGE;
+        if (value & REG_CTRL_CLEAR_CNT)      regClearCounters();
+        if (value & REG_CTRL_PARAM_DEFAULTS) paramDefaults();
+        if (value & REG_CTRL_SAVE_PARAMS)    paramSaveRequest();
+        return REG_OK;
+    case REG_TELEM_HZ:
+        if (value != 0 && (value < TELEM_MIN_HZ || value > TELEM_MAX_HZ))
+            return REG_ERR_RANGE;
+        telemetrySetRate((uint8_t)value);
+        return REG_OK;
+    }
+    bool mapped = addr <= REG_STATUS_LAST ||
+                  (addr >= REG_CNT_BASE && addr <= REG_CNT_LAST) ||
+                  addr == REG_PARAM_COUNT || addr == REG_PARAM_DIRTY;
+    return mapped ? REG_ERR_READONLY : REG_ERR_ADDR;
+}
+
+// ── frames ──────────────────────────────────────────────────────────
+static void sendData(uint8_t start, uint8_t count) {
+    if (count > REG_BATCH_MAX) count = REG_BATCH_MAX;
+    uint8_t buf[3 + REG_BATCH_MAX * 2];
+    buf[0] = REGMAP_VERSION;
+    buf[1] = start;
+    buf[2] = count;
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t v = regRead((uint8_t)(start + i));
+        buf[3 + i * 2]     = (uint8_t)(v >> 8);
+        buf[3 + i * 2 + 1] = (uint8_t)(v & 0xFF);
+    }
+    uartSendFrame(Serial2, CMD_REG_DATA, buf, 3 + count * 2);
+}
+
+void regHandleRead(const uint8_t *data, uint8_t len) {
+    if (len < 2) return;
+    sendData(data[0], data[1]);
+}
+
+void regHandleWrite(const uint8_t *data, uint8_t len) {
+    if (len < 2) return;
+    uint8_t start  = data[0];
+    uint8_t count  = min(data[1], (uint8_t)((len - 2) / 2));
+    if (count > REG_BATCH_MAX) count = REG_BATCH_MAX;   // the NAK mask is 32 bits
+    uint8_t status = REG_OK;               // first error
+    uint8_t n      = 0;                    // registers applied
+    uint32_t rejected = 0;                 // bit i → start + i
+
+    // each register applied or rejected on its own; parameters are
+    // staged and their ordered pairs checked on the batch as a whole
+    paramStageBegin();
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t  addr = start + i;
+        uint16_t v    = ((uint16_t)data[2 + i * 2] << 8) | data[3 + i * 2];
+        bool     par  = addr >= REG_PARAM_BASE && addr <= REG_PARAM_LAST;
+        uint8_t  s    = par ? paramStage(addr - REG_PARAM_BASE, v) : regWrite(addr, v);
+        if (s == REG_OK) { n++; continue; }
+        rejected |= 1UL << i;
+        if (status == REG_OK) status = s;
+    }
+    uint32_t bad = paramStageCommit();
+    for (uint8_t i = 0; i < count && bad; i++) {
+        uint8_t addr = start + i;
+        if (addr < REG_PARAM_BASE || addr > REG_PARAM_LAST) continue;
+        if (!(bad & (1UL << (addr - REG_PARAM_BASE)))) continue;
+        rejected |= 1UL << i;
+        n--;
+        if (status == REG_OK) status = REG_ERR_RANGE;
+    }
+    if (status == REG_OK && count < data[1]) status = REG_ERR_RANGE;   // truncated / over batch
+
+    uint8_t ack[7] = { start, n, status,
+                       (uint8_t)(rejected >> 24), (uint8_t)(rejected >> 16),
+                       (uint8_t)(rejected >> 8),  (uint8_t)rejected };
+    uartSendFrame(Serial2, CMD_REG_WACK, ack, sizeof(ack));
+    if (status != REG_OK)
+        LOGW(LM_REG, "write 0x%02X+%u: %u rejected, mask 0x%08lX (%u)", start, count,
+             count - n, (unsigned long)rejected, status);
+}
+
+void regSendStatus() {
+    sendData(REG_VERSION, REG_STATUS_LAST + 1);
+}
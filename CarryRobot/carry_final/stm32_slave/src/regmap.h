@@ -0,0 +1,18 @@
+#pragma once
+#include <Arduino.h>
+
+// ── Register map served over UART (CMD_REG_READ / CMD_REG_WRITE) ────
+// Addresses and REGMAP_VERSION live in uart_protocol.h.  Status
+// registers are sampled on read; counters are bumped by the modules
+// that own the event via regCount().
+
+void     regCount(uint8_t reg, uint16_t n = 1);    // REG_CNT_* address
+void     regClearCounters();
+
+uint16_t regRead(uint8_t addr);                     // 0xFFFF if unmapped
+uint8_t  regWrite(uint8_t addr, uint16_t value);    // REG_OK / REG_ERR_*
+
+// frame handlers – reply on the ESP32 link
+void regHandleRead(const uint8_t *data, uint8_t len);
+void regHandleWrite(const uint8_t *data, uint8_t len);
+void regSendStatus();                               // CMD_REQUEST_STATUS
@@ -0,0 +1,91 @@
+#include "telemetry.h"
+#include "config.h"
+#include "globals.h"
+#include "uart_protocol.h"
+#include "line_sensor.h"
+#include "motor_control.h"
+#include "tof_sensor.h"
+#include "pn532_reader.h"
+#include "auto_runner.h"
+#include "vel_control.h"
+#include "tlog.h"
+
+extern HardwareSerial Serial2;   // UART to ESP32
+
+static uint32_t s_periodMs  = 0;       // 0 = off
+static uint32_t s_lastSend  = 0;
+static uint16_t s_seq       = 0;
+static uint32_t s_lastTick  = 0;
+static uint32_t s_loopUs    = 0;
+static uint32_t s_loopMaxUs = 0;       // since previous frame
+static uint32_t s_loopPeakUs = 0;      // since boot / clear
+static uint8_t  s_rateHz    = 0;
+
+void telemetrySetRate(uint8_t hz) {
+    if (hz == 0) { s_periodMs = 0; s_rateHz = 0; return; }
+    hz = constrain(hz, (uint8_t)TELEM_MIN_HZ, (uint8_t)TELEM_MAX_HZ);
+    s_periodMs = 1000 / hz;
+    s_rateHz   = hz;
+    LOGI(LM_TELEM, "%u Hz", hz);
+}
+
+uint8_t telemetryRate() { return s_rateHz; }
+
+uint8_t telemetryFlags() {
+    return (g_estop          ? TELEM_FLAG_ESTOP     : 0) |
+           (g_missionRunning ? TELEM_FLAG_MISSION   : 0) |
+           (velCmdStale()    ? TELEM_FLAG_VEL_STALE : 0) |
+           (nfcAvailable()   ? TELEM_FLAG_NFC_OK    : 0) |
+           (tofAvailable()   ? TELEM_FLAG_TOF_OK    : 0);
+}
+
+uint16_t telemetryLoopUs()     { return (uint16_t)min(s_loopUs,     (uint32_t)0xFFFF); }
+uint16_t telemetryLoopPeakUs() { return (uint16_t)min(s_loopPeakUs, (uint32_t)0xFFFF); }
+void     telemetryClearPeak()  { s_loopPeakUs = 0; }
+
+static int16_t clamp16(float v) {
+    return (int16_t)constrain(v, -32768.0f, 32767.0f);
+}
+
+void telemetryTick() {
+    uint32_t us = micros();
+    if (s_lastTick) {
+        s_loopUs = us - s_lastTick;
+        if (s_loopUs > s_loopMaxUs)  s_loopMaxUs  = s_loopUs;
+        if (s_loopUs > s_loopPeakUs) s_loopPeakUs = s_loopUs;
+    }
+    s_lastTick = us;
+
+    if (s_periodMs == 0) return;
+    uint32_t now = millis();
+    if (now - s_lastSend < s_periodMs) return;
+    s_lastSend = now;
+
+    TelemetryFrame f;
+    f.seq      = s_seq++;
+    f.tMs      = now;
+    f.lineBits = lineLastBits();
+    f.lineErr  = (int8_t)(lineLastError() * 100.0f);
+
+    float p, i, d;
+    autoRunnerPidTerms(p, i, d);
+    f.pidP = clamp16(p * 10.0f);
+    f.pidI = clamp16(i * 10.0f);
+    f.pidD = clamp16(d * 10.0f);
+
+    int16_t wheel[4];
+    motorGetLast(wheel);
+    memcpy(f.wheel, wheel, sizeof(wheel));
+    f.tofMm     = (uint16_t)constrain(tofLastMm(), 0, 0xFFFF);
+    f.mode      = g_mode;
+    f.runState  = autoRunnerState();
+    f.routeIdx  = g_routeIdx;
+    f.routeLen  = g_routeLen;
+    f.lastNfc   = g_lastNfcId;
+    f.loopUs    = telemetryLoopUs();
+    f.loopMaxUs = (uint16_t)min(s_loopMaxUs, (uint32_t)0xFFFF);
+    f.flags     = telemetryFlags();
+    s_loopMaxUs = 0;
+
+    uartSendFrame(Serial2, CMD_TELEMETRY, (const uint8_t *)&f, sizeof(f));
+}
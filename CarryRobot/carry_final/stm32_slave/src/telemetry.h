@@ -0,0 +1,16 @@
+#pragma once
+#include <Arduino.h>
+
+// ── Binary telemetry stream to ESP32 (CMD_TELEMETRY) ────────────────
+// Off until the ESP32 subscribes with CMD_TELEM_SUBSCRIBE.  Sampling
+// only reads cached values – no sensor I/O is triggered.
+
+void telemetrySetRate(uint8_t hz);   // 0 = off, clamped 10–100
+void telemetryTick();                // call once per main loop
+
+// shared with the register map
+uint8_t  telemetryRate();             // Hz, 0 = off
+uint8_t  telemetryFlags();            // TELEM_FLAG_*
+uint16_t telemetryLoopUs();
+uint16_t telemetryLoopPeakUs();       // worst since boot / clear
+void     telemetryClearPeak();
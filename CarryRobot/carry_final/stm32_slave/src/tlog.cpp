@@ -0,0 +1,94 @@
+#include "tlog.h"
+#include "uart_protocol.h"
+
+extern HardwareSerial Serial2;   // UART to ESP32
+
+static const char *const MODULE_NAMES[LM_COUNT] = {
+    "MAIN", "UART", "RUN", "LINE", "NFC", "TOF", "VEL", "ESTOP",
+    "STORE", "PARAM", "REC", "PROF", "REG", "TELEM",
+};
+
+uint8_t g_tlogLevel[LM_COUNT];
+
+// ── byte ring of whole records ──────────────────────────────────────
+static uint8_t  s_ring[TLOG_RING_SIZE];
+static uint16_t s_head    = 0;         // write
+static uint16_t s_tail    = 0;         // read
+static uint16_t s_used    = 0;
+static uint8_t  s_dropped = 0;         // since last frame, saturating
+
+void tlogInit() {
+    tlogSetLevel(LM_COUNT, TLOG_DEFAULT_LEVEL);
+}
+
+void tlogSetLevel(uint8_t module, uint8_t level) {
+    if (module >= LM_COUNT) {
+        for (uint8_t i = 0; i < LM_COUNT; i++) g_tlogLevel[i] = level;
+    } else {
+        g_tlogLevel[module] = level;
+    }
+}
+
+const char *tlogModuleName(uint8_t module) {
+    return module < LM_COUNT ? MODULE_NAMES[module] : "?";
+}
+
+void tlogBegin(TlogRec &r, uint32_t token, uint8_t module, uint8_t level) {
+    uint32_t t = millis();
+    uint8_t  h = (TLOG_SOURCE << 7) | ((module & 0x0F) << 3) | (level & 0x07);
+    r.n = 1;                                   // [0] = length, set on commit
+    r.put(&token, 4);
+    r.put(&h, 1);
+    r.put(&t, 4);
+}
+
+void tlogCommit(TlogRec &r) {
+    r.d[0] = r.n;
+    noInterrupts();
+    if (TLOG_RING_SIZE - s_used < r.n) {
+        if (s_dropped < 0xFF) s_dropped++;
+    } else {
+        for (uint8_t i = 0; i < r.n; i++) {
+            s_ring[s_head] = r.d[i];
+            s_head = (s_head + 1) % TLOG_RING_SIZE;
+        }
+        s_used += r.n;
+    }
+    interrupts();
+}
+
+// ── drain: one CMD_LOG frame per call ───────────────────────────────
+//   payload: [dropped u8][record…]
+// Logs never eat into TLOG_TX_HEADROOM: with less TX space free the
+// frame's records are discarded (and counted) so control frames queued
+// behind them cannot block the main loop.
+void tlogFlush() {
+    if (s_used == 0 && s_dropped == 0) return;
+
+    uint8_t buf[TLOG_FRAME_MAX];
+    uint8_t n = 1, recs = 0;
+    uint16_t tail = s_tail, used = s_used, taken = 0;
+    while (used > 0) {
+        uint8_t len = s_ring[tail];
+        if (n + len > TLOG_FRAME_MAX) break;
+        for (uint8_t i = 0; i < len; i++)
+            buf[n++] = s_ring[(tail + i) % TLOG_RING_SIZE];
+        tail   = (tail + len) % TLOG_RING_SIZE;
+        used  -= len;
+        taken += len;
+        recs++;
+    }
+    bool room = Serial2.availableForWrite() >= n + 4 + TLOG_TX_HEADROOM;
+
+    if (room) {
+        buf[0] = s_dropped;
+        uartSendFrame(Serial2, CMD_LOG, buf, n);
+    }
+
+    noInterrupts();
+    s_tail  = tail;
+    s_used -= taken;
+    if (room) s_dropped -= buf[0];
+    else      s_dropped = (s_dropped + recs > 0xFF) ? 0xFF : s_dropped + recs;
+    interrupts();
+}
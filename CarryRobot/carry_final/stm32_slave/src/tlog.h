@@ -0,0 +1,101 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// ── Tokenized logging ───────────────────────────────────────────────
+//   LOGW(LM_RUN, "mismatch got=%u exp=%u", got, exp);
+// stores a compile-time FNV-1a hash of the format string plus the raw
+// arguments in a RAM ring; tlogFlush() drains it as CMD_LOG frames and
+// drops them when the TX buffer lacks headroom, so logging never blocks
+// the link.  tools/tlog.py
+// rebuilds the token database from the sources and turns a captured
+// stream back into text.
+//
+// Rules: the format is one string literal with no trailing "\n".
+// Conversions: d i u x X c (32-bit), f e g (sent as float), s (copied,
+// up to TLOG_STR_MAX chars).  TLOG_TEXT 1 falls back to Serial.printf.
+//
+// Record: [len][token u32][src<<7 | module<<3 | level][t ms u32][args]
+// – identical layout on both MCUs (TLOG_SOURCE tells them apart).
+
+#define LOG_ERR   1
+#define LOG_WRN   2
+#define LOG_INF   3
+#define LOG_DBG   4
+
+// ── modules (≤ 16 per MCU) – names mirrored in tlog.cpp ─────────────
+enum LogModule : uint8_t {
+    LM_MAIN, LM_UART, LM_RUN, LM_LINE, LM_NFC, LM_TOF, LM_VEL, LM_ESTOP,
+    LM_STORE, LM_PARAM, LM_REC, LM_PROF, LM_REG, LM_TELEM,
+    LM_COUNT
+};
+
+#define TLOG_REC_MAX   64      // bytes per record incl. header
+#define TLOG_STR_MAX   24
+
+extern uint8_t g_tlogLevel[LM_COUNT];
+
+void        tlogInit();
+void        tlogFlush();                  // call from the main loop
+void        tlogSetLevel(uint8_t module, uint8_t level);   // module ≥ LM_COUNT = all
+const char *tlogModuleName(uint8_t module);
+
+// ── compile-time token ──────────────────────────────────────────────
+constexpr uint32_t tlogHash(const char *s, uint32_t h = 2166136261u) {
+    return *s ? tlogHash(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+
+// ── argument packing ────────────────────────────────────────────────
+struct TlogRec {
+    uint8_t d[TLOG_REC_MAX];
+    uint8_t n;
+    void put(const void *p, uint8_t len) {
+        if (n + len > TLOG_REC_MAX) { n = TLOG_REC_MAX; return; }   // truncated
+        memcpy(d + n, p, len);
+        n += len;
+    }
+};
+
+template <typename T>
+inline void tlogPut(TlogRec &r, T v)     { uint32_t u = (uint32_t)v; r.put(&u, 4); }
+inline void tlogPut(TlogRec &r, float v)  { r.put(&v, 4); }
+inline void tlogPut(TlogRec &r, double v) { float f = (float)v; r.put(&f, 4); }
+inline void tlogPut(TlogRec &r, const char *s) {
+    uint8_t len = s ? (uint8_t)strnlen(s, TLOG_STR_MAX) : 0;
+    r.put(&len, 1);
+    r.put(s, len);
+}
+inline void tlogPut(TlogRec &r, char *s) { tlogPut(r, (const char *)s); }
+
+inline void tlogPack(TlogRec &) {}
+template <typename T, typename... Rest>
+inline void tlogPack(TlogRec &r, T v, Rest... rest) {
+    tlogPut(r, v);
+    tlogPack(r, rest...);
+}
+
+void tlogBegin(TlogRec &r, uint32_t token, uint8_t module, uint8_t level);
+void tlogCommit(TlogRec &r);
+
+// ── macros ──────────────────────────────────────────────────────────
+#if TLOG_TEXT
+#define TLOG(mod, lvl, fmt, ...) do {                                       \
+        if ((lvl) <= TLOG_MAX_LEVEL && (lvl) <= g_tlogLevel[mod])           \
+            Serial.printf("[%s] " fmt "\n", tlogModuleName(mod), ##__VA_ARGS__); \
+    } while (0)
+#else
+#define TLOG(mod, lvl, fmt, ...) do {                                       \
+        if ((lvl) <= TLOG_MAX_LEVEL && (lvl) <= g_tlogLevel[mod]) {         \
+            constexpr uint32_t _tok = tlogHash(fmt);                        \
+            TlogRec _r;                                                     \
+            tlogBegin(_r, _tok, mod, lvl);                                  \
+            tlogPack(_r, ##__VA_ARGS__);                                    \
+            tlogCommit(_r);                                                 \
+        }                                                                   \
+    } while (0)
+#endif
+
+#define LOGE(mod, fmt, ...)  TLOG(mod, LOG_ERR, fmt, ##__VA_ARGS__)
+#define LOGW(mod, fmt, ...)  TLOG(mod, LOG_WRN, fmt, ##__VA_ARGS__)
+#define LOGI(mod, fmt, ...)  TLOG(mod, LOG_INF, fmt, ##__VA_ARGS__)
+#define LOGD(mod, fmt, ...)  TLOG(mod, LOG_DBG, fmt, ##__VA_ARGS__)
@@ -1,38 +1,61 @@
 #include "tof_sensor.h"
+#include "tlog.h"
 
 #if USE_TOF
 
 #include <Wire.h>
 #include <VL53L0X.h>
+#include "params.h"
+#include "profiler.h"
 
 static VL53L0X sensor;
 static bool    s_ready    = false;
 static int     s_lastDist = 9999;
 static uint32_t lastRead  = 0;
 
+// ── bring-up state machine (tofPoll) ────────────────────────────────
+// A one-register ID probe NACKs immediately when the sensor is absent,
+// so the calibration-heavy init() only runs once it has answered.
+#define VL53L0X_MODEL_ID  0xEE
+
+static uint32_t s_nextTryMs = 0;
+static uint8_t  s_tries     = 0;
+
 void tofInit() {
     Wire.setSDA(TOF_SDA);
     Wire.setSCL(TOF_SCL);
     Wire.begin();
-    sensor.setTimeout(500);
-    if (!sensor.init()) {
-        Serial.println("[TOF] VL53L0X init FAILED");
-        s_ready = false;
+    sensor.setTimeout(TOF_IO_TIMEOUT_MS);
+    s_nextTryMs = millis();
+}
+
+void tofPoll() {
+    if (s_ready || (int32_t)(millis() - s_nextTryMs) < 0) return;
+
+    bool ok = sensor.readReg(VL53L0X::IDENTIFICATION_MODEL_ID) == VL53L0X_MODEL_ID &&
+              sensor.last_status == 0 &&
+              sensor.init();
+    if (ok) {
+        sensor.setMeasurementTimingBudget(20000);
+        sensor.startContinuous();
+        s_ready = true;
+        LOGI(LM_TOF, "VL53L0X OK");
         return;
     }
-    sensor.setMeasurementTimingBudget(20000);
-    sensor.startContinuous();
-    s_ready = true;
-    Serial.println("[TOF] VL53L0X OK");
+    if (s_tries < 0xFF) s_tries++;
+    if (s_tries == TOF_BOOT_TRIES) LOGE(LM_TOF, "VL53L0X init FAILED");
+    s_nextTryMs = millis() + (s_tries < TOF_BOOT_TRIES ? TOF_PROBE_RETRY_MS : TOF_RETRY_MS);
 }
 
 bool tofAvailable() { return s_ready; }
+bool tofSettled()   { return s_ready || s_tries >= TOF_BOOT_TRIES; }
 
 int tofReadMm() {
     if (!s_ready) return 9999;
     uint32_t now = millis();
     if (now - lastRead < TOF_READ_MS) return s_lastDist;
     lastRead = now;
+    PROF_SCOPE(PROF_TOF_READ);
 
     int d = sensor.readRangeContinuousMillimeters();
     if (sensor.timeoutOccurred()) return s_lastDist;
@@ -40,14 +63,19 @@ int tofReadMm() {
     return d;
 }
 
-bool tofObstacle() { return tofReadMm() <= TOF_STOP_MM; }
-bool tofClear()    { return tofReadMm() >= TOF_RESUME_MM; }
+int tofLastMm() { return s_ready ? s_lastDist : 9999; }
+
+bool tofObstacle() { return tofReadMm() <= param(P_TOF_STOP_MM); }
+bool tofClear()    { return tofReadMm() >= param(P_TOF_RESUME_MM); }
 
 #else
 // ── ToF disabled (USE_TOF = 0) ────────────────────────────────────
-void tofInit()      { Serial.println("[TOF] disabled"); }
+void tofInit()      { LOGI(LM_TOF, "disabled"); }
+void tofPoll()      {}
 bool tofAvailable() { return false; }
+bool tofSettled()   { return true;  }
 int  tofReadMm()    { return 9999; }
+int  tofLastMm()    { return 9999; }
 bool tofObstacle()  { return false; }
 bool tofClear()     { return true;  }
 
@@ -2,8 +2,11 @@
 #include <Arduino.h>
 #include "config.h"
 
-void    tofInit();
+void    tofInit();            // non-blocking: bring-up runs in tofPoll()
+void    tofPoll();            // call every loop – probes until the sensor answers
 bool    tofAvailable();
+bool    tofSettled();         // ready, or boot-time probes exhausted
 int     tofReadMm();          // returns distance in mm, 0 on error
+int     tofLastMm();          // cached value, never touches I2C
 bool    tofObstacle();        // ≤ TOF_STOP_MM
 bool    tofClear();           // ≥ TOF_RESUME_MM
@@ -1,4 +1,5 @@
 #include "uart_protocol.h"
+#include "regmap.h"
 
 uint8_t crc8(const uint8_t *data, uint8_t len) {
     uint8_t crc = 0x00;
@@ -34,34 +35,82 @@ static uint8_t rxIdx   = 0;
 static uint8_t rxLen   = 0;
 static uint8_t rxState = 0;
 
-bool uartReceiveFrame(HardwareSerial &port,
-                      uint8_t &cmd, uint8_t *buf, uint8_t &len)
-{
-    while (port.available()) {
-        uint8_t b = port.read();
+// ── decoded-frame queue (filled by uartPump) ────────────────────────
+struct RxFrame {
+    uint8_t cmd;
+    uint8_t len;
+    uint8_t data[UART_MAX_FRAME];
+};
+static RxFrame rxQueue[UART_RX_QUEUE];
+static uint8_t rxHead  = 0;
+static uint8_t rxCount = 0;
+
+static uint8_t             prioCmd = 0;
+static UartPriorityHandler prioFn  = nullptr;
 
-        switch (rxState) {
-        case 0:
-            if (b == UART_STX) { rxState = 1; rxIdx = 0; }
-            break;
-        case 1:
-            rxLen = b;
-            if (rxLen == 0 || rxLen > UART_MAX_FRAME - 4) { rxState = 0; break; }
-            rxState = 2; rxIdx = 0;
-            break;
-        case 2:
-            rxBuf[rxIdx++] = b;
-            if (rxIdx == rxLen + 1) {
-                rxState = 0;
-                uint8_t expected = crc8(rxBuf, rxLen);
-                if (rxBuf[rxLen] != expected) break;
-                cmd = rxBuf[0];
-                len = rxLen - 1;
-                for (uint8_t i = 0; i < len; i++) buf[i] = rxBuf[1 + i];
-                return true;
-            }
-            break;
+void uartSetPriorityHandler(uint8_t cmd, UartPriorityHandler fn) {
+    prioCmd = cmd;
+    prioFn  = fn;
+}
+
+// feed one byte; returns true when rxBuf holds a complete, valid frame
+static bool rxByte(uint8_t b) {
+    switch (rxState) {
+    case 0:
+        if (b == UART_STX) { rxState = 1; rxIdx = 0; }
+        break;
+    case 1:
+        rxLen = b;
+        if (rxLen == 0 || rxLen > UART_MAX_FRAME - 4) { rxState = 0; break; }
+        rxState = 2; rxIdx = 0;
+        break;
+    case 2:
+        rxBuf[rxIdx++] = b;
+        if (rxIdx == rxLen + 1) {
+            rxState = 0;
+            uint8_t expected = crc8(rxBuf, rxLen);
+            return rxBuf[rxLen] == expected;
         }
+        break;
     }
     return false;
 }
+
+void uartPump(HardwareSerial &port) {
+    while (port.available()) {
+        if (!rxByte(port.read())) continue;
+
+        uint8_t cmd = rxBuf[0];
+        uint8_t len = rxLen - 1;
+        regCount(REG_CNT_UART_RX);
+        if (prioFn && cmd == prioCmd) {
+            prioFn(cmd, &rxBuf[1], len);
+            continue;
+        }
+        if (rxCount >= UART_RX_QUEUE) {           // full → drop newest
+            regCount(REG_CNT_UART_DROP);
+            continue;
+        }
+
+        RxFrame &f = rxQueue[(rxHead + rxCount) % UART_RX_QUEUE];
+        f.cmd = cmd;
+        f.len = len;
+        memcpy(f.data, &rxBuf[1], len);
+        rxCount++;
+    }
+}
+
+bool uartReceiveFrame(HardwareSerial &port,
+                      uint8_t &cmd, uint8_t *buf, uint8_t &len)
+{
+    uartPump(port);
+    if (rxCount == 0) return false;
+
+    RxFrame &f = rxQueue[rxHead];
+    cmd = f.cmd;
+    len = f.len;
+    memcpy(buf, f.data, len);
+    rxHead = (rxHead + 1) % UART_RX_QUEUE;
+    rxCount--;
+    return true;
+}
@@ -6,9 +6,19 @@
 #define CMD_SET_MODE        0x01
 #define CMD_SEND_ROUTE      0x02
 #define CMD_DIRECT_VEL      0x03
-#define CMD_REQUEST_STATUS  0x04
+#define CMD_REQUEST_STATUS  0x04   // → CMD_REG_DATA status block
 #define CMD_CANCEL_MISSION  0x05
 #define CMD_CONFIRM_ARRIVAL 0x06
+#define CMD_ESTOP           0x07   // data: uint32 tag – priority, latches motors off
+#define CMD_ESTOP_CLEAR     0x08   // no data: release e-stop latch
+#define CMD_RESUME_MISSION  0x09   // no data: continue persisted route
+#define CMD_TELEM_SUBSCRIBE 0x0A   // data: uint8 rate Hz (0 = off, 10–100)
+#define CMD_REG_READ        0x0B   // data: uint8 start, count  → CMD_REG_DATA
+#define CMD_REG_WRITE       0x0C   // data: uint8 start, count, uint16 × count → CMD_REG_WACK
+#define CMD_PROF_DUMP       0x0D   // data: uint8 flags (bit0 = reset after dump) → CMD_PROF_DATA
+#define CMD_REC_DUMP        0x0E   // data: uint8 chunk | REC_DUMP_REARM | REC_DUMP_FREEZE
+#define CMD_ROUTE_ARCS      0x0F   // data: uint8 count, [idx, radius cm, speed] × count – before CMD_SEND_ROUTE
+#define CMD_PERIPH_RESET    0x10   // data: uint8 BOOT_PERIPH_* – rail power-cycled, re-probe → CMD_READY
 
 // ── Commands  STM32 → ESP32 ─────────────────────────────────────────
 #define CMD_BATTERY         0x81
@@ -17,8 +27,271 @@
 #define CMD_ACK             0x84
 #define CMD_MISSION_DONE    0x85
 #define CMD_MISMATCH        0x86
-#define CMD_DEBUG_MSG       0x87   // data: ASCII string (up to ~120 chars)
+#define CMD_DEBUG_MSG       0x87   // data: ASCII string – legacy, superseded by CMD_LOG
 #define CMD_LINE_LOST       0x88   // no data: line sensor lost line
+#define CMD_SKIPPED         0x89   // data: uint8 count, uint16 id × count
+#define CMD_VEL_TIMEOUT     0x8A   // data: uint16 setpoint age ms
+#define CMD_ESTOP_ACK       0x8B   // data: uint32 tag, uint16 cut µs, uint8 source
+#define CMD_BOOT            0x8C   // data: uint8 resumable, len, idx, uint16 lastCp, uint8 caps, periph
+#define CMD_TELEMETRY       0x8D   // data: TelemetryFrame (packed, little-endian)
+#define CMD_REG_DATA        0x8E   // data: uint8 version, start, count, uint16 × count
+#define CMD_REG_WACK        0x8F   // data: uint8 start, written, status, uint32 rejected mask
+#define CMD_PROF_DATA       0x90   // data: ProfRecord (packed, little-endian)
+#define CMD_REC_FROZEN      0x91   // data: uint8 reason, uint16 samples, uint16 trigger arg
+#define CMD_REC_CHUNK       0x92   // data: uint8 chunk, chunks, reason, n, RecSample × n
+#define CMD_LOG             0x93   // data: uint8 dropped, tokenized records (tlog.h)
+#define CMD_READY           0x94   // data: uint8 caps, periph, uint16 ms since power-on
+#define CMD_RUN_KPI         0x95   // data: RunKpi (packed, little-endian) when a route run ends
+
+// ── CMD_SEND_ROUTE action byte – keep identical on both MCUs ────────
+//  Taken at the checkpoint, relative to the current travel direction.
+//  Turns rotate the chassis to face the new leg; the holonomic legs
+//  keep the heading and drive the mecanum wheels sideways / backwards,
+//  tracking the line in that frame until a later action changes it.
+#define ROUTE_ACT_FWD        'F'   // keep going
+#define ROUTE_ACT_LEFT       'L'   // rotate 90° left
+#define ROUTE_ACT_RIGHT      'R'   // rotate 90° right
+#define ROUTE_ACT_BACK       'B'   // rotate 180°
+#define ROUTE_ACT_STOP       'S'   // destination: stop, 180°, done
+#define ROUTE_ACT_STRAFE_L   '<'   // next leg to the left, no rotation
+#define ROUTE_ACT_STRAFE_R   '>'   // next leg to the right, no rotation
+#define ROUTE_ACT_REVERSE    'V'   // next leg back the way we came, no rotation
+#define ROUTE_ACT_HOLD       'H'   // destination: stop without the 180°, done
+#define ROUTE_ACT_ARC_L      'l'   // 90° left as a driven arc (CMD_ROUTE_ARCS)
+#define ROUTE_ACT_ARC_R      'r'   // 90° right as a driven arc
+
+// ── CMD_BOOT / CMD_READY bitmaps – keep identical on both MCUs ──────
+// caps: features compiled into the STM32 firmware
+#define BOOT_CAP_NFC         0x01
+#define BOOT_CAP_TOF         0x02
+#define BOOT_CAP_ESTOP_LINE  0x04
+#define BOOT_CAP_PROFILER    0x08
+#define BOOT_CAP_TLOG        0x10   // CMD_LOG instead of text
+#define BOOT_CAP_RESUME      0x20   // persisted missions (CMD_RESUME_MISSION)
+#define BOOT_CAP_RECORDER    0x40
+
+// periph: live peripheral status
+#define BOOT_PERIPH_NFC      0x01   // PN532 answered
+#define BOOT_PERIPH_TOF      0x02   // VL53L0X running
+#define BOOT_PERIPH_SETTLED  0x80   // bring-up finished (up or boot retries used)
+
+// ── CMD_TELEMETRY payload – keep identical on both MCUs ─────────────
+#define TELEM_FLAG_ESTOP     0x01
+#define TELEM_FLAG_MISSION   0x02
+#define TELEM_FLAG_VEL_STALE 0x04
+#define TELEM_FLAG_NFC_OK    0x08
+#define TELEM_FLAG_TOF_OK    0x10
+
+struct __attribute__((packed)) TelemetryFrame {
+    uint16_t seq;
+    uint32_t tMs;          // STM32 millis()
+    uint8_t  lineBits;     // bit0 L, bit1 C, bit2 R
+    int8_t   lineErr;      // error × 100
+    int16_t  pidP;         // PID terms × 10
+    int16_t  pidI;
+    int16_t  pidD;
+    int16_t  wheel[4];     // FL, FR, BL, BR  (-255 … 255)
+    uint16_t tofMm;
+    uint8_t  mode;
+    uint8_t  runState;
+    uint8_t  routeIdx;
+    uint8_t  routeLen;
+    uint16_t lastNfc;
+    uint16_t loopUs;       // last main-loop period
+    uint16_t loopMaxUs;    // worst period since previous frame
+    uint8_t  flags;        // TELEM_FLAG_*
+};
+
+// ── Register map (CMD_REG_READ / CMD_REG_WRITE) – keep identical ────
+//  8-bit address → 16-bit value, big-endian on the wire.  Bump
+//  REGMAP_VERSION when a register changes meaning; new registers only
+//  need a free address.  Unmapped addresses read back as 0xFFFF.
+#define REGMAP_VERSION       1
+#define REG_BATCH_MAX        32     // registers per frame
+
+// 0x00–0x1F  status (read-only)
+#define REG_VERSION          0x00
+#define REG_UPTIME_S_LO      0x01
+#define REG_UPTIME_S_HI      0x02
+#define REG_MODE             0x03
+#define REG_RUN_STATE        0x04
+#define REG_ROUTE_IDX        0x05
+#define REG_ROUTE_LEN        0x06
+#define REG_LAST_NFC         0x07
+#define REG_TOF_MM           0x08
+#define REG_LINE_BITS        0x09
+#define REG_LINE_ERR         0x0A   // int16, error × 100
+#define REG_FLAGS            0x0B   // TELEM_FLAG_*
+#define REG_LOOP_US          0x0C
+#define REG_LOOP_PEAK_US     0x0D   // worst since boot / counter clear
+#define REG_RESUMABLE        0x0E
+#define REG_WHEEL_FL         0x0F   // int16 × 4: FL, FR, BL, BR
+#define REG_WHEEL_BR         0x12
+#define REG_CAPS             0x13   // BOOT_CAP_*
+#define REG_PERIPH           0x14   // BOOT_PERIPH_*
+#define REG_STATUS_LAST      0x14
+
+// 0x20–0x3F  event counters (read-only, wrap at 65535)
+#define REG_CNT_BASE         0x20
+#define REG_CNT_UART_RX      0x20   // valid frames from ESP32
+#define REG_CNT_UART_DROP    0x21   // frames dropped, RX queue full
+#define REG_CNT_NFC_READ     0x22
+#define REG_CNT_CHECKPOINT   0x23
+#define REG_CNT_SKIPPED      0x24
+#define REG_CNT_MISMATCH     0x25
+#define REG_CNT_LINE_SEARCH  0x26
+#define REG_CNT_LINE_LOST    0x27
+#define REG_CNT_OBSTACLE     0x28
+#define REG_CNT_VEL_TIMEOUT  0x29
+#define REG_CNT_ESTOP        0x2A
+#define REG_CNT_MISSION_DONE 0x2B
+#define REG_CNT_LAST         0x2B
+
+// 0x40–0x7F  control / tunables (read-write)
+#define REG_CTRL             0x40   // write REG_CTRL_* (reads 0)
+#define REG_TELEM_HZ         0x41   // same as CMD_TELEM_SUBSCRIBE
+#define REG_PARAM_COUNT      0x42   // read-only: parameters implemented
+#define REG_PARAM_DIRTY      0x43   // read-only: 1 = RAM differs from flash
+
+#define REG_CTRL_CLEAR_CNT      0x0001
+#define REG_CTRL_SAVE_PARAMS    0x0002   // persist parameters to flash (once stopped)
+#define REG_CTRL_PARAM_DEFAULTS 0x0004   // reset parameters to firmware defaults
+
+// 0x50–0x5F  runtime parameters (read-write, bounds-checked on STM32)
+#define REG_PARAM_BASE       0x50
+#define REG_P_RUN_SPEED      0x50   // PWM 0-255
+#define REG_P_TURN_SPEED     0x51
+#define REG_P_TURN_90_MS     0x52
+#define REG_P_TURN_180_MS    0x53
+#define REG_P_BRAKE_PWM      0x54
+#define REG_P_BRAKE_MS       0x55
+#define REG_P_LF_KP          0x56   // gain × 1000
+#define REG_P_LF_KI          0x57   // gain × 1000
+#define REG_P_LF_KD          0x58   // gain × 1000
+#define REG_P_LF_MAX_CORR    0x59
+#define REG_P_TOF_STOP_MM    0x5A
+#define REG_P_TOF_RESUME_MM  0x5B
+#define REG_P_NFC_READ_MS    0x5C
+#define REG_P_NFC_GUARD_MS   0x5D
+#define REG_PARAM_LAST       0x5D
+
+// REG_P_* bounds { lo, hi }, in address order: the STM32 rejects writes
+// outside them, the ESP32 rejects dashboard values before staging them
+#define REG_P_BOUNDS {                          \
+    {  60,  255 },   /* REG_P_RUN_SPEED     */  \
+    {  60,  255 },   /* REG_P_TURN_SPEED    */  \
+    { 200, 3000 },   /* REG_P_TURN_90_MS    */  \
+    { 400, 6000 },   /* REG_P_TURN_180_MS   */  \
+    {   0,  255 },   /* REG_P_BRAKE_PWM     */  \
+    {   0,  500 },   /* REG_P_BRAKE_MS      */  \
+    {   0, 5000 },   /* REG_P_LF_KP         */  \
+    {   0, 1000 },   /* REG_P_LF_KI         */  \
+    {   0, 5000 },   /* REG_P_LF_KD         */  \
+    {   0,  255 },   /* REG_P_LF_MAX_CORR   */  \
+    {  50, 1000 },   /* REG_P_TOF_STOP_MM   */  \
+    {  60, 1500 },   /* REG_P_TOF_RESUME_MM */  \
+    {  20, 1000 },   /* REG_P_NFC_READ_MS   */  \
+    { 100, 5000 },   /* REG_P_NFC_GUARD_MS  */  \
+}
+
+// REG_P_* pairs { a, b } that must keep a < b: ToF stop below resume
+// (else the obstacle hysteresis chatters), 90° turn shorter than 180°
+#define REG_P_ORDERED {                             \
+    { REG_P_TURN_90_MS,  REG_P_TURN_180_MS   },     \
+    { REG_P_TOF_STOP_MM, REG_P_TOF_RESUME_MM },     \
+}
+
+// 0x60–0x6F  log level per module (read-write, 0 = off … 4 = debug)
+#define REG_LOG_LEVEL_BASE   0x60
+#define REG_LOG_LEVEL_LAST   0x6F
+
+// ── CMD_PROF_DATA payload – keep identical on both MCUs ─────────────
+//  One frame per probe.  Histogram buckets grow ×4: <4 µs, <16, <64,
+//  <256, <1024, <4096, <16384, ≥16384 µs (saturating counts).
+#define PROF_BUCKETS         8
+
+#define PROF_HANDLE_ESP32    0      // handleESP32()
+#define PROF_LINE_FOLLOW     1      // lineFollowStep()
+#define PROF_NFC_READ        2      // nfcReadCheckpoint() – actual reads only
+#define PROF_TOF_READ        3      // tofReadMm() – actual reads only
+#define PROF_DEBUG_PRINT     4      // periodic Serial.printf debug output
+#define PROF_LOOP            5      // one loop() pass, idle delay excluded
+#define PROF_COUNT           6
+
+struct __attribute__((packed)) ProfRecord {
+    uint8_t  probe;        // PROF_*
+    uint8_t  probes;       // probes compiled in, 0 = profiler disabled
+    uint8_t  cpuMhz;       // cycles → µs
+    uint32_t count;
+    uint32_t minCyc;
+    uint32_t maxCyc;
+    uint32_t meanCyc;
+    uint16_t hist[PROF_BUCKETS];
+};
+
+// ── Flight recorder (CMD_REC_*) – keep identical on both MCUs ───────
+#define REC_CHUNK_SAMPLES    8      // RecSample per CMD_REC_CHUNK
+#define REC_DUMP_REARM       0xFF   // CMD_REC_DUMP arg: clear + resume recording
+#define REC_DUMP_FREEZE      0xFE   // CMD_REC_DUMP arg: freeze now (REC_TRIG_MANUAL)
+
+// freeze reasons
+#define REC_TRIG_MISMATCH    1
+#define REC_TRIG_LINE_LOST   2
+#define REC_TRIG_OBSTACLE    3
+#define REC_TRIG_CANCEL      4
+#define REC_TRIG_MANUAL      5
+
+// per-sample event (0 = periodic sample); triggers log as 0x10 | reason
+#define REC_EV_NFC           1      // arg = tag id
+#define REC_EV_CHECKPOINT    2      // arg = tag id
+#define REC_EV_SKIPPED       3      // arg = count
+#define REC_EV_LINE_SEARCH   4
+#define REC_EV_TURN          5      // arg = action char
+#define REC_EV_MISSION       6      // arg = route length
+#define REC_EV_ESTOP         7
+#define REC_EV_TRIGGER       0x10
+
+struct __attribute__((packed)) RecSample {
+    uint16_t tMs;          // millis() low 16 bits
+    uint8_t  lineState;    // bit0-2 line L/C/R, bit3-7 run state
+    int8_t   lineErr;      // error × 100
+    int8_t   wheel[4];     // FL, FR, BL, BR  (PWM / 2)
+    uint8_t  tof4mm;       // ToF mm / 4, 255 = ≥ 1020 mm / no reading
+    uint8_t  event;        // REC_EV_*
+    uint16_t arg;
+};
+
+// ── CMD_RUN_KPI payload – keep identical on both MCUs ───────────────
+//  One frame per route run (outbound, return, re-route after mismatch),
+//  sent before CMD_MISSION_DONE.  Time not in any bucket (e-stop hold,
+//  link stalls) is runMs minus the buckets.
+#define KPI_END_DONE         0
+#define KPI_END_MISMATCH     1
+#define KPI_END_CANCEL       2
+
+#define KPI_FLAG_RESUMED     0x01   // run continued after an STM32 reset (partial)
+
+struct __attribute__((packed)) RunKpi {
+    uint8_t  end;          // KPI_END_*
+    uint8_t  flags;        // KPI_FLAG_*
+    uint32_t runMs;
+    uint32_t followMs;     // line following
+    uint32_t turnMs;       // timed turns incl. the 180° at the destination
+    uint32_t obstacleMs;   // stopped by ToF
+    uint32_t lineLostMs;   // searching + holding without line
+    uint16_t lineLost;     // line searches started
+    uint16_t obstacles;    // obstacle stops
+    uint16_t nfcReads;     // PN532 polls
+    uint16_t nfcHits;      // tags read
+    uint8_t  checkpoints;
+    uint8_t  skipped;      // route points passed without a read
+};
+
+// CMD_REG_WACK status
+#define REG_OK               0
+#define REG_ERR_READONLY     1
+#define REG_ERR_ADDR         2
+#define REG_ERR_RANGE        3
 
 uint8_t crc8(const uint8_t *data, uint8_t len);
 
@@ -27,3 +300,12 @@ void uartSendFrame(HardwareSerial &port, uint8_t cmd,
 
 bool uartReceiveFrame(HardwareSerial &port,
                       uint8_t &cmd, uint8_t *buf, uint8_t &len);
+
+// Priority command: its handler runs the moment the frame is decoded,
+// ahead of any frames still queued (used for CMD_ESTOP).
+typedef void (*UartPriorityHandler)(uint8_t cmd, const uint8_t *data, uint8_t len);
+void uartSetPriorityHandler(uint8_t cmd, UartPriorityHandler fn);
+
+// Decode pending bytes into the RX queue without consuming frames.
+// Safe to call from blocking waits so priority commands still land.
+void uartPump(HardwareSerial &port);
@@ -0,0 +1,94 @@
+#include "vel_control.h"
+#include "config.h"
+#include "mecanum.h"
+#include "uart_protocol.h"
+#include "regmap.h"
+#include "tlog.h"
+
+extern HardwareSerial Serial2;   // UART to ESP32
+
+// ── setpoint state ──────────────────────────────────────────────────
+static float    s_from[3]   = { 0, 0, 0 };   // output when setpoint arrived
+static float    s_to[3]     = { 0, 0, 0 };   // latest setpoint
+static float    s_out[3]    = { 0, 0, 0 };   // currently applied
+static uint32_t s_rxMs      = 0;             // arrival time of latest setpoint
+static uint32_t s_periodMs  = VEL_INTERP_MAX_MS;
+static bool     s_haveCmd   = false;
+static bool     s_stale     = false;
+static uint32_t s_lastStep  = 0;
+
+void velCmdReset() {
+    for (uint8_t i = 0; i < 3; i++) s_from[i] = s_to[i] = s_out[i] = 0.0f;
+    s_periodMs = VEL_INTERP_MAX_MS;
+    s_haveCmd  = false;
+    s_stale    = false;
+    s_lastStep = millis();
+    mecanumDrive(0, 0, 0);
+}
+
+void velCmdSet(int16_t vx, int16_t vy, int16_t vr) {
+    uint32_t now = millis();
+
+    // track the ESP32 command period (EMA) → interpolation window
+    if (s_haveCmd && !s_stale) {
+        uint32_t dt = now - s_rxMs;
+        dt = constrain(dt, (uint32_t)VEL_INTERP_MIN_MS, (uint32_t)VEL_INTERP_MAX_MS);
+        s_periodMs = (s_periodMs * 3 + dt) / 4;
+    }
+
+    for (uint8_t i = 0; i < 3; i++) s_from[i] = s_out[i];
+    s_to[0] = vx;
+    s_to[1] = vy;
+    s_to[2] = vr;
+    s_rxMs    = now;
+    s_haveCmd = true;
+
+    if (s_stale) {
+        s_stale = false;
+        LOGI(LM_VEL, "setpoints resumed");
+    }
+}
+
+bool velCmdStale() { return s_stale; }
+
+void velCmdStep() {
+    uint32_t now = millis();
+    uint32_t dt  = now - s_lastStep;
+    if (dt == 0) return;
+    s_lastStep = now;
+
+    if (!s_haveCmd) return;
+
+    uint32_t age = now - s_rxMs;
+    bool moving = false;
+    for (uint8_t i = 0; i < 3; i++)
+        if (s_to[i] != 0.0f || s_out[i] != 0.0f) moving = true;
+
+    // ── staleness failsafe: ramp to zero at VEL_STOP_SLEW ────────────
+    // A quiet link after a zero setpoint is an ordinary stop, not a
+    // timeout: only a setpoint still asking for (or output still at)
+    // motion goes stale.
+    if (age >= VEL_STALE_MS && (moving || s_stale)) {
+        if (!s_stale) {
+            s_stale = true;
+            uint16_t a = (uint16_t)min(age, (uint32_t)0xFFFF);
+            uint8_t buf[2] = { (uint8_t)(a >> 8), (uint8_t)(a & 0xFF) };
+            uartSendFrame(Serial2, CMD_VEL_TIMEOUT, buf, 2);
+            regCount(REG_CNT_VEL_TIMEOUT);
+            LOGW(LM_VEL, "no setpoint for %u ms → stopping", a);
+        }
+        float step = (float)VEL_STOP_SLEW * dt;
+        for (uint8_t i = 0; i < 3; i++) {
+            if (s_out[i] > step)       s_out[i] -= step;
+            else if (s_out[i] < -step) s_out[i] += step;
+            else                       s_out[i] = 0.0f;
+        }
+    } else {
+        // ── linear interpolation over the measured command period ────
+        float t = (age >= s_periodMs) ? 1.0f : (float)age / s_periodMs;
+        for (uint8_t i = 0; i < 3; i++)
+            s_out[i] = s_from[i] + (s_to[i] - s_from[i]) * t;
+    }
+
+    mecanumDrive((int)s_out[0], (int)s_out[1], (int)s_out[2]);
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+
+// ── Direct velocity control (Follow / Find / Recovery) ──────────────
+// CMD_DIRECT_VEL setpoints are timestamped on arrival and interpolated
+// over the measured command period, so 20 Hz steps become smooth ramps.
+// If no setpoint arrives for VEL_STALE_MS the output decelerates to zero
+// and CMD_VEL_TIMEOUT is reported once.
+
+void velCmdReset();                          // zero output + target (mode change)
+void velCmdSet(int16_t vx, int16_t vy, int16_t vr);   // from UART handler
+void velCmdStep();                           // call every loop in direct-vel modes
+bool velCmdStale();                          // true while in timeout
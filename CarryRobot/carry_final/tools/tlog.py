@@ -0,0 +1,270 @@
+#!/usr/bin/env python3
+"""Host side of the tokenized logger (esp32_master/src/tlog.h).
+
+  tlog.py db      [-o tlog_db.json]        scan both firmware trees
+  tlog.py decode  [-d tlog_db.json] [FILE | --port /dev/ttyUSB0]
+
+The ESP32 USB serial carries CMD_LOG frames
+  [0x7E][LEN][0x93][dropped][record…][CRC8]
+mixed with plain text (boot banner, WiFiManager).  Text is passed
+through, frames are decoded:
+  record = [len][token u32][src<<7 | module<<3 | level][t ms u32][args]
+"""
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+TREES = {0: "esp32_master/src", 1: "stm32_slave/src"}
+SOURCES = {0: "ESP32", 1: "STM32"}
+LEVELS = {1: "E", 2: "W", 3: "I", 4: "D"}
+
+STX = 0x7E
+CMD_LOG = 0x93
+
+LOG_CALL = re.compile(r'LOG[EWID]\(\s*(LM_\w+)\s*,\s*"((?:[^"\\]|\\.)*)"')
+ENUM = re.compile(r'enum\s+LogModule\s*:\s*uint8_t\s*\{(.*?)\};', re.S)
+SPEC = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|z|j|t)?([diuxXcfeEgGs%])')
+
+
+def fnv1a(data: bytes) -> int:
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def c_unescape(s: str) -> bytes:
+    """C string literal body → the bytes the compiler hashes."""
+    out = bytearray()
+    raw = s.encode("utf-8")
+    i = 0
+    simple = {ord("n"): 10, ord("t"): 9, ord("r"): 13, ord("0"): 0,
+              ord("\\"): 92, ord('"'): 34, ord("'"): 39}
+    while i < len(raw):
+        c = raw[i]
+        if c == 0x5C and i + 1 < len(raw):
+            n = raw[i + 1]
+            if n == ord("x"):
+                j = i + 2
+                while j < len(raw) and chr(raw[j]) in "0123456789abcdefABCDEF":
+                    j += 1
+                out.append(int(raw[i + 2:j], 16) & 0xFF)
+                i = j
+                continue
+            out.append(simple.get(n, n))
+            i += 2
+            continue
+        out.append(c)
+        i += 1
+    return bytes(out)
+
+
+# ── database ────────────────────────────────────────────────────────
+def build_db(root: str) -> dict:
+    db = {"modules": {}, "tokens": {}}
+    collisions = []
+    for src, rel in TREES.items():
+        tree = os.path.join(root, rel)
+        with open(os.path.join(tree, "tlog.h"), encoding="utf-8") as f:
+            m = ENUM.search(f.read())
+        names = [n.strip() for n in m.group(1).split(",") if n.strip()]
+        db["modules"][str(src)] = [n[3:] for n in names if n != "LM_COUNT"]
+
+        for name in sorted(os.listdir(tree)):
+            if not name.endswith((".cpp", ".h")):
+                continue
+            with open(os.path.join(tree, name), encoding="utf-8") as f:
+                text = f.read()
+            for m in LOG_CALL.finditer(text):
+                fmt = c_unescape(m.group(2))
+                key = "%d:%08x" % (src, fnv1a(fmt))
+                line = text.count("\n", 0, m.start()) + 1
+                entry = {"fmt": fmt.decode("utf-8", "replace"),
+                         "file": "%s:%d" % (name, line)}
+                old = db["tokens"].get(key)
+                if old and old["fmt"] != entry["fmt"]:
+                    collisions.append((key, old, entry))
+                db["tokens"].setdefault(key, entry)
+    return db, collisions
+
+
+# ── argument decoding ───────────────────────────────────────────────
+def format_record(fmt: str, args: bytes) -> str:
+    pos = 0
+    out = []
+    last = 0
+
+    def take_u32():
+        nonlocal pos
+        if pos + 4 > len(args):
+            raise ValueError("short")
+        v = struct.unpack_from("<I", args, pos)[0]
+        pos += 4
+        return v
+
+    try:
+        for m in SPEC.finditer(fmt):
+            out.append(fmt[last:m.start()])
+            last = m.end()
+            flags, width, prec, _length, conv = m.groups()
+            if conv == "%":
+                out.append("%")
+                continue
+            if width == "*":
+                width = str(struct.unpack("<i", struct.pack("<I", take_u32()))[0])
+            if prec == "*":
+                prec = str(take_u32())
+            spec = "%" + flags + (width or "") + ("." + prec if prec else "")
+            if conv == "s":
+                n = args[pos]
+                s = args[pos + 1:pos + 1 + n].decode("utf-8", "replace")
+                pos += 1 + n
+                out.append((spec + "s") % s)
+            elif conv in "fFeEgG":
+                if pos + 4 > len(args):
+                    raise ValueError("short")
+                v = struct.unpack_from("<f", args, pos)[0]
+                pos += 4
+                out.append((spec + conv) % v)
+            elif conv in "di":
+                v = struct.unpack("<i", struct.pack("<I", take_u32()))[0]
+                out.append((spec + "d") % v)
+            elif conv == "c":
+                out.append((spec + "c") % chr(take_u32() & 0xFF))
+            else:  # u x X
+                out.append((spec + ("d" if conv == "u" else conv)) % take_u32())
+        out.append(fmt[last:])
+    except (ValueError, IndexError):
+        out.append(" <truncated>")
+    return "".join(out)
+
+
+class Decoder:
+    def __init__(self, db: dict, out=sys.stdout):
+        self.db = db
+        self.out = out
+        self.buf = bytearray()
+
+    def records(self, payload: bytes):
+        dropped = payload[0]
+        if dropped:
+            self.out.write("-- %u record(s) dropped%s --\n" %
+                           (dropped, "+" if dropped == 255 else ""))
+        i = 1
+        while i < len(payload):
+            n = payload[i]
+            if n < 10 or i + n > len(payload):
+                self.out.write("-- malformed record --\n")
+                return
+            rec = payload[i:i + n]
+            token, hdr, t = struct.unpack_from("<IBI", rec, 1)
+            src, mod, lvl = hdr >> 7, (hdr >> 3) & 0x0F, hdr & 0x07
+            mods = self.db["modules"].get(str(src), [])
+            mname = mods[mod] if mod < len(mods) else "M%u" % mod
+            entry = self.db["tokens"].get("%d:%08x" % (src, token))
+            if entry:
+                text = format_record(entry["fmt"], rec[10:])
+            else:
+                text = "<unknown token %08x> %s" % (token, rec[10:].hex())
+            self.out.write("%10.3f %s %s [%s] %s\n" % (
+                t / 1000.0, SOURCES.get(src, "?"), LEVELS.get(lvl, "?"),
+                mname, text))
+            i += n
+
+    def feed(self, data: bytes, eof: bool = False):
+        self.buf += data
+        while self.buf:
+            k = self.buf.find(bytes([STX]))
+            if k < 0:
+                self.text(self.buf)
+                self.buf.clear()
+                return
+            if k:
+                self.text(self.buf[:k])
+                del self.buf[:k]
+            if len(self.buf) < 2 and not eof:
+                return
+            ln = self.buf[1] if len(self.buf) > 1 else 0
+            if len(self.buf) < ln + 3:
+                if eof or ln + 3 > 128:  # cannot be a frame
+                    self.text(self.buf[:1])
+                    del self.buf[:1]
+                    continue
+                return
+            body = bytes(self.buf[2:2 + ln])
+            if ln >= 2 and body[0] == CMD_LOG and crc8(body) == self.buf[2 + ln]:
+                self.records(body[1:])
+                del self.buf[:ln + 3]
+            else:
+                self.text(self.buf[:1])
+                del self.buf[:1]
+
+    def text(self, data):
+        self.out.write(bytes(data).decode("utf-8", "replace"))
+        self.out.flush()
+
+
+def crc8(data: bytes) -> int:
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+# ── CLI ─────────────────────────────────────────────────────────────
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("db", help="build the token database")
+    p.add_argument("-o", "--out", default="tlog_db.json")
+    p.add_argument("--root", default=ROOT)
+
+    p = sub.add_parser("decode", help="decode a capture or live port")
+    p.add_argument("file", nargs="?", help="raw capture (default stdin)")
+    p.add_argument("-d", "--db", help="token database (default: scan sources)")
+    p.add_argument("--port", help="read live from a serial port (pyserial)")
+    p.add_argument("--baud", type=int, default=115200)
+
+    a = ap.parse_args()
+
+    if a.cmd == "db":
+        db, collisions = build_db(a.root)
+        for key, old, new in collisions:
+            print("collision %s: %s vs %s" % (key, old["file"], new["file"]),
+                  file=sys.stderr)
+        with open(a.out, "w", encoding="utf-8") as f:
+            json.dump(db, f, indent=1, ensure_ascii=False)
+        print("%d tokens → %s" % (len(db["tokens"]), a.out))
+        return 1 if collisions else 0
+
+    if a.db:
+        with open(a.db, encoding="utf-8") as f:
+            db = json.load(f)
+    else:
+        db, _ = build_db(ROOT)
+    dec = Decoder(db)
+
+    if a.port:
+        import serial
+        with serial.Serial(a.port, a.baud, timeout=0.1) as port:
+            while True:
+                dec.feed(port.read(4096))
+    stream = open(a.file, "rb") if a.file else sys.stdin.buffer
+    while True:
+        chunk = stream.read(4096)
+        if not chunk:
+            break
+        dec.feed(chunk)
+    dec.feed(b"", eof=True)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
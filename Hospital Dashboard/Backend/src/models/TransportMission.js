@@ -1,5 +1,11 @@
 import mongoose from 'mongoose';
 
+// Robot route actions (CMD_SEND_ROUTE action byte on the carry robot):
+// F/L/R/B/S turn the chassis; '<' '>' 'V' are strafe-left, strafe-right
+// and reverse legs without rotating; 'H' stops at the destination
+// without the 180°; 'l'/'r' drive a 90° corner as an arc.
+const ROUTE_ACTIONS = ['F', 'L', 'R', 'B', 'S', '<', '>', 'V', 'H', 'l', 'r'];
+
 const routePointSchema = new mongoose.Schema({
   nodeId: { type: String, required: true },
 
@@ -15,14 +21,18 @@ const routePointSchema = new mongoose.Schema({
 
   action: {
     type: String,
-    enum: ['F', 'L', 'R', 'B'],  // B = 180° U-turn (used by return-route firstAction)
+    enum: ROUTE_ACTIONS,  // B = 180° U-turn (used by return-route firstAction)
     default: 'F'
   },
 
   actions: {
-    type: [{ type: String, enum: ['F', 'L', 'R', 'B'] }],
+    type: [{ type: String, enum: ROUTE_ACTIONS }],
     default: []
-  }
+  },
+
+  // arc corners ('l'/'r'): radius cm and forward PWM, robot defaults if unset
+  arcRadius: { type: Number },
+  arcSpeed: { type: Number }
 }, { _id: false });
 
 const transportMissionSchema = new mongoose.Schema({
@@ -72,6 +82,11 @@ const transportMissionSchema = new mongoose.Schema({
   cancelledAt: { type: Date, default: null },
   cancelledBy: { type: String, default: null },
 
+  // Per-mission KPIs from the robot's mission_done event (times in ms):
+  // { t, run, wait, follow, turn, obst, lost, lostN, obstN, nfcReads, nfcHits,
+  //   cp, skip, mm, runs, resumed, legs: [{ from, to, ms }] }
+  kpi: { type: mongoose.Schema.Types.Mixed, default: null },
+
   lowBatteryAlerted: { type: Boolean, default: false },
   notes: [{ text: { type: String }, timestamp: { type: Date, default: Date.now } }]
 }, { timestamps: true });
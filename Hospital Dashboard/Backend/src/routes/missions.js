@@ -6,7 +6,7 @@ import Robot from '../models/Robot.js';
 import TransportMission from '../models/TransportMission.js';
 import Alert from '../models/Alert.js';
 
-import { publishMissionAssign, publishMissionCancel } from '../services/mqttService.js';
+import { publishMissionAssign, publishMissionCancel, applyArcCorners } from '../services/mqttService.js';
 import { LOW_BATTERY_PCT, ROBOT_ONLINE_TIMEOUT_MS } from '../utils/constants.js';
 
 const router = express.Router();
@@ -343,8 +343,8 @@ router.post('/delivery', async (req, res) => {
     const outActionsMap = computeActionsMap(outNodeIds, ctx, 'out');
     const backActionsMap = computeActionsMap(backNodeIds, ctx, 'return');
 
-    const outboundRoute = toPoints(graph, map, outNodeIds, outActionsMap);
-    const returnRoute = toPoints(graph, map, backNodeIds, backActionsMap);
+    const outboundRoute = applyArcCorners(toPoints(graph, map, outNodeIds, outActionsMap));
+    const returnRoute = applyArcCorners(toPoints(graph, map, backNodeIds, backActionsMap));
 
     const missionId = makeId('TM');
 
@@ -416,10 +416,13 @@ router.get('/carry/next', async (req, res) => {
     const outRaw = (m.outboundRoute && m.outboundRoute.length) ? m.outboundRoute : (m.plannedRoute || []);
     const backRaw = (m.returnRoute && m.returnRoute.length) ? m.returnRoute : (outRaw.slice().reverse());
 
+    // this client only knows F/L/R – arc corners fall back to plain turns
+    const plainTurn = (a) => (a === 'l' ? 'L' : a === 'r' ? 'R' : a);
     const normalizePoint = (p) => {
-      const legacy = (p.action === 'L' || p.action === 'R') ? p.action : 'F';
+      const action = plainTurn(p.action);
+      const legacy = (action === 'L' || action === 'R') ? action : 'F';
       const actions = (Array.isArray(p.actions) && p.actions.length)
-        ? p.actions.filter(x => x === 'F' || x === 'L' || x === 'R')
+        ? p.actions.map(plainTurn).filter(x => x === 'F' || x === 'L' || x === 'R')
         : (legacy === 'L' || legacy === 'R') ? [legacy, 'F'] : ['F'];
 
       return {
@@ -1,7 +1,7 @@
 import express from 'express';
 import Robot from '../models/Robot.js';
 import TransportMission from '../models/TransportMission.js';
-import { publishCommand, publishCarryStackJson, STACK_ROBOT_ID } from '../services/mqttService.js';
+import { publishCommand, publishCarryStackJson, getFlightRecord, STACK_ROBOT_ID } from '../services/mqttService.js';
 import { ROUTE_TEST_MED_TO_R4M3 } from '../utils/checkpointIds.js';
 import { LOW_BATTERY_PCT, ROBOT_ONLINE_TIMEOUT_MS } from '../utils/constants.js';
 
@@ -178,6 +178,52 @@ router.get('/carry/status', async (_req, res) => {
   }
 });
 
+/**
+ * GET /api/robots/kpi/corridors?days=7
+ * Checkpoint-to-checkpoint legs from mission KPIs across the fleet,
+ * slowest total first, plus where mission time went overall.
+ */
+router.get('/kpi/corridors', async (req, res) => {
+  try {
+    const days = Math.max(1, Math.min(90, Number(req.query.days) || 7));
+    const since = new Date(Date.now() - days * 24 * 3600 * 1000);
+    const missions = await TransportMission.find(
+      { kpi: { $ne: null }, updatedAt: { $gte: since } },
+      { kpi: 1, carryRobotId: 1 }
+    ).lean();
+
+    const corridors = new Map();
+    const totals = { missions: missions.length, t: 0, follow: 0, turn: 0, obst: 0, lost: 0, wait: 0 };
+    for (const { kpi } of missions) {
+      for (const key of ['t', 'follow', 'turn', 'obst', 'lost', 'wait']) totals[key] += kpi[key] || 0;
+      for (const leg of kpi.legs || []) {
+        const id = `${leg.from}→${leg.to}`;
+        const c = corridors.get(id) || { from: leg.from, to: leg.to, n: 0, totalMs: 0, maxMs: 0 };
+        c.n += 1;
+        c.totalMs += leg.ms;
+        c.maxMs = Math.max(c.maxMs, leg.ms);
+        corridors.set(id, c);
+      }
+    }
+    const list = [...corridors.values()]
+      .map(c => ({ ...c, meanMs: Math.round(c.totalMs / c.n) }))
+      .sort((a, b) => b.totalMs - a.totalMs);
+    res.json({ days, totals, corridors: list });
+  } catch (e) {
+    res.status(500).json({ error: e?.message || 'Server error' });
+  }
+});
+
+/**
+ * GET /api/robots/:id/flight-record
+ * Last STM32 flight-recorder capture downloaded over MQTT (rec_dump).
+ */
+router.get('/:id/flight-record', (req, res) => {
+  const rec = getFlightRecord(req.params.id);
+  if (!rec) return res.status(404).json({ error: 'No flight record' });
+  res.json(rec);
+});
+
 /**
  * POST /api/robots/:id/command
  * Gửi lệnh MQTT tới robot.
@@ -270,7 +316,16 @@ router.post('/:id/command', async (req, res) => {
       'stop',
       'resume',
       'tune_turn',
+      'tune_params',
+      'tune_get',
+      'tune_reset',
+      'prof_dump',
+      'rec_dump',
       'test_dashboard',
+      'reg_read',
+      'reg_write',
+      'log_level',
+      'follow_tag',
     ];
     if (!ALLOWED_COMMANDS.includes(command)) {
       return res.status(400).json({ error: `Unknown command: ${command}` });
@@ -285,6 +340,8 @@ router.post('/:id/command', async (req, res) => {
       const stackPayload = { action: command };
       if (mode) stackPayload.mode = mode;
       Object.assign(stackPayload, rest);
+      // click timestamp → echoed back in estop_ack for latency measurement
+      if (command === 'stop' && stackPayload.ts == null) stackPayload.ts = Date.now();
       const sent = publishCarryStackJson(stackPayload);
       if (!sent) {
         return res.status(503).json({ error: 'MQTT broker not connected' });
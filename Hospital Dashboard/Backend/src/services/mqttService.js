@@ -3,7 +3,7 @@ import Robot from '../models/Robot.js';
 import TransportMission from '../models/TransportMission.js';
 import MapGraph from '../models/MapGraph.js';
 import Alert from '../models/Alert.js';
-import { LOW_BATTERY_PCT, DEFAULT_MAP_ID } from '../utils/constants.js';
+import { LOW_BATTERY_PCT, DEFAULT_MAP_ID, ARC_CORNERS } from '../utils/constants.js';
 import {
   ROUTE_TEST_MED_TO_R4M3,
   checkpointIdToName,
@@ -36,6 +36,36 @@ export const STACK_ROBOT_ID = process.env.MQTT_STACK_ROBOT_ID || 'carry-stack-1'
 
 const lastStackCpByRobot = new Map();
 
+/** mission_done kpi → stored form: checkpoint ids as node names, legs as objects */
+function normalizeMissionKpi(k) {
+  const node = (id) => checkpointIdToName(id) || `CP${id}`;
+  const { nfc = [0, 0], legs = [], ...rest } = k;
+  return {
+    ...rest,
+    nfcReads: nfc[0] ?? 0,
+    nfcHits: nfc[1] ?? 0,
+    legs: legs.map(([from, to, ms]) => ({ from: node(from), to: node(to), ms })),
+  };
+}
+
+function missionKpiSummary(k) {
+  const pct = (v) => (k.run > 0 ? Math.round((100 * v) / k.run) : 0);
+  const slowest = k.legs.reduce((a, b) => (b.ms > (a?.ms ?? -1) ? b : a), null);
+  return `${Math.round(k.t / 1000)} s (follow ${pct(k.follow)}%, turn ${pct(k.turn)}%, ` +
+    `obstacle ${pct(k.obst)}%, line lost ${pct(k.lost)}%, wait ${Math.round(k.wait / 1000)} s)` +
+    (slowest ? ` slowest ${slowest.from}→${slowest.to} ${(slowest.ms / 1000).toFixed(1)} s` : '');
+}
+
+/** STM32 flight-recorder captures: in-progress download + last complete one */
+const REC_TRIGGER_NAMES = { 1: 'mismatch', 2: 'line_lost', 3: 'obstacle', 4: 'cancel', 5: 'manual' };
+const REC_SAMPLE_FIELDS = ['tMs', 'lineBits', 'runState', 'err', 'fl', 'fr', 'bl', 'br', 'tofMm', 'ev', 'arg'];
+const pendingFlightRecord = new Map();
+const lastFlightRecord = new Map();
+
+export function getFlightRecord(robotId) {
+  return lastFlightRecord.get(robotId) || null;
+}
+
 let client = null;
 let connected = false;
 const legacyFieldWarned = new Set();
@@ -149,6 +179,18 @@ async function handleCarryStackTopic(topic, message) {
     }
 
     const evt = payload.evt;
+
+    // flight-recorder chunks: assemble quietly, no per-chunk log line
+    if (evt === 'rec_chunk' && Array.isArray(payload.s)) {
+      const rec = pendingFlightRecord.get(robotId);
+      if (rec) {
+        for (const row of payload.s) {
+          rec.samples.push(Object.fromEntries(REC_SAMPLE_FIELDS.map((k, i) => [k, row[i]])));
+        }
+      }
+      return;
+    }
+
     let currentNodeId = null;
     let cpRaw = null;
     let batteryLevel = null;
@@ -170,6 +212,13 @@ async function handleCarryStackTopic(topic, message) {
     } else if (evt === 'mission_done') {
       status = 'idle';
       stackLogLine = 'mission_done';
+      if (payload.kpi && typeof payload.kpi === 'object') {
+        const kpi = normalizeMissionKpi(payload.kpi);
+        stackLogLine = `mission_done ${missionKpiSummary(kpi)}`;
+        if (payload.mission) {
+          await TransportMission.updateOne({ missionId: payload.mission }, { $set: { kpi } });
+        }
+      }
     } else if (evt === 'battery' && typeof payload.pct === 'number') {
       batteryLevel = payload.pct;
       stackLogLine = `battery ${batteryLevel}%`;
@@ -186,11 +235,37 @@ async function handleCarryStackTopic(topic, message) {
       stackLogLine = 'line_lost';
     } else if (evt === 'obstacle') {
       stackLogLine = 'obstacle (ToF)';
+    } else if (evt === 'cp_skipped' && typeof payload.id === 'number') {
+      stackLogLine = `cp_skipped ${checkpointIdToName(payload.id) || payload.id} (missed NFC read)`;
     } else if (evt === 'cp_mismatch') {
       stackLogLine = `cp_mismatch recv=${payload.recv ?? payload.received} exp=${payload.exp ?? payload.expected}`;
     } else if (evt === 'recovery_nfc') {
       currentNodeId = checkpointIdToName(payload.id) || `CP${payload.id}`;
       stackLogLine = `recovery_nfc ${currentNodeId}`;
+    } else if (evt === 'estop_ack') {
+      const clickToAck = typeof payload.ts === 'number' && payload.ts > 0 ? ts - payload.ts : null;
+      stackLogLine = `estop_ack rtt=${payload.rttUs}us cut=${payload.cutUs}us` +
+        (clickToAck != null ? ` click→ack=${clickToAck}ms` : '');
+    } else if (evt === 'regs' && Array.isArray(payload.vals)) {
+      const start = Number(payload.start) || 0;
+      stackLogLine = `regs v${payload.v} 0x${start.toString(16).padStart(2, '0')}: ${payload.vals.join(' ')}`;
+    } else if (evt === 'params' && payload.p && typeof payload.p === 'object') {
+      stackLogLine = `params ${Object.entries(payload.p).map(([k, v]) => `${k}=${v}`).join(' ')}`;
+    } else if (evt === 'prof') {
+      stackLogLine = `prof ${payload.probe} n=${payload.n} min=${payload.minUs}us mean=${payload.meanUs}us max=${payload.maxUs}us`;
+    } else if (evt === 'stm32_ready') {
+      const nfc = payload.periph & 0x01 ? 'ok' : 'missing';
+      const tof = payload.caps & 0x02 ? (payload.periph & 0x02 ? 'ok' : 'missing') : 'off';
+      stackLogLine = `stm32_ready after ${payload.ms} ms – nfc ${nfc}, tof ${tof}`;
+    } else if (evt === 'rec_frozen') {
+      const reason = REC_TRIGGER_NAMES[payload.reason] || payload.reason;
+      pendingFlightRecord.set(robotId, { reason, arg: payload.arg, frozenAt: ts, samples: [] });
+      stackLogLine = `rec_frozen ${reason} (${payload.samples} samples) – downloading`;
+    } else if (evt === 'rec_done' || evt === 'rec_failed') {
+      const rec = pendingFlightRecord.get(robotId);
+      pendingFlightRecord.delete(robotId);
+      if (rec && evt === 'rec_done') lastFlightRecord.set(robotId, rec);
+      stackLogLine = `${evt}${rec ? ` ${rec.reason} ${rec.samples.length} samples` : ''}`;
     } else if (evt === 'relay_ack') {
       stackLogLine = `relay ${payload.which} → ${payload.on ? 'ON' : 'OFF'}`;
     } else if (evt === 'relay_resume') {
@@ -588,6 +663,19 @@ function getRelativeTurn(heading, required) {
   return 'F';
 }
 
+// 'L'/'R' at an ARC_CORNERS node → arc action with its radius / speed
+export function applyArcCorners(routePoints) {
+  for (const p of routePoints || []) {
+    const arc = ARC_CORNERS[p.nodeId];
+    if (!arc || (p.action !== 'L' && p.action !== 'R')) continue;
+    p.action = p.action === 'L' ? 'l' : 'r';
+    p.actions = (p.actions || []).map(a => (a === 'L' ? 'l' : a === 'R' ? 'r' : a));
+    p.arcRadius = arc.radius;
+    p.arcSpeed = arc.speed;
+  }
+  return routePoints;
+}
+
 async function handleWaitingReturnRoute(robotId, payload) {
   try {
     const { missionId } = payload;
@@ -705,7 +793,7 @@ async function calculateReturnRouteFromNode(mapId, fromNodeId, previousNodeId =
       console.log(`[MQTT] No previousNodeId at ${fromNodeId} – defaulting firstAction=B (outbound U-turn)`);
     }
 
-    return routePoints;
+    return applyArcCorners(routePoints);
   } catch (err) {
     console.error('[MQTT] calculateReturnRouteFromNode error:', err.message);
     return null;
@@ -9,3 +9,15 @@ export const ROBOT_ONLINE_TIMEOUT_MS = 30000;
 
 /** Default map ID used when resolving routes without an explicit mission */
 export const DEFAULT_MAP_ID = 'floor1';
+
+/**
+ * Junction corners the carry robot drives as arcs instead of stop–rotate–go.
+ * An 'L'/'R' at these nodes is sent as 'l'/'r' with the radius (cm) and
+ * forward speed (PWM 0–255).  Off until validated on the track:
+ * CARRY_ARC_CORNERS=1 turns it on.
+ */
+export const ARC_CORNERS = process.env.CARRY_ARC_CORNERS !== '1' ? {} : {
+  H_MED: { radius: 25, speed: 140 },
+  H_BOT: { radius: 25, speed: 140 },
+  H_TOP: { radius: 25, speed: 140 }
+};
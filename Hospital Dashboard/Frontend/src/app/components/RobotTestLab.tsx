@@ -473,7 +473,7 @@ export function RobotTestLab() {
                   type="button"
                   variant="outline"
                   disabled={pending}
-                  onClick={() => runCmd('stop', { command: 'stop' })}
+                  onClick={() => runCmd('stop', { command: 'stop', ts: Date.now() })}
                 >
                   stop
                 </Button>